@@ -1,11 +1,31 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netdb.h>
 #include <unistd.h>
 #include <string.h>
+#include <strings.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/un.h>
+#include <sys/signalfd.h>
 #include <gmp.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 #define STACK_SIZE 1000
 #define DICT_SIZE 100
@@ -15,9 +35,65 @@
 #define VAR_SIZE 100
 #define MAX_STRING_SIZE 256
 #define MPZ_POOL_SIZE 3
+#define BULK_SLICE (1L << 40)       // Opérande d'un mot de tableau précédé de SLICE (MAP, REDUCE : bits bas = nom)
+#define GMP_SIZE_CLASSES 8          // Blocs de 16 à 2048 octets
+#define GMP_SMALL_MAX 2048          // Au-delà : malloc direct
+#define GMP_ARENA_CHUNK (64 * 1024)
+#define GMP_SCRATCH_LIMBS 512       // Opérandes d'au moins 32 Ko : travail de GMP dans l'arène de commande
+#define GMP_SCRATCH_REGION (256 * 1024)
+#define GMP_SCRATCH_KEEP (4 * 1024 * 1024) // Au-delà, l'arène est rendue en fin de commande
+#define DEFAULT_MAX_RESULT_BITS (8UL * 1024 * 1024)     // 1 Mo par nombre
+#define DEFAULT_MAX_LIVE_BYTES (64UL * 1024 * 1024)     // Croissance GMP par commande
+#define MAX_USER_QUOTAS 32
+#define SLICE_INSTRUCTIONS 1000                         // Instructions entre deux lectures de l'horloge
+#define DEFAULT_MAX_INSTRUCTIONS 100000000UL
+#define DEFAULT_MAX_MILLISECONDS 10000UL
+#define DEFAULT_MAX_CALL_DEPTH 1000UL                   // Appels imbriqués : environ 1 Ko de pile C chacun
+#define MAX_QUEUED_COMMANDS 256                         // Toutes sessions confondues
+#define OUTPUT_QUEUE_SIZE 256                           // Puissance de deux
+#define IRC_LINE_MAX (8191 + 512)                       // Tags IRCv3 compris
+#define IRC_RECV_SIZE 16384                             // Anneau de réception, puissance de deux
+#define IRC_MAX_PARAMS 15
+#define OUTPUT_CHUNK 400                                // Caractères de texte par ligne PRIVMSG
+#define OUTPUT_BATCH_MAX 16384                          // Au-delà, le lot part sans attendre la fin de la commande
+#define OUTPUT_BATCH_MILLISECONDS 200                   // ... de même s'il attend depuis plus longtemps
+#define OUTPUT_WRITEV_MAX 64
+#define DEFAULT_FLOOD_BURST 5                           // Comme la plupart des serveurs : 5 lignes d'avance...
+#define DEFAULT_FLOOD_INTERVAL_MS 2000                  // ... puis une ligne toutes les 2 secondes
+#define DEFAULT_OUTPUT_BACKLOG 100                      // Lignes en attente avant "... N lines suppressed"
+#define OUTPUT_BULK 0
+#define OUTPUT_PRIORITY 1                               // PONG, erreurs : passent devant le volume
+#define MAX_NETWORKS 8
+#define MAX_CHANNELS 16                                 // Par réseau
+#define RECONNECT_SECONDS 5
+#define MAX_CLIENTS 64                                  // Par socket UNIX
+#define CLIENT_OUTPUT_MAX (1024 * 1024)                 // Sortie non lue avant de couper un client local
+#define LOCAL_MAX_COMMANDS 64                           // Commandes en cours avant de suspendre la lecture (stdio, UNIX)
+#define MAX_WORKERS 64
+#define DEFAULT_HEAVY_MILLISECONDS 1000                 // Une commande plus longue rend la session « lourde »
+#define DEFAULT_JOB_MAX_MILLISECONDS 600000UL           // Budget d'un job SPAWN (10 minutes)
+#define MAX_ACTIVE_JOBS 8
+#define MAX_JOBS_PER_NICK 2
+#define JOB_RESULTS 16                                  // Résultats gardés pour RESULT
+#define JOB_OUTPUT_MAX 4096
+#define DEFAULT_SESSION_MEMORY (64UL * 1024 * 1024)   // Au-delà, les sessions inactives sont évincées
+#define MEMO_BUCKETS 1024
+#define MAX_GENERATORS 16                               // Instances par session, la moins récente est évincée
+#define TAKE_LINE_MAX 400
+#define DEFAULT_MEMO_BYTES (1024UL * 1024)              // Cache MEMO par session
+#define RESULT_CACHE_BUCKETS 4096
+#define DEFAULT_RESULT_CACHE_BYTES (4UL * 1024 * 1024)
+#define RESULT_OUTPUT_MAX 4096                          // Réponse plus longue : pas mise en cache
+#define DEFAULT_SANDBOX_MEMORY (256UL * 1024 * 1024)  // Espace d'adressage ajouté à celui du parent
+#define SANDBOX_GRACE_MILLISECONDS 1000                 // Délai au-delà du budget avant SIGKILL
+#define SESSION_END 0x464f525448454e44L                 // Dernier mot d'un état de session complet
 
-#define BOT_NAME "forth"
+#define BOT_NAME "forth"                                // Valeurs par défaut, sans FORTH_CONFIG
+#ifndef CHANNEL                                         // -DCHANNEL='"#autre"' ou forth_gmp_irc_bot.c
 #define CHANNEL "#labynet"
+#endif
+#define SERVER_HOST "213.165.83.201"
+#define SERVER_PORT 6667
 
 typedef enum {
     OP_PUSH, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DUP, OP_SWAP, OP_OVER,
@@ -29,7 +105,15 @@ typedef enum {
     OP_WORDS, OP_FORGET, OP_VARIABLE, OP_FETCH, OP_STORE,
     OP_PICK, OP_ROLL, OP_PLUSSTORE, OP_DEPTH, OP_TOP, OP_NIP, OP_MOD,
     OP_CREATE, OP_ALLOT, OP_SEE, OP_RECURSE, OP_IRC_CONNECT, OP_IRC_SEND,OP_EMIT, 
-    OP_STRING, OP_QUOTE, OP_PRINT ,OP_STORE_STRING // Nouveaux opcodes pour chaînes
+    OP_STRING, OP_QUOTE, OP_PRINT ,OP_STORE_STRING, // Nouveaux opcodes pour chaînes
+    OP_SET_BASE, // HEX, DECIMAL, BINARY, OCTAL (operand = base)
+    OP_MEMSTATS, OP_QUEUESTATS, OP_CACHESTATS, OP_STATS, OP_PROFILE, OP_PROFILE_DUMP,
+    OP_JOBS, OP_KILL, OP_RESULT, // Jobs en arrière-plan (SPAWN)
+    OP_YIELD, OP_NEXT, OP_TAKE, // Générateurs (GENERATOR)
+    OP_FILL, OP_SUM, OP_DOT_PRODUCT, OP_PREFIX_SUM, OP_MINMAX, OP_REVERSE, OP_COPY, // Tableaux entiers
+    OP_MAP, OP_REDUCE,
+    OP_CELLS_ALLOT, OP_ARRAY_AND, OP_ARRAY_OR, OP_ARRAY_XOR, OP_ARRAY_EQ,
+    OP_COUNT // Nombre d'opcodes
 } OpCode;
 typedef struct {
     OpCode opcode;
@@ -42,6 +126,9 @@ typedef struct {
     long int code_length;
     char *strings[WORD_CODE_SIZE];
     long int string_count;
+    int memo;                   // MEMO : résultats mis en cache selon les arguments
+    int generator;              // GENERATOR : l'appel crée une instance reprise par NEXT
+    long int generator_args;    // Valeurs prises sur la pile à la création
 } CompiledWord;
 
 typedef struct {
@@ -61,9 +148,6 @@ typedef struct {
     mpz_t value;
 } Variable;
 
-ControlEntry control_stack[CONTROL_STACK_SIZE];
-int control_stack_top = 0;
-
 typedef struct {
     mpz_t index;
     mpz_t limit;
@@ -73,7 +157,8 @@ typedef struct {
 typedef enum {
     MEMORY_VARIABLE,
     MEMORY_ARRAY,
-    MEMORY_STRING  // Nouveau type pour les chaînes
+    MEMORY_STRING,  // Nouveau type pour les chaînes
+    MEMORY_CELLS    // Tableau contigu d'int64 (CELLS-ALLOT), promu en MEMORY_ARRAY au débordement
 } MemoryType;
 
 typedef struct {
@@ -81,36 +166,557 @@ typedef struct {
     MemoryType type;
     mpz_t *values;      // Pour MEMORY_VARIABLE et MEMORY_ARRAY
     char *string;       // Pour MEMORY_STRING
-    long int size;      // Pour MEMORY_ARRAY, ignoré pour MEMORY_STRING
+    int64_t *cells;     // Pour MEMORY_CELLS
+    long int size;      // Pour MEMORY_ARRAY et MEMORY_CELLS, ignoré pour MEMORY_STRING
 } Memory;
 
-char *string_stack[STACK_SIZE];
-int string_stack_top = -1;
+typedef struct FreeBlock {
+    struct FreeBlock *next;
+} FreeBlock;
+
+// Mémoire des limbs GMP : listes libres par classe, découpées dans des chunks d'arène.
+// Une instance par thread, sans verrou ; un bloc libéré va dans la liste du thread qui le libère.
+typedef struct {
+    FreeBlock *free_lists[GMP_SIZE_CLASSES];
+    char *arena;                 // Chunk courant
+    size_t arena_left;
+    unsigned long cmd_allocs;    // Commande en cours
+    long cmd_bytes;              // Croissance depuis le début de la commande
+    long cmd_peak_bytes;
+    size_t cmd_limit_bytes;      // Quota de la commande en cours (0 = aucun)
+    int over_quota;
+    char *scratch;               // Arène de commande : blocs empilés, rembobinée dès qu'elle est vide
+    size_t scratch_size, scratch_used;
+    long scratch_live;           // Blocs de l'arène pas encore libérés
+    int scratch_depth;           // Portées gmp_scratch_begin ouvertes
+} GmpHeap;
+
+// Compteurs globaux, tous threads confondus
+typedef struct {
+    _Atomic size_t arena_bytes;  // Total réservé en chunks
+    _Atomic size_t live_bytes;   // Octets demandés par GMP et pas encore libérés
+    _Atomic size_t peak_bytes;
+    _Atomic size_t huge_bytes;   // Part de live_bytes servie par malloc
+    _Atomic size_t scratch_bytes; // Arènes de commande réservées
+    _Atomic unsigned long allocs, reallocs, frees, scratch_allocs;
+} GmpTotals;
+
+__thread GmpHeap gmp_heap;
+GmpTotals gmp_totals;
+
+typedef struct {
+    char nick[64];                  // Vide pour le quota global
+    unsigned long max_result_bits;  // Taille maximale d'un résultat
+    size_t max_live_bytes;          // Croissance maximale des limbs pendant une commande
+} Quota;
+
+Quota default_quota = {"", DEFAULT_MAX_RESULT_BITS, DEFAULT_MAX_LIVE_BYTES};
+Quota user_quotas[MAX_USER_QUOTAS];
+int user_quota_count = 0;
+__thread Quota *active_quota = &default_quota;
+
+// Budget d'exécution d'une commande, découpé en tranches
+typedef struct {
+    unsigned long max_instructions;
+    unsigned long max_milliseconds;
+    unsigned long instructions;      // Exécutées par la commande en cours
+    int slice_left;
+    long long start_us;
+} VmBudget;
+
+VmBudget vm_limits = {DEFAULT_MAX_INSTRUCTIONS, DEFAULT_MAX_MILLISECONDS, 0, SLICE_INSTRUCTIONS, 0};
+__thread VmBudget vm_budget;    // Commande en cours sur ce thread
+unsigned long max_call_depth = DEFAULT_MAX_CALL_DEPTH;
+
+// Commande reçue par le thread réseau, exécutée par un thread de travail
+typedef struct PendingCommand {
+    char nick[64];
+    char reply_to[64];               // Canal, ou pseudo pour une requête privée
+    int network;                     // Index dans networks[]
+    int counted;                     // Compte dans networks[network].commands
+    char command[512];
+    long long enqueued_us;
+    struct PendingCommand *next;     // File de la session
+} PendingCommand;
+
+// File bornée sans verrou, plusieurs producteurs et un seul consommateur.
+// Chaque case porte un numéro de séquence qui indique à qui elle appartient.
+// Chaque ajout écrit un octet dans le tube pour réveiller le consommateur.
+typedef struct {
+    _Atomic unsigned long sequence;
+    void *item;
+} QueueCell;
+
+typedef struct {
+    QueueCell *cells;
+    unsigned long size;              // Puissance de deux
+    _Atomic unsigned long head;      // Avancé par le consommateur
+    _Atomic unsigned long tail;      // Avancé par les producteurs
+    int wake[2];
+} MpscQueue;
+
+// Anneau de réception : data[tail..head) reçu, pas encore traité ; compteurs croissants, index modulo la taille
+typedef struct {
+    char data[IRC_RECV_SIZE];
+    size_t head, tail;
+    size_t scan;                     // Octets déjà parcourus à la recherche de \n
+    int overlong;                    // Fin d'une ligne trop longue à ignorer
+} RecvRing;
+
+// Morceau d'une ligne reçue, non terminé par '\0'
+typedef struct {
+    const char *p;
+    size_t len;
+} Span;
+
+typedef struct {
+    Span tags;
+    Span nick, user, host;
+    Span command;
+    Span params[IRC_MAX_PARAMS];
+    int param_count;
+} IrcMessage;
+
+typedef struct {
+    char *data;                      // Octet de voie ('0' + OUTPUT_BULK...), octet de réseau ('0' + index),
+                                     // puis lignes "PRIVMSG cible :texte\r\n"
+    size_t len, cap;
+    long long first_us;              // Première ligne du lot
+} OutputBuffer;
+
+// File sortante du thread réseau : une voie prioritaire, une de volume, un seau à jetons commun
+typedef struct OutLine {
+    struct OutLine *next;
+    size_t len;
+    char text[];                     // Ligne complète, CRLF compris
+} OutLine;
+
+typedef struct {
+    int burst;
+    unsigned long interval_ms;       // 0 : pas de limite
+    long int backlog;
+} FloodConfig;
+
+typedef struct {
+    OutLine *head[2], *tail[2];
+    long int count[2];
+    OutLine *inflight[OUTPUT_WRITEV_MAX]; // Retirées des voies, jeton payé, pas encore toutes écrites
+    int inflight_count;
+    size_t offset;                   // Octets déjà écrits de inflight[0]
+    int blocked;                     // EAGAIN : attente de POLLOUT
+    double tokens;
+    long long refill_us;
+    long int suppressed;             // Lignes jetées depuis le dernier résumé
+    char suppressed_target[64];
+    _Atomic long queued, sent, suppressed_total; // Pour QUEUESTATS
+} Outbound;
+
+// Client d'un socket UNIX : une connexion, une session « unixN »
+typedef struct {
+    long int id;
+    int fd;
+    unsigned int events;             // Événements epoll demandés
+    RecvRing ring;
+    char *out;                       // Réponses pas encore écrites
+    size_t out_len, out_cap;
+} Client;
+
+struct Transport;
+
+// Un serveur IRC, ou un transport local : ses canaux, sa connexion, sa file sortante.
+// Un canal de plus ne coûte que son nom.
+typedef struct {
+    const struct Transport *transport;
+    char name[32];
+    char host[128];                  // Nom ou adresse du serveur, ou chemin du socket UNIX
+    int port;
+    char nick[32];
+    char channels[MAX_CHANNELS][64];
+    int channel_count;
+    int sock;                        // -1 : déconnecté
+    int connecting;                  // connect() non bloquant en cours
+    unsigned int events;             // Événements epoll demandés
+    long long retry_us;              // Prochaine tentative de connexion
+    RecvRing ring;
+    Outbound out;
+    int out_fd;                      // stdio : la vraie sortie standard
+    int polled;                      // stdio sur un fichier ordinaire, qu'epoll refuse : lu à chaque tour
+    int finished;                    // Entrée standard épuisée et traitée
+    Client *clients[MAX_CLIENTS];    // UNIX : connexions acceptées
+    long int client_ids;
+    _Atomic long commands;           // Commandes soumises et pas encore terminées
+    long int max_commands;           // Au-delà, lecture suspendue (0 : pas de limite, « Busy » si la file est pleine)
+} Network;
+
+// Transport d'un réseau : comment il se connecte, lit ses commandes et écrit les réponses
+typedef struct Transport {
+    const char *name;
+    void (*open)(int epfd, Network *net);
+    void (*event)(int epfd, Network *net, int slot, unsigned int events); // slot 0 : socket du réseau, n : clients[n - 1]
+    void (*line)(Network *net, int slot, char *line);  // Ligne reçue, sans fin de ligne
+    void (*deliver)(Network *net, const char *batch);  // Lot de réponses de l'interpréteur
+    void (*flush)(int epfd, Network *net);             // Écrit ce qui peut l'être, ajuste epoll, reconnecte
+    int (*timeout_ms)(Network *net);                   // Délai avant le prochain flush utile (-1 : aucun)
+} Transport;
+
+#define NETWORK_KEY(index, slot) ((uint64_t)(index) << 32 | (uint64_t)(slot)) // Clé epoll d'un descripteur
+#define WAKE_KEY UINT64_MAX                                                       // ... et du tube d'output_queue
+#define STATS_KEY (UINT64_MAX - 1)                                               // ... et du signalfd de SIGUSR1
+
+QueueCell output_cells[OUTPUT_QUEUE_SIZE];
+MpscQueue output_queue = {output_cells, OUTPUT_QUEUE_SIZE, 0, 0, {-1, -1}};     // Interpréteurs -> réseau
+
+// Cache des mots MEMO : clé = index du mot + valeurs des arguments, éviction LRU au-delà de memo_max_bytes
+typedef struct MemoEntry {
+    uint64_t hash;
+    int word;
+    int inputs, outputs;
+    mpz_t *values;                   // Arguments puis résultats
+    size_t bytes;
+    struct MemoEntry *chain;         // Même case de la table
+    struct MemoEntry *prev, *next;   // LRU, le plus récent en tête
+} MemoEntry;
+
+typedef struct {
+    MemoEntry **buckets;             // MEMO_BUCKETS cases, allouées au premier appel
+    MemoEntry *head, *tail;
+    size_t bytes;
+    long int entries;
+    signed char pure[DICT_SIZE];     // -1 : à vérifier
+    int arity[DICT_SIZE];            // Arguments consommés ; -1 : inconnu, -2 : variable (pas de cache)
+    unsigned long hits, misses;
+} MemoCache;
+
+// Journal d'annulation de la commande en cours : une erreur restaure l'état d'avant en O(modifications)
+typedef struct {
+    long int index;          // Entrée de memory[]
+    long int elem;           // Élément modifié, -1 si l'entrée entière est dans saved
+    int is_cell;
+    mpz_t value;             // Ancienne valeur d'un élément mpz
+    int64_t cell;            // Ancienne valeur d'un élément MEMORY_CELLS
+    Memory saved;
+} MemoryUndo;
+
+typedef struct {
+    long int index;
+    CompiledWord *word;      // Mot remplacé ou oublié, libéré à la validation s'il appartenait à la session
+    unsigned char owned;
+} WordUndo;
+
+typedef struct {
+    int depth;                              // interpret() imbriqués (LOAD) : une seule transaction
+    int failed;
+    int compiling;
+    long int stack_top, stack_low;          // data[stack_low..stack_top] sauvegardés avant écrasement
+    mpz_t stack_saved[STACK_SIZE];
+    int string_top, string_low;
+    char *string_saved[STACK_SIZE];
+    long int memory_count, dict_count;      // Au-delà : créés par la commande, simplement libérés
+    unsigned char memory_saved[VAR_SIZE];   // Entrée copiée en entier, plus rien à journaliser
+    long int memory_writes[VAR_SIZE];
+    MemoryUndo *memory_log;
+    long int memory_log_count, memory_log_cap;
+    unsigned char word_saved[DICT_SIZE];
+    WordUndo word_log[DICT_SIZE];
+    long int word_log_count;
+    long int generator_ids;                 // Instances créées par la commande : libérées si elle échoue
+} Transaction;
+
+typedef struct {
+    long int id;                            // Numéro empilé à la création
+    CompiledWord word;                      // Copie : l'instance survit à une redéfinition ou un FORGET
+    Stack *stack;                           // Pile privée
+    long int ip;                            // Instruction suivant le dernier YIELD
+    LoopControl *loops;                     // Boucles DO ouvertes au moment du YIELD
+    long int loop_count;
+    unsigned long last_used;
+    Stack *caller;                          // Pendant une reprise : pile de NEXT
+    int yielded;
+} Generator;
+
+enum { PROFILE_OFF, PROFILE_ON, PROFILE_REPORT }; // Opérande de OP_PROFILE
+
+#ifdef FORTH_PROFILE
+// Profileur instrumenté (gcc -DFORTH_PROFILE), un par session : PROFILE ON / OFF / REPORT
+#define PROFILE_TOP DICT_SIZE               // Instructions de la ligne interactive, hors de tout mot
+typedef struct {
+    unsigned long calls;
+    long long inclusive_ns, exclusive_ns, gmp_ns;
+    int active;                             // Appels en cours : une récursion ne compte qu'une fois en inclusif
+} WordProfile;
+
+typedef struct Profile {
+    int enabled;
+    unsigned long instructions;
+    unsigned long ops[OP_COUNT];
+    unsigned long pairs[OP_COUNT][OP_COUNT]; // [précédent][suivant], dans le même mot
+    WordProfile words[DICT_SIZE + 1];
+    long long child_ns;                     // Temps inclusif des appelés, retiré de l'exclusif de l'appelant
+    long long since_ns, elapsed_ns;         // Temps passé profilage actif
+} Profile;
+#endif
+
+// Échantillonneur SIGPROF : chaque thread tient la pile des mots Forth en cours d'exécution
+#define VM_FRAMES 64                        // Puissance de deux ; au-delà, seuls les plus internes sont lus
+#define SAMPLE_NAMES 1024
+#define SAMPLE_NAME_SIZE 32
+#define SAMPLE_STACKS 4096
+#define SAMPLE_NO_IP 0xffff                 // Cadre sans pointeur d'instruction (pseudo, marqueurs)
+#define DEFAULT_SAMPLE_FILE "forth.folded"
+
+typedef struct {
+    CompiledWord *word;
+    long int *ip;
+} VmFrame;
+
+typedef struct {
+    VmFrame frames[VM_FRAMES];              // Anneau indexé par depth
+    int depth;
+} VmFrames;
+
+// Tables remplies par le gestionnaire de signal : sans verrou ni allocation, une case réservée par CAS
+typedef struct {
+    _Atomic uint64_t hash;                  // 0 : libre
+    _Atomic int ready;                      // name copié
+    char name[SAMPLE_NAME_SIZE];
+} SampleName;
+
+typedef struct {
+    _Atomic uint64_t hash;
+    _Atomic int ready;                      // frames copiés
+    _Atomic unsigned long count;
+    int depth;
+    uint32_t frames[VM_FRAMES + 2];         // Nom (index + 1) << 16 | ip, de la racine vers le mot interrompu
+} SampleStack;
+
+typedef struct {
+    int hz;                                 // 0 : échantillonneur arrêté
+    char file[256];
+    SampleName names[SAMPLE_NAMES];
+    SampleStack stacks[SAMPLE_STACKS];
+    _Atomic unsigned long samples, dropped;
+} Sampler;
+
+// État complet d'un interpréteur, un par pseudo IRC
+typedef struct Session {
+    char nick[64];
+    Stack stack;
+    char *string_stack[STACK_SIZE];
+    int string_stack_top;
+    Memory memory[VAR_SIZE];
+    long int memory_count;
+    LoopControl loop_stack[LOOP_STACK_SIZE];
+    long int loop_stack_top;
+    ControlEntry control_stack[CONTROL_STACK_SIZE];
+    int control_stack_top;
+    CompiledWord *dictionary[DICT_SIZE];    // Les mots de l'image de base sont partagés...
+    unsigned char dict_owned[DICT_SIZE];    // ...et copiés à la première écriture
+    long int dict_count;
+    Variable variables[VAR_SIZE];
+    long int var_count;
+    CompiledWord currentWord;
+    int compiling;
+    long int current_word_index;
+    int error_flag;
+    mpz_t mpz_pool[MPZ_POOL_SIZE];
+    char emit_buffer[512];
+    int emit_buffer_pos;
+    long int base_index;                    // Index mémoire de la variable BASE
+    unsigned long last_cmd_allocs;          // Mémoire GMP de la commande précédente
+    long last_cmd_delta, last_cmd_peak;
+    PendingCommand *queue_head, *queue_tail; // Commandes en attente, exécutées dans l'ordre
+    int running;                            // Une commande tourne sur un thread de travail
+    int ready;                              // Présente dans la liste des sessions prêtes
+    int heavy;                              // Dernière commande plus longue que heavy_ms
+    size_t bytes;                           // session_bytes() à la fin de la dernière commande
+    Transaction txn;                        // Commande en cours, annulée si elle échoue
+    MemoCache memo;
+    long int memo_low;                      // Plus bas sommet de pile atteint par l'appel MEMO en cours
+    long int last_word_index;               // Dernier mot défini, pour MEMO
+    unsigned long dict_version;             // Changé à chaque modification du dictionnaire
+    int cache_rec;                          // Réponse en cours d'enregistrement pour le cache
+    long int cache_top;                     // Sommet de pile au début de la commande enregistrée
+    char cache_out[RESULT_OUTPUT_MAX];
+    size_t cache_out_len;
+    Generator *generators[MAX_GENERATORS];
+    long int generator_ids;
+    unsigned long generator_clock;
+    Generator *generator_active;            // Instance en cours de reprise
+    struct Job *job;                        // Session privée d'un job SPAWN, hors liste LRU
+#ifdef FORTH_PROFILE
+    Profile *profile;                       // Alloué au premier PROFILE ON
+#endif
+    struct Session *ready_next;
+    struct Session *prev, *next;            // Liste LRU, la plus récente en tête
+} Session;
+
+// Cache des réponses aux commandes : clé = texte normalisé + base + version du dictionnaire.
+// Une commande n'y entre que si elle n'a exécuté que des opcodes purs, `.`, `CR` et `."`,
+// sans consommer la pile d'avant ; un succès rejoue ses lignes et les valeurs qu'elle a empilées.
+typedef struct CachedResult {
+    uint64_t hash;
+    char *key;
+    char *output;                    // Lignes envoyées, chacune terminée par '\n'
+    mpz_t *pushed;
+    int pushed_count;
+    size_t bytes;
+    struct CachedResult *chain;
+    struct CachedResult *prev, *next; // LRU, le plus récent en tête
+} CachedResult;
+
+typedef struct {
+    pthread_mutex_t lock;
+    CachedResult *buckets[RESULT_CACHE_BUCKETS];
+    CachedResult *head, *tail;
+    size_t bytes, max_bytes;
+    long int entries;
+    unsigned long lookups, hits, stores, uncacheable;
+} ResultCache;
+
+ResultCache result_cache = {.lock = PTHREAD_MUTEX_INITIALIZER, .max_bytes = DEFAULT_RESULT_CACHE_BYTES};
+// Latence par commande, découpée en phases (STATS, SIGUSR1)
+typedef enum { PHASE_PARSE, PHASE_COMPILE, PHASE_EXECUTE, PHASE_FORMAT, PHASE_SEND, PHASE_COUNT } Phase;
+#define LATENCY_TOTAL PHASE_COUNT            // Histogrammes après les phases
+#define LATENCY_WAIT (PHASE_COUNT + 1)
+#define LATENCY_SERIES (PHASE_COUNT + 2)
+#define LATENCY_SUB_BITS 4                   // 16 sous-seaux par puissance de deux : ~6 % d'erreur
+#define LATENCY_BUCKETS (64 << LATENCY_SUB_BITS)
+#define LATENCY_NICKS 512                    // Adressage ouvert ; au-delà, les pseudos ne sont plus suivis
+
+// Histogramme log-linéaire en nanosecondes, façon HDR
+typedef struct {
+    unsigned long counts[LATENCY_BUCKETS];
+    unsigned long count;
+    long long sum, max;
+} LatencyHistogram;
+
+typedef struct {
+    char nick[64];
+    unsigned long commands, errors;
+    long long total_ns, max_ns;
+    long long phase_ns[PHASE_COUNT];
+} NickLatency;
+
+typedef struct {
+    pthread_mutex_t lock;
+    LatencyHistogram series[LATENCY_SERIES];
+    NickLatency nicks[LATENCY_NICKS];
+    int nick_count;
+    unsigned long commands, errors;
+    long long since_ns;
+} LatencyStats;
+
+LatencyStats latency = {.lock = PTHREAD_MUTEX_INITIALIZER};
+const char *latency_names[LATENCY_SERIES] = {"parse", "compile", "execute", "format", "send", "total", "wait"};
+char latency_file[256] = "forth_stats.txt";
+__thread int phase_current = -1;            // -1 : hors commande, rien n'est mesuré
+__thread long long phase_since_ns;
+__thread long long phase_ns[PHASE_COUNT];
+_Atomic unsigned long dict_versions = 1;    // Tampons de version du dictionnaire, uniques entre sessions
+
+// Image de base : mots et variables définis au démarrage (et par FORTH_PRELUDE), figée ensuite
+Session base_session = {.string_stack_top = -1, .loop_stack_top = -1, .current_word_index = -1, .base_index = -1, .last_word_index = -1};
+__thread Session *session = &base_session;  // Session du thread courant
+__thread const char *reply_target = CHANNEL;  // Destinataire des réponses de la commande en cours
+__thread int reply_network;                 // ... et son réseau
+__thread OutputBuffer output_batch;         // Lignes de la commande en cours, pas encore dans output_queue
+__thread int output_lane = OUTPUT_BULK;     // Voie des lignes en cours (set_error : prioritaire)
+FloodConfig flood = {DEFAULT_FLOOD_BURST, DEFAULT_FLOOD_INTERVAL_MS, DEFAULT_OUTPUT_BACKLOG};
+Network networks[MAX_NETWORKS];             // Thread réseau seulement (compteurs atomiques à part)
+int network_count;
+__thread int output_batching;               // Dans run_command : envoi groupé à la fin
+__thread VmFrames vm_frames;                // Lue par le gestionnaire de SIGPROF du même thread
+Sampler sampler = {.file = DEFAULT_SAMPLE_FILE};
+Session *sessions = NULL;
+long int session_count = 0;
+size_t session_memory_cap = DEFAULT_SESSION_MEMORY;
+size_t memo_max_bytes = DEFAULT_MEMO_BYTES;
+
+typedef enum { JOB_QUEUED, JOB_RUNNING, JOB_DONE, JOB_FAILED, JOB_CANCELLED } JobState;
+
+// Commande lancée par SPAWN : s'exécute sur une copie de la session de son auteur
+typedef struct Job {
+    long int id;
+    char nick[64];
+    char command[512];
+    JobState state;
+    Session *session;                // Libérée à la fin du job
+    _Atomic int cancel;              // Posé par KILL, lu à chaque fin de tranche
+    _Atomic long bytes;              // Croissance GMP, mise à jour à chaque fin de tranche
+    long long submitted_us, started_us, finished_us;
+    char *output;                    // Sortie capturée au lieu d'être envoyée
+    size_t output_len;
+    char reply_to[64];               // Où annoncer la fin du job
+    int network;
+    struct Job *next;
+} Job;
 
-Memory memory[VAR_SIZE];
-long int memory_count = 0;
+Job *active_jobs = NULL;             // Protégés par le verrou de l'ordonnanceur
+Job *job_results[JOB_RESULTS];       // Anneau des jobs terminés
+long int job_results_next = 0;
+long int next_job_id = 1;
+VmBudget vm_job_limits = {0, DEFAULT_JOB_MAX_MILLISECONDS, 0, SLICE_INSTRUCTIONS, 0};
 
-LoopControl loop_stack[LOOP_STACK_SIZE];
-long int loop_stack_top = -1;
+// Bac à sable : chaque commande s'exécute dans un enfant d'un processus auxiliaire mono-thread,
+// qui renvoie sa sortie et l'état de la session par un socket
+typedef struct {
+    int enabled;
+    size_t max_memory;               // RLIMIT_AS = taille virtuelle du parent + max_memory
+    int helper_fd;                   // Vers le processus auxiliaire qui lance les enfants
+    _Atomic unsigned long forks, killed;
+    _Atomic long long fork_us_total; // Durée cumulée entre la demande et le démarrage de l'enfant
+    _Atomic long long fork_us_max;
+} Sandbox;
 
-CompiledWord dictionary[DICT_SIZE];
-long int dict_count = 0;
+// Une commande en cours dans un enfant, vue du parent
+typedef struct {
+    int fd;                          // Socket partagé avec l'enfant
+    pid_t pid;                       // Annoncé par l'enfant ('P')
+    long long started_us;
+    int exited, status;              // Relevé par le processus auxiliaire ('X')
+    int loaded;                      // État final appliqué à la session
+    char *spawn;                     // SPAWN demandé par la commande
+} SandboxRun;
 
-Variable variables[VAR_SIZE];
-long int var_count = 0;
+Sandbox sandbox = {.enabled = 0, .max_memory = DEFAULT_SANDBOX_MEMORY, .helper_fd = -1};
+int sandbox_fd = -1;                 // Tube vers le parent, dans un enfant seulement
 
-CompiledWord currentWord;
-int compiling = 0;
-long int current_word_index = -1;
+// Ordonnanceur : une file FIFO par session, tourniquet entre les sessions prêtes.
+// Le verrou ne protège que les files et la liste des sessions, jamais l'exécution.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wakeup;
+    PendingCommand *incoming_head, *incoming_tail; // Reçues, pas encore rangées par session
+    Session *ready_head, *ready_tail;
+    long int queued;                 // Commandes reçues et pas encore démarrées
+    int workers;
+    int running;
+    int heavy_running;
+    int max_heavy;                   // Sessions lourdes exécutées en même temps
+    unsigned long heavy_ms;
+    unsigned long dispatched;
+    long long wait_total_us, wait_max_us, wait_last_us;
+} Scheduler;
 
-int error_flag = 0;
-mpz_t mpz_pool[MPZ_POOL_SIZE];
-static int irc_socket = -1;
-char emit_buffer[512] = "";
-int emit_buffer_pos = 0;
+Scheduler scheduler = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wakeup = PTHREAD_COND_INITIALIZER,
+    .workers = 1,
+    .max_heavy = 1,
+    .heavy_ms = DEFAULT_HEAVY_MILLISECONDS,
+};
 
 void initStack(Stack *stack);
 void clearStack(Stack *stack);
+void forget_word(long int index);
+void word_free(CompiledWord *word);
+void txn_begin();
+void txn_end();
+void txn_stack_write(Stack *stack, long int index);
+void txn_string_write(int index);
+void txn_memory_write(long int index, long int elem);
+void txn_word_write(long int index);
+CompiledWord *word_for_write(long int index);
 void push(Stack *stack, mpz_t value);
 void pop(Stack *stack, mpz_t result);
 int findCompiledWordIndex(char *name);
@@ -118,8 +724,90 @@ int findVariableIndex(char *name);
 int findMemoryIndex(char *name);
 void set_error(const char *msg);
 void init_mpz_pool();
+void init_gmp_heap();
+void gmp_heap_begin_command();
+int gmp_scratch_begin(size_t limbs);
+void gmp_scratch_end(int opened, mpz_ptr result);
+void init_quotas();
+Quota *find_quota(const char *nick);
+int check_result_bits(unsigned long bits, const char *op);
+long long now_us();
+long long now_ns();
+int phase_switch(int phase);
+long long phase_stop();
+void init_latency();
+void latency_record(const char *nick, int error, long long total_ns, long long wait_ns);
+void latency_report(const char *nick);
+void latency_dump();
+void init_sampler();
+void sampler_dump();
+#ifdef FORTH_PROFILE
+long long profile_enter(Profile *profile, int slot, long long *saved_children);
+void profile_leave(Profile *profile, int slot, long long start, long long saved_children);
+long long profile_instruction(OpCode op, int *previous_op);
+void profile_gmp(int word_index, long long start);
+void profile_command(long int mode);
+#endif
+void init_vm_budget();
+void vm_begin_command();
+void vm_slice_end();
+void mpsc_init(MpscQueue *queue);
+int mpsc_push(MpscQueue *queue, void *item);
+void *mpsc_pop(MpscQueue *queue);
+void irc_handle_data(Network *net, int slot, char *buffer);
+int irc_parse(const char *line, size_t len, IrcMessage *msg);
+void network_flush_output(int epfd);
+void network_command_done(int index);
+int network_submit(Network *net, Span nick, Span command, Span reply_to);
+void output_flush();
+void init_outbound();
+void init_networks();
+void outbound_push(Network *net, int lane, const char *text, size_t len);
+int outbound_timeout_ms(Network *net);
+long recv_ring_fill(RecvRing *ring, int fd);
+void recv_ring_lines(RecvRing *ring, Network *net, int slot);
+void *interpreter_worker(void *arg);
+Session *session_create(const char *nick);
+void session_destroy(Session *s);
+Session *session_for_nick(const char *nick);
+size_t session_bytes(Session *s);
+void session_evict();
+void run_command(Session *s, PendingCommand *command);
+void init_sandbox();
+void init_sandbox_helper();
+void init_result_cache();
+void dict_changed();
+int result_cache_replay(Session *s, const char *command, char **key);
+void result_cache_record(const char *msg);
+void result_cache_store(Session *s, char *key);
+int opcode_is_pure(OpCode op);
+void sandbox_run(Session *s, char *command);
+void sandbox_send(char type, const void *data, size_t len);
+int sandbox_delegate(Instruction instr, Stack *stack);
+void memory_free(Memory *m);
+void init_scheduler();
+int scheduler_submit(PendingCommand *command);
+void init_sessions();
+void memory_copy(Memory *dst, const Memory *src);
+void word_copy(CompiledWord *dst, const CompiledWord *src);
+void generator_free(Generator *g);
+Generator *generator_copy(const Generator *src);
+void generator_next(Stack *stack);
+void generator_take(Stack *stack);
+void generator_yield(Stack *stack, CompiledWord *word);
+void generators_rollback(long int ids);
+void memo_reset(MemoCache *m);
+Session *session_clone(Session *src);
+void job_spawn(const char *command);
+void job_capture(Job *job, const char *msg);
+JobState job_finish(Job *job);
+const char *job_state_name(JobState state);
+char *job_result_message(Job *job, JobState state);
+void job_archive(Job *job, JobState state);
 void clear_mpz_pool();
+void release_temporaries(Session *s);
 void exec_arith(Instruction instr, Stack *stack);
+void exec_bulk(Instruction instr, Stack *stack, CompiledWord *word, int word_index);
 void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledWord *word, int word_index);
 void executeCompiledWord(CompiledWord *word, Stack *stack, int word_index);
 void addCompiledWord(char *name, Instruction *code, long int code_length, char **strings, long int string_count);
@@ -128,6 +816,9 @@ void interpret(char *input, Stack *stack);
 void irc_connect(Stack *stack);
 void send_to_channel(const char *msg);
 void print_word_definition_irc(int index, Stack *stack);
+int current_base();
+int parse_number(mpz_t result, const char *token);
+char *format_number(const mpz_t value);
 
 void initStack(Stack *stack) {
     stack->top = -1;
@@ -135,25 +826,48 @@ void initStack(Stack *stack) {
         mpz_init(stack->data[i]);
     }
     for (int i = 0; i < VAR_SIZE; i++) {
-        memory[i].name = NULL;
-        memory[i].type = MEMORY_VARIABLE;
-        memory[i].values = NULL;
-        memory[i].string = NULL;  // Initialisé à NULL pour MEMORY_STRING
-        memory[i].size = 0;
+        session->memory[i].name = NULL;
+        session->memory[i].type = MEMORY_VARIABLE;
+        session->memory[i].values = NULL;
+        session->memory[i].string = NULL;  // Initialisé à NULL pour MEMORY_STRING
+        session->memory[i].cells = NULL;
+        session->memory[i].size = 0;
+    }
+}
+
+void memory_free(Memory *m) {
+    if (m->name) free(m->name);
+    if (m->type == MEMORY_VARIABLE || m->type == MEMORY_ARRAY) {
+        if (m->values) {
+            for (int j = 0; j < m->size; j++) {
+                mpz_clear(m->values[j]);
+            }
+            free(m->values);
+        }
+    } else if (m->type == MEMORY_STRING) {
+        if (m->string) free(m->string);
+    } else if (m->type == MEMORY_CELLS) {
+        free(m->cells);
     }
+    m->name = NULL;
+    m->values = NULL;
+    m->string = NULL;
+    m->cells = NULL;
+    m->size = 0;
 }
 
 void push_string(char *str) {
-    if (string_stack_top < STACK_SIZE - 1) {
-        string_stack[++string_stack_top] = str;
+    if (session->string_stack_top < STACK_SIZE - 1) {
+        txn_string_write(session->string_stack_top + 1);
+        session->string_stack[++session->string_stack_top] = str;
     } else {
         set_error("String stack overflow");
     }
 }
 
 char *pop_string() {
-    if (string_stack_top >= 0) {
-        return string_stack[string_stack_top--];
+    if (session->string_stack_top >= 0) {
+        return session->string_stack[session->string_stack_top--];
     } else {
         set_error("String stack underflow");
         return NULL;
@@ -163,42 +877,211 @@ void clearStack(Stack *stack) {
     for (int i = 0; i < STACK_SIZE; i++) {
         mpz_clear(stack->data[i]);
     }
-    for (int i = 0; i < memory_count; i++) {
-        if (memory[i].name) free(memory[i].name);
-        if (memory[i].type == MEMORY_VARIABLE || memory[i].type == MEMORY_ARRAY) {
-            if (memory[i].values) {
-                for (int j = 0; j < memory[i].size; j++) {
-                    mpz_clear(memory[i].values[j]);
-                }
-                free(memory[i].values);
+    for (int i = 0; i < session->memory_count; i++) {
+        memory_free(&session->memory[i]);
+    }
+    session->memory_count = 0;
+    for (int i = 0; i < session->dict_count; i++) {
+        forget_word(i);
+    }
+    session->dict_count = 0;
+}
+
+// Libère un mot propre à la session ; un mot de l'image de base est seulement détaché
+void forget_word(long int index) {
+    CompiledWord *word = session->dictionary[index];
+    if (word && session->dict_owned[index]) word_free(word);
+    session->dictionary[index] = NULL;
+    session->dict_owned[index] = 0;
+}
+
+void word_free(CompiledWord *word) {
+    if (word->name) free(word->name);
+    for (int j = 0; j < word->string_count; j++) {
+        if (word->strings[j]) free(word->strings[j]);
+    }
+    free(word);
+}
+
+void txn_begin() {
+    Transaction *t = &session->txn;
+    if (t->depth++ > 0) return;
+    t->failed = 0;
+    t->compiling = session->compiling;
+    t->stack_top = session->stack.top;
+    t->stack_low = session->stack.top + 1;
+    t->string_top = session->string_stack_top;
+    t->string_low = session->string_stack_top + 1;
+    t->memory_count = session->memory_count;
+    t->dict_count = session->dict_count;
+    t->memory_log_count = 0;
+    t->word_log_count = 0;
+    t->generator_ids = session->generator_ids;
+}
+
+// Avant d'écraser data[index] : sauvegarde les cases d'origine pas encore sauvegardées
+void txn_stack_write(Stack *stack, long int index) {
+    Transaction *t = &session->txn;
+    if (!t->depth || stack != &session->stack || index > t->stack_top) return;
+    while (t->stack_low > index) {
+        t->stack_low--;
+        mpz_init_set(t->stack_saved[t->stack_low], stack->data[t->stack_low]);
+    }
+}
+
+void txn_string_write(int index) {
+    Transaction *t = &session->txn;
+    if (!t->depth || index > t->string_top) return;
+    while (t->string_low > index) {
+        t->string_low--;
+        t->string_saved[t->string_low] = session->string_stack[t->string_low];
+    }
+}
+
+// Avant de modifier memory[index] : l'élément elem, ou toute l'entrée si elem vaut -1.
+// Une variable, ou un tableau dont on a déjà journalisé autant d'éléments que sa taille, est copié en entier.
+void txn_memory_write(long int index, long int elem) {
+    Transaction *t = &session->txn;
+    if (!t->depth || index < 0 || index >= t->memory_count || t->memory_saved[index]) return;
+    Memory *m = &session->memory[index];
+    if (m->type == MEMORY_VARIABLE || m->type == MEMORY_STRING || t->memory_writes[index] >= m->size) elem = -1;
+    if (t->memory_log_count == t->memory_log_cap) {
+        long int cap = t->memory_log_cap ? t->memory_log_cap * 2 : 16;
+        MemoryUndo *log = realloc(t->memory_log, cap * sizeof(MemoryUndo));
+        if (!log) {
+            set_error("Transaction log: Memory allocation failed");
+            return;
+        }
+        t->memory_log = log;
+        t->memory_log_cap = cap;
+    }
+    MemoryUndo *undo = &t->memory_log[t->memory_log_count++];
+    undo->index = index;
+    undo->elem = elem;
+    undo->is_cell = m->type == MEMORY_CELLS;
+    if (elem < 0) {
+        memory_copy(&undo->saved, m);
+        t->memory_saved[index] = 1;
+    } else if (undo->is_cell) {
+        undo->cell = m->cells[elem];
+        t->memory_writes[index]++;
+    } else {
+        mpz_init_set(undo->value, m->values[elem]);
+        t->memory_writes[index]++;
+    }
+}
+
+// Avant de redéfinir ou d'oublier un mot existant : l'ancien passe dans le journal
+void txn_word_write(long int index) {
+    Transaction *t = &session->txn;
+    if (!t->depth || index >= t->dict_count || t->word_saved[index]) return;
+    WordUndo *undo = &t->word_log[t->word_log_count++];
+    undo->index = index;
+    undo->word = session->dictionary[index];
+    undo->owned = session->dict_owned[index];
+    session->dict_owned[index] = 0; // word_for_write en fera une nouvelle copie
+    t->word_saved[index] = 1;
+}
+
+// Fin de commande : valide, ou restaure tout ce que le journal a enregistré
+void txn_end() {
+    Transaction *t = &session->txn;
+    if (session->error_flag) t->failed = 1;
+    if (--t->depth > 0) return;
+    for (long int i = t->memory_log_count - 1; i >= 0; i--) {
+        MemoryUndo *undo = &t->memory_log[i];
+        Memory *m = &session->memory[undo->index];
+        if (undo->elem < 0) {
+            if (t->failed) {
+                memory_free(m);
+                *m = undo->saved;
+            } else {
+                memory_free(&undo->saved);
             }
-        } else if (memory[i].type == MEMORY_STRING) {
-            if (memory[i].string) free(memory[i].string);
+            t->memory_saved[undo->index] = 0;
+        } else {
+            if (t->failed) {
+                if (undo->is_cell) m->cells[undo->elem] = undo->cell;
+                else mpz_set(m->values[undo->elem], undo->value);
+            }
+            if (!undo->is_cell) mpz_clear(undo->value);
+            t->memory_writes[undo->index] = 0;
+        }
+    }
+    for (long int i = 0; i < t->word_log_count; i++) {
+        WordUndo *undo = &t->word_log[i];
+        if (t->failed) {
+            forget_word(undo->index);
+            session->dictionary[undo->index] = undo->word;
+            session->dict_owned[undo->index] = undo->owned;
+        } else if (undo->word && undo->owned) {
+            word_free(undo->word);
         }
+        t->word_saved[undo->index] = 0;
     }
-    memory_count = 0;
-    for (int i = 0; i < dict_count; i++) {
-        if (dictionary[i].name) free(dictionary[i].name);
-        for (int j = 0; j < dictionary[i].string_count; j++) {
-            if (dictionary[i].strings[j]) free(dictionary[i].strings[j]);
+    for (long int i = t->stack_low; i <= t->stack_top; i++) {
+        if (t->failed) mpz_swap(session->stack.data[i], t->stack_saved[i]);
+        mpz_clear(t->stack_saved[i]);
+    }
+    if (!t->failed) return;
+
+    if (t->word_log_count || session->dict_count != t->dict_count) {
+        memo_reset(&session->memo);
+        dict_changed();
+    }
+    for (long int i = t->memory_count; i < session->memory_count; i++) {
+        memory_free(&session->memory[i]);
+    }
+    session->memory_count = t->memory_count;
+    for (long int i = t->dict_count; i < session->dict_count; i++) {
+        forget_word(i);
+    }
+    session->dict_count = t->dict_count;
+    session->stack.top = t->stack_top;
+    for (int i = t->string_low; i <= t->string_top; i++) {
+        session->string_stack[i] = t->string_saved[i];
+    }
+    session->string_stack_top = t->string_top;
+    generators_rollback(t->generator_ids);
+    if (session->compiling && !t->compiling) {
+        free(session->currentWord.name);
+        for (int i = 0; i < session->currentWord.string_count; i++) {
+            if (session->currentWord.strings[i]) free(session->currentWord.strings[i]);
         }
+        session->compiling = 0;
+        session->current_word_index = -1;
+    }
+    session->error_flag = 1;
+}
+
+// Copie à l'écriture : le mot retourné appartient à la session
+CompiledWord *word_for_write(long int index) {
+    if (!session->dict_owned[index]) {
+        CompiledWord *word = calloc(1, sizeof(CompiledWord));
+        if (!word) return NULL;
+        session->dictionary[index] = word;
+        session->dict_owned[index] = 1;
     }
-    dict_count = 0;
+    return session->dictionary[index];
 }
 int findMemoryIndex(char *name) {
-    for (int i = 0; i < memory_count; i++) {
-        if (memory[i].name && strcmp(memory[i].name, name) == 0) return i;
+    for (int i = 0; i < session->memory_count; i++) {
+        if (session->memory[i].name && strcmp(session->memory[i].name, name) == 0) return i;
     }
     return -1;
 }
 void set_error(const char *msg) {
     char err_msg[512];
     snprintf(err_msg, sizeof(err_msg), "Error: %s", msg);
+    output_lane = OUTPUT_PRIORITY;
     send_to_channel(err_msg);
-    error_flag = 1;
+    output_lane = OUTPUT_BULK;
+    session->error_flag = 1;
+    session->cache_rec = 0; // Sous-dépassement ou autre : la réponse dépend de l'état, pas de cache
 }
 void push(Stack *stack, mpz_t value) {
     if (stack->top < STACK_SIZE - 1) {
+        txn_stack_write(stack, stack->top + 1);
         mpz_set(stack->data[++stack->top], value);
     } else {
         set_error("Stack overflow");
@@ -208,6 +1091,7 @@ void push(Stack *stack, mpz_t value) {
 void pop(Stack *stack, mpz_t result) {
     if (stack->top >= 0) {
         mpz_set(result, stack->data[stack->top--]);
+        if (stack->top < session->memo_low) session->memo_low = stack->top;
     } else {
         set_error("Stack underflow");
         mpz_set_ui(result, 0);
@@ -215,62 +1099,443 @@ void pop(Stack *stack, mpz_t result) {
 }
 
 int findVariableIndex(char *name) {
-    for (int i = 0; i < var_count; i++) {
-        if (variables[i].name && strcmp(variables[i].name, name) == 0) return i;
+    for (int i = 0; i < session->var_count; i++) {
+        if (session->variables[i].name && strcmp(session->variables[i].name, name) == 0) return i;
     }
     return -1;
 }
 
 int findCompiledWordIndex(char *name) {
-    for (int i = 0; i < dict_count; i++) {
-        if (dictionary[i].name && strcmp(dictionary[i].name, name) == 0) return i;
+    for (int i = 0; i < session->dict_count; i++) {
+        if (session->dictionary[i]->name && strcmp(session->dictionary[i]->name, name) == 0) return i;
     }
     return -1;
 }
 
 
 
+int current_base() {
+    if (session->base_index >= 0 && session->memory[session->base_index].values && mpz_fits_slong_p(session->memory[session->base_index].values[0])) {
+        long int base = mpz_get_si(session->memory[session->base_index].values[0]);
+        if (base >= 2 && base <= 36) return base;
+    }
+    return 10;
+}
+
+// Préfixes : $FF (hex), %1010 (binaire), #10 (décimal), signe avant ou après le préfixe
+int parse_number(mpz_t result, const char *token) {
+    int base = current_base();
+    int negative = 0;
+    const char *p = token;
+    if (*p == '-' && p[1]) {
+        negative = 1;
+        p++;
+    }
+    switch (*p) {
+        case '$': base = 16; p++; break;
+        case '%': base = 2; p++; break;
+        case '#': base = 10; p++; break;
+    }
+    if (*p == '-') {
+        if (negative) return -1;
+        negative = 1;
+        p++;
+    }
+    if (*p == '\0' || mpz_set_str(result, p, base) != 0) return -1;
+    if (negative) mpz_neg(result, result);
+    return 0;
+}
+
+// Chaîne allouée (à libérer avec free), chiffres en majuscules au-delà de la base 10
+char *format_number(const mpz_t value) {
+    int previous = phase_switch(PHASE_FORMAT);
+    int base = current_base();
+    char *str = malloc(mpz_sizeinbase(value, base) + 2);
+    int scratch = gmp_scratch_begin(mpz_size(value));
+    if (str) mpz_get_str(str, base > 10 ? -base : base, value);
+    gmp_scratch_end(scratch, NULL);
+    phase_switch(previous);
+    return str;
+}
+
+static int gmp_size_class(size_t size) {
+    int cls = 0;
+    size_t block = 16;
+    while (block < size) {
+        block <<= 1;
+        cls++;
+    }
+    return cls;
+}
+
+static void gmp_heap_account(long delta) {
+    size_t live = atomic_fetch_add_explicit(&gmp_totals.live_bytes, delta, memory_order_relaxed) + delta;
+    size_t peak = atomic_load_explicit(&gmp_totals.peak_bytes, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak_explicit(&gmp_totals.peak_bytes, &peak, live,
+                                                                memory_order_relaxed, memory_order_relaxed));
+    gmp_heap.cmd_bytes += delta;
+    if (gmp_heap.cmd_bytes > gmp_heap.cmd_peak_bytes) gmp_heap.cmd_peak_bytes = gmp_heap.cmd_bytes;
+    if (gmp_heap.cmd_limit_bytes && gmp_heap.cmd_bytes > (long)gmp_heap.cmd_limit_bytes) {
+        gmp_heap.over_quota = 1; // Vérifié par la VM après l'instruction
+    }
+}
+
+static void *gmp_heap_oom(size_t size) {
+    fprintf(stderr, "GMP: cannot allocate %zu bytes\n", size);
+    abort();
+}
+
+static void *gmp_small_alloc(int cls) {
+    size_t block = (size_t)16 << cls;
+    FreeBlock *head = gmp_heap.free_lists[cls];
+    if (head) {
+        gmp_heap.free_lists[cls] = head->next;
+        return head;
+    }
+    if (gmp_heap.arena_left < block) {
+        // Le reste du chunk courant est perdu (au plus GMP_SMALL_MAX octets)
+        gmp_heap.arena = malloc(GMP_ARENA_CHUNK);
+        if (!gmp_heap.arena) gmp_heap_oom(GMP_ARENA_CHUNK);
+        gmp_heap.arena_left = GMP_ARENA_CHUNK;
+        atomic_fetch_add_explicit(&gmp_totals.arena_bytes, GMP_ARENA_CHUNK, memory_order_relaxed);
+    }
+    void *ptr = gmp_heap.arena;
+    gmp_heap.arena += block;
+    gmp_heap.arena_left -= block;
+    return ptr;
+}
+
+static int gmp_in_scratch(const void *ptr) {
+    return gmp_heap.scratch && (const char *)ptr >= gmp_heap.scratch && (const char *)ptr < gmp_heap.scratch + gmp_heap.scratch_size;
+}
+
+// Bloc en haut de l'arène ; NULL si elle est pleine et encore occupée (le tas prend le relais)
+static void *gmp_scratch_take(size_t size) {
+    size_t block = (size + 15) & ~(size_t)15;
+    if (gmp_heap.scratch_used + block > gmp_heap.scratch_size) {
+        if (gmp_heap.scratch_live > 0) return NULL;
+        size_t grown = gmp_heap.scratch_size > GMP_SCRATCH_REGION ? gmp_heap.scratch_size : GMP_SCRATCH_REGION;
+        while (grown < block) grown *= 2;
+        free(gmp_heap.scratch);
+        atomic_fetch_sub_explicit(&gmp_totals.scratch_bytes, gmp_heap.scratch_size, memory_order_relaxed);
+        gmp_heap.scratch = malloc(grown);
+        gmp_heap.scratch_size = gmp_heap.scratch ? grown : 0;
+        gmp_heap.scratch_used = 0;
+        atomic_fetch_add_explicit(&gmp_totals.scratch_bytes, gmp_heap.scratch_size, memory_order_relaxed);
+        if (!gmp_heap.scratch) return NULL;
+    }
+    void *ptr = gmp_heap.scratch + gmp_heap.scratch_used;
+    gmp_heap.scratch_used += block;
+    gmp_heap.scratch_live++;
+    atomic_fetch_add_explicit(&gmp_totals.scratch_allocs, 1, memory_order_relaxed);
+    return ptr;
+}
+
+// Le bloc du haut rend sa place ; l'arène vide repart du début
+static void gmp_scratch_release(void *ptr, size_t size) {
+    size_t block = (size + 15) & ~(size_t)15;
+    if ((char *)ptr + block == gmp_heap.scratch + gmp_heap.scratch_used) gmp_heap.scratch_used -= block;
+    if (--gmp_heap.scratch_live == 0) gmp_heap.scratch_used = 0;
+}
+
+// Listes libres ou malloc, sans comptage
+static void *gmp_heap_take(size_t size) {
+    if (size <= GMP_SMALL_MAX) return gmp_small_alloc(gmp_size_class(size));
+    void *ptr = malloc(size);
+    if (!ptr) gmp_heap_oom(size);
+    atomic_fetch_add_explicit(&gmp_totals.huge_bytes, size, memory_order_relaxed);
+    return ptr;
+}
+
+static void *gmp_heap_alloc(size_t size) {
+    void *ptr = NULL;
+    atomic_fetch_add_explicit(&gmp_totals.allocs, 1, memory_order_relaxed);
+    gmp_heap.cmd_allocs++;
+    if (gmp_heap.scratch_depth) ptr = gmp_scratch_take(size);
+    if (!ptr) ptr = gmp_heap_take(size);
+    gmp_heap_account(size);
+    return ptr;
+}
+
+static void gmp_heap_free(void *ptr, size_t size) {
+    atomic_fetch_add_explicit(&gmp_totals.frees, 1, memory_order_relaxed);
+    if (gmp_in_scratch(ptr)) {
+        gmp_scratch_release(ptr, size);
+    } else if (size <= GMP_SMALL_MAX) {
+        int cls = gmp_size_class(size);
+        FreeBlock *block = ptr;
+        block->next = gmp_heap.free_lists[cls];
+        gmp_heap.free_lists[cls] = block;
+    } else {
+        free(ptr);
+        atomic_fetch_sub_explicit(&gmp_totals.huge_bytes, size, memory_order_relaxed);
+    }
+    gmp_heap_account(-(long)size);
+}
+
+static void *gmp_heap_realloc(void *ptr, size_t old_size, size_t new_size) {
+    atomic_fetch_add_explicit(&gmp_totals.reallocs, 1, memory_order_relaxed);
+    if (gmp_in_scratch(ptr)) {
+        size_t old_block = (old_size + 15) & ~(size_t)15, new_block = (new_size + 15) & ~(size_t)15;
+        if ((char *)ptr + old_block == gmp_heap.scratch + gmp_heap.scratch_used &&
+            gmp_heap.scratch_used - old_block + new_block <= gmp_heap.scratch_size) {
+            gmp_heap.scratch_used += new_block - old_block; // En haut de l'arène : sur place
+            gmp_heap_account((long)new_size - (long)old_size);
+            return ptr;
+        }
+    } else if (old_size > GMP_SMALL_MAX && new_size > GMP_SMALL_MAX) {
+        void *grown = realloc(ptr, new_size);
+        if (!grown) gmp_heap_oom(new_size);
+        atomic_fetch_add_explicit(&gmp_totals.huge_bytes, new_size - old_size, memory_order_relaxed);
+        gmp_heap_account((long)new_size - (long)old_size);
+        return grown;
+    } else if (old_size <= GMP_SMALL_MAX && new_size <= GMP_SMALL_MAX &&
+               gmp_size_class(old_size) == gmp_size_class(new_size)) {
+        gmp_heap_account((long)new_size - (long)old_size);
+        return ptr; // Même classe : le bloc a déjà la bonne taille
+    }
+    void *moved = gmp_heap_alloc(new_size);
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+    gmp_heap_free(ptr, old_size);
+    atomic_fetch_sub_explicit(&gmp_totals.allocs, 1, memory_order_relaxed); // Compté comme un realloc
+    atomic_fetch_sub_explicit(&gmp_totals.frees, 1, memory_order_relaxed);
+    gmp_heap.cmd_allocs--;
+    return moved;
+}
+
+// Opération sur des opérandes d'au moins limbs limbs : la mémoire de travail de GMP vient de l'arène de commande.
+// Renvoie 1 si la portée est ouverte, à passer à gmp_scratch_end.
+int gmp_scratch_begin(size_t limbs) {
+    if (limbs < GMP_SCRATCH_LIMBS) return 0;
+    gmp_heap.scratch_depth++;
+    return 1;
+}
+
+// Fin de portée : GMP a rendu sa mémoire de travail, seul result (peut être NULL) peut encore être dans l'arène ;
+// ses limbs sont recopiés dans le tas pour qu'aucun bloc de l'arène ne survive à l'opération (ni ne change de thread)
+void gmp_scratch_end(int opened, mpz_ptr result) {
+    if (!opened) return;
+    gmp_heap.scratch_depth--;
+    if (result && gmp_in_scratch(result->_mp_d)) {
+        size_t size = (size_t)result->_mp_alloc * sizeof(mp_limb_t);
+        void *moved = gmp_heap_take(size);
+        memcpy(moved, result->_mp_d, (size_t)abs(result->_mp_size) * sizeof(mp_limb_t));
+        gmp_scratch_release(result->_mp_d, size);
+        result->_mp_d = moved;
+    }
+}
+
+// À appeler avant tout mpz_init
+void init_gmp_heap() {
+    mp_set_memory_functions(gmp_heap_alloc, gmp_heap_realloc, gmp_heap_free);
+}
+
+void gmp_heap_begin_command() {
+    gmp_heap.cmd_allocs = 0;
+    gmp_heap.cmd_bytes = 0;
+    gmp_heap.cmd_peak_bytes = 0;
+    gmp_heap.cmd_limit_bytes = active_quota->max_live_bytes;
+    gmp_heap.over_quota = 0;
+    if (gmp_heap.scratch_live == 0 && gmp_heap.scratch_size > GMP_SCRATCH_KEEP) { // Pic passé : RSS rendu
+        free(gmp_heap.scratch);
+        atomic_fetch_sub_explicit(&gmp_totals.scratch_bytes, gmp_heap.scratch_size, memory_order_relaxed);
+        gmp_heap.scratch = NULL;
+        gmp_heap.scratch_size = gmp_heap.scratch_used = 0;
+    }
+}
+
+// FORTH_MAX_RESULT_BITS, FORTH_MAX_LIVE_BYTES et FORTH_USER_QUOTAS="nick:bits:octets,..."
+void init_quotas() {
+    char *env = getenv("FORTH_MAX_RESULT_BITS");
+    if (env) default_quota.max_result_bits = strtoul(env, NULL, 10);
+    env = getenv("FORTH_MAX_LIVE_BYTES");
+    if (env) default_quota.max_live_bytes = strtoul(env, NULL, 10);
+    env = getenv("FORTH_USER_QUOTAS");
+    if (!env) return;
+    char *list = strdup(env);
+    char *saveptr;
+    for (char *entry = strtok_r(list, ",", &saveptr); entry && user_quota_count < MAX_USER_QUOTAS;
+         entry = strtok_r(NULL, ",", &saveptr)) {
+        Quota *quota = &user_quotas[user_quota_count];
+        char nick[64];
+        unsigned long bits;
+        size_t bytes;
+        if (sscanf(entry, "%63[^:]:%lu:%zu", nick, &bits, &bytes) == 3) {
+            snprintf(quota->nick, sizeof(quota->nick), "%s", nick);
+            quota->max_result_bits = bits;
+            quota->max_live_bytes = bytes;
+            user_quota_count++;
+        } else {
+            printf("Ignoring malformed quota entry: %s\n", entry);
+        }
+    }
+    free(list);
+}
+
+Quota *find_quota(const char *nick) {
+    for (int i = 0; i < user_quota_count; i++) {
+        size_t len = strcspn(nick, "@"); // « nick@réseau » : même quota que sur le premier réseau
+        if (strncmp(user_quotas[i].nick, nick, len) == 0 && user_quotas[i].nick[len] == '\0') return &user_quotas[i];
+    }
+    return &default_quota;
+}
+
+// Estimation faite avant l'opération GMP, pour ne jamais allouer le résultat
+int check_result_bits(unsigned long bits, const char *op) {
+    if (active_quota->max_result_bits && bits > active_quota->max_result_bits) {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Quota exceeded: %s result would need %lu bits (limit %lu)",
+                 op, bits, active_quota->max_result_bits);
+        set_error(msg);
+        return 0;
+    }
+    return 1;
+}
+
+long long now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+long long now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// Impute le temps écoulé à la phase en cours et passe à la suivante ; renvoie l'ancienne pour la rétablir
+int phase_switch(int phase) {
+    int previous = phase_current;
+    if (previous < 0 || previous == phase) return previous;
+    long long now = now_ns();
+    phase_ns[previous] += now - phase_since_ns;
+    phase_since_ns = now;
+    phase_current = phase;
+    return previous;
+}
+
+// Fin de commande : impute la dernière phase, arrête la mesure et renvoie l'instant
+long long phase_stop() {
+    long long now = now_ns();
+    if (phase_current >= 0) phase_ns[phase_current] += now - phase_since_ns;
+    phase_current = -1;
+    return now;
+}
+
+// FORTH_MAX_INSTRUCTIONS et FORTH_MAX_MILLISECONDS (0 = illimité)
+void init_vm_budget() {
+    char *env = getenv("FORTH_MAX_INSTRUCTIONS");
+    if (env) vm_limits.max_instructions = strtoul(env, NULL, 10);
+    env = getenv("FORTH_MAX_MILLISECONDS");
+    if (env) vm_limits.max_milliseconds = strtoul(env, NULL, 10);
+    env = getenv("FORTH_JOB_MAX_INSTRUCTIONS");
+    if (env) vm_job_limits.max_instructions = strtoul(env, NULL, 10);
+    env = getenv("FORTH_JOB_MAX_MILLISECONDS");
+    if (env) vm_job_limits.max_milliseconds = strtoul(env, NULL, 10);
+    env = getenv("FORTH_MAX_CALL_DEPTH");
+    if (env) max_call_depth = strtoul(env, NULL, 10);
+}
+
+void vm_begin_command() {
+    vm_budget = session->job ? vm_job_limits : vm_limits;
+    vm_budget.start_us = now_us();
+    // Une commande interrompue peut laisser des boucles ouvertes
+    while (session->loop_stack_top >= 0) {
+        mpz_clear(session->loop_stack[session->loop_stack_top].index);
+        mpz_clear(session->loop_stack[session->loop_stack_top].limit);
+        session->loop_stack_top--;
+    }
+}
+
+// Fin de tranche : contrôle du budget et annulation des jobs (le réseau vit dans son propre thread)
+void vm_slice_end() {
+    vm_budget.instructions += SLICE_INSTRUCTIONS - vm_budget.slice_left;
+    vm_budget.slice_left = SLICE_INSTRUCTIONS;
+    long long now = now_us();
+    unsigned long elapsed_ms = (now - vm_budget.start_us) / 1000;
+    if ((vm_budget.max_instructions && vm_budget.instructions >= vm_budget.max_instructions) ||
+        (vm_budget.max_milliseconds && elapsed_ms >= vm_budget.max_milliseconds)) {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "Budget exhausted after %lu instructions in %lu ms (limit %lu instructions, %lu ms)",
+                 vm_budget.instructions, elapsed_ms, vm_budget.max_instructions, vm_budget.max_milliseconds);
+        set_error(msg);
+        return;
+    }
+    if (session->job) {
+        atomic_store_explicit(&session->job->bytes, gmp_heap.cmd_bytes, memory_order_relaxed);
+        if (atomic_load_explicit(&session->job->cancel, memory_order_relaxed)) set_error("Job cancelled");
+    }
+}
+
 void init_mpz_pool() {
     for (int i = 0; i < MPZ_POOL_SIZE; i++) {
-        mpz_init(mpz_pool[i]);
+        mpz_init(session->mpz_pool[i]);
     }
 }
 
 void clear_mpz_pool() {
     for (int i = 0; i < MPZ_POOL_SIZE; i++) {
-        mpz_clear(mpz_pool[i]);
+        mpz_clear(session->mpz_pool[i]);
+    }
+}
+
+// Fin de commande : les temporaires (mpz_pool, cases de pile au-dessus du sommet) rendent leurs grands limbs,
+// qu'une session inactive ne garde pas la mémoire de son plus gros calcul
+void release_temporaries(Session *s) {
+    for (int i = 0; i < MPZ_POOL_SIZE; i++) {
+        if (s->mpz_pool[i]->_mp_alloc > GMP_SCRATCH_LIMBS) {
+            mpz_clear(s->mpz_pool[i]);
+            mpz_init(s->mpz_pool[i]);
+        }
     }
+    for (int i = s->stack.top + 1; i < STACK_SIZE; i++) {
+        if (s->stack.data[i]->_mp_alloc > GMP_SCRATCH_LIMBS) {
+            mpz_clear(s->stack.data[i]);
+            mpz_init(s->stack.data[i]);
+        }
+    }
+}
+
+// Taille d'une somme ou d'une différence : une retenue au plus au-delà du plus grand opérande
+static unsigned long sum_bits(mpz_t a, mpz_t b) {
+    size_t bits_a = mpz_sizeinbase(a, 2), bits_b = mpz_sizeinbase(b, 2);
+    return (bits_a > bits_b ? bits_a : bits_b) + 1;
 }
 
 void exec_arith(Instruction instr, Stack *stack) {
-    mpz_t *a = &mpz_pool[0], *b = &mpz_pool[1], *result = &mpz_pool[2];
+    mpz_t *a = &session->mpz_pool[0], *b = &session->mpz_pool[1], *result = &session->mpz_pool[2];
     switch (instr.opcode) {
         case OP_ADD:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag && check_result_bits(sum_bits(*a, *b), "+")) {
                 mpz_add(*result, *b, *a);
                 push(stack, *result);
             }
             break;
         case OP_SUB:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag && check_result_bits(sum_bits(*a, *b), "-")) {
                 mpz_sub(*result, *b, *a);
                 push(stack, *result);
             }
             break;
         case OP_MUL:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag && check_result_bits(mpz_sizeinbase(*a, 2) + mpz_sizeinbase(*b, 2), "*")) {
+                int scratch = gmp_scratch_begin(mpz_size(*a) + mpz_size(*b));
                 mpz_mul(*result, *b, *a);
+                gmp_scratch_end(scratch, *result);
                 push(stack, *result);
             }
             break;
         case OP_DIV:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 if (mpz_cmp_si(*a, 0) != 0) {
+                    int scratch = gmp_scratch_begin(mpz_size(*b));
                     mpz_div(*result, *b, *a);
+                    gmp_scratch_end(scratch, *result);
                     push(stack, *result);
                 } else {
                     set_error("Division by zero");
@@ -279,54 +1544,619 @@ void exec_arith(Instruction instr, Stack *stack) {
             break;
         case OP_MOD:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 if (mpz_cmp_si(*a, 0) != 0) {
+                    int scratch = gmp_scratch_begin(mpz_size(*b));
                     mpz_mod(*result, *b, *a);
+                    gmp_scratch_end(scratch, *result);
                     push(stack, *result);
                 } else {
                     set_error("Modulo by zero");
                 }
             }
             break;
+        default: // Appelé pour les seuls opcodes arithmétiques
+            break;
     }
 }
 
-void print_word_definition_irc(int index, Stack *stack) {
-    if (index < 0 || index >= dict_count) {
-        send_to_channel("SEE: Unknown word");
-        return;
+// Les int64 débordés sont convertis en mpz : le tableau change de type une fois pour toutes
+static int promote_cells(Memory *m) {
+    txn_memory_write(m - session->memory, -1);
+    mpz_t *values = malloc((m->size ? m->size : 1) * sizeof(mpz_t));
+    if (!values) {
+        set_error("CELLS: Memory allocation failed");
+        return 0;
     }
-    CompiledWord *word = &dictionary[index];
-    char def_msg[512] = "";
-    snprintf(def_msg, sizeof(def_msg), ": %s ", word->name);
+    for (long int i = 0; i < m->size; i++) mpz_init_set_si(values[i], m->cells[i]);
+    free(m->cells);
+    m->cells = NULL;
+    m->values = values;
+    m->type = MEMORY_ARRAY;
+    return 1;
+}
 
-    long int branch_targets[WORD_CODE_SIZE];
-    int branch_depth = 0;
-    int has_semicolon = 0;
+static void array_get(Memory *m, long int i, mpz_t out) {
+    if (m->type == MEMORY_CELLS) mpz_set_si(out, m->cells[i]);
+    else mpz_set(out, m->values[i]);
+}
 
-    for (int i = 0; i < word->code_length; i++) {
-        Instruction instr = word->code[i];
-        char instr_str[64] = "";
+static void array_set(Memory *m, long int i, const mpz_t value) {
+    txn_memory_write(m - session->memory, i);
+    if (m->type == MEMORY_CELLS) {
+        if (mpz_fits_slong_p(value)) {
+            m->cells[i] = mpz_get_si(value);
+            return;
+        }
+        if (!promote_cells(m)) return;
+    }
+    mpz_set(m->values[i], value);
+}
 
-        switch (instr.opcode) {
-            case OP_PUSH:
-                if (instr.operand < word->string_count && word->strings[instr.operand]) {
-                    snprintf(instr_str, sizeof(instr_str), "%s ", word->strings[instr.operand]);
-                } else {
-                    snprintf(instr_str, sizeof(instr_str), "%ld ", instr.operand);
-                }
-                break;
-            case OP_ADD: snprintf(instr_str, sizeof(instr_str), "+ "); break;
-            case OP_SUB: snprintf(instr_str, sizeof(instr_str), "- "); break;
-            case OP_MUL: snprintf(instr_str, sizeof(instr_str), "* "); break;
-            case OP_DIV: snprintf(instr_str, sizeof(instr_str), "/ "); break;
-            case OP_MOD: snprintf(instr_str, sizeof(instr_str), "MOD "); break;
-            case OP_DUP: snprintf(instr_str, sizeof(instr_str), "DUP "); break;
-            case OP_SWAP: snprintf(instr_str, sizeof(instr_str), "SWAP "); break;
-            case OP_OVER: snprintf(instr_str, sizeof(instr_str), "OVER "); break;
-            case OP_ROT: snprintf(instr_str, sizeof(instr_str), "ROT "); break;
-            case OP_DROP: snprintf(instr_str, sizeof(instr_str), "DROP "); break;
-            case OP_NIP: snprintf(instr_str, sizeof(instr_str), "NIP "); break;
+static void mpz_set_int128(mpz_t out, __int128 v) {
+    unsigned __int128 mag = v < 0 ? -(unsigned __int128)v : (unsigned __int128)v;
+    mpz_set_ui(out, (unsigned long)(mag >> 64));
+    mpz_mul_2exp(out, out, 64);
+    mpz_add_ui(out, out, (unsigned long)mag);
+    if (v < 0) mpz_neg(out, out);
+}
+
+// Noyaux int64 : AVX2 si le CPU le permet, SSE2 sinon, boucle scalaire hors x86-64
+enum { CELL_AND, CELL_OR, CELL_XOR };
+
+#if defined(__x86_64__)
+static int cpu_has_avx2() {
+    static int avx2 = -1;
+    if (avx2 < 0) avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+__attribute__((target("avx2")))
+static long int cells_fill_avx2(int64_t *dst, long int n, int64_t v) {
+    __m256i x = _mm256_set1_epi64x(v);
+    long int i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_si256((__m256i *)(dst + i), x);
+    return i;
+}
+
+__attribute__((target("avx2")))
+static long int cells_sum_avx2(const int64_t *src, long int n, uint64_t *lo, uint64_t *hi, uint64_t *neg) {
+    __m256i mask = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i slo = _mm256_setzero_si256(), shi = _mm256_setzero_si256(), sneg = _mm256_setzero_si256();
+    long int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(src + i));
+        slo = _mm256_add_epi64(slo, _mm256_and_si256(x, mask));
+        shi = _mm256_add_epi64(shi, _mm256_srli_epi64(x, 32));
+        sneg = _mm256_add_epi64(sneg, _mm256_srli_epi64(x, 63));
+    }
+    uint64_t l[4], h[4], g[4];
+    _mm256_storeu_si256((__m256i *)l, slo);
+    _mm256_storeu_si256((__m256i *)h, shi);
+    _mm256_storeu_si256((__m256i *)g, sneg);
+    for (int k = 0; k < 4; k++) {
+        *lo += l[k];
+        *hi += h[k];
+        *neg += g[k];
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static long int cells_bitop_avx2(int64_t *dst, const int64_t *src, long int n, int op) {
+    long int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(src + i));
+        x = op == CELL_AND ? _mm256_and_si256(x, y) : op == CELL_OR ? _mm256_or_si256(x, y) : _mm256_xor_si256(x, y);
+        _mm256_storeu_si256((__m256i *)(dst + i), x);
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+static long int cells_equal_avx2(const int64_t *a, const int64_t *b, long int n, int *equal) {
+    long int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi64(x, y)) != -1) {
+            *equal = 0;
+            return n;
+        }
+    }
+    return i;
+}
+
+static long int cells_fill_sse2(int64_t *dst, long int n, int64_t v) {
+    __m128i x = _mm_set1_epi64x(v);
+    long int i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_si128((__m128i *)(dst + i), x);
+    return i;
+}
+
+static long int cells_sum_sse2(const int64_t *src, long int n, uint64_t *lo, uint64_t *hi, uint64_t *neg) {
+    __m128i mask = _mm_set1_epi64x(0xFFFFFFFF);
+    __m128i slo = _mm_setzero_si128(), shi = _mm_setzero_si128(), sneg = _mm_setzero_si128();
+    long int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(src + i));
+        slo = _mm_add_epi64(slo, _mm_and_si128(x, mask));
+        shi = _mm_add_epi64(shi, _mm_srli_epi64(x, 32));
+        sneg = _mm_add_epi64(sneg, _mm_srli_epi64(x, 63));
+    }
+    uint64_t l[2], h[2], g[2];
+    _mm_storeu_si128((__m128i *)l, slo);
+    _mm_storeu_si128((__m128i *)h, shi);
+    _mm_storeu_si128((__m128i *)g, sneg);
+    *lo += l[0] + l[1];
+    *hi += h[0] + h[1];
+    *neg += g[0] + g[1];
+    return i;
+}
+
+static long int cells_bitop_sse2(int64_t *dst, const int64_t *src, long int n, int op) {
+    long int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(src + i));
+        x = op == CELL_AND ? _mm_and_si128(x, y) : op == CELL_OR ? _mm_or_si128(x, y) : _mm_xor_si128(x, y);
+        _mm_storeu_si128((__m128i *)(dst + i), x);
+    }
+    return i;
+}
+
+static long int cells_equal_sse2(const int64_t *a, const int64_t *b, long int n, int *equal) {
+    long int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, y)) != 0xFFFF) {
+            *equal = 0;
+            return n;
+        }
+    }
+    return i;
+}
+#endif
+
+static void cells_fill(int64_t *dst, long int n, int64_t v) {
+    long int i = 0;
+#if defined(__x86_64__)
+    i = cpu_has_avx2() ? cells_fill_avx2(dst, n, v) : cells_fill_sse2(dst, n, v);
+#endif
+    for (; i < n; i++) dst[i] = v;
+}
+
+// Somme exacte : chaque cellule vaut hi * 2^32 + lo - (négative ? 2^64 : 0)
+static void cells_sum(const int64_t *src, long int n, mpz_t out) {
+    mpz_t part;
+    mpz_init(part);
+    mpz_set_ui(out, 0);
+    for (long int start = 0; start < n; start += 1L << 30) { // Pas de débordement des accumulateurs 64 bits
+        long int count = n - start < (1L << 30) ? n - start : (1L << 30);
+        const int64_t *block = src + start;
+        uint64_t lo = 0, hi = 0, neg = 0;
+        long int i = 0;
+#if defined(__x86_64__)
+        i = cpu_has_avx2() ? cells_sum_avx2(block, count, &lo, &hi, &neg) : cells_sum_sse2(block, count, &lo, &hi, &neg);
+#endif
+        for (; i < count; i++) {
+            uint64_t x = (uint64_t)block[i];
+            lo += x & 0xFFFFFFFF;
+            hi += x >> 32;
+            neg += x >> 63;
+        }
+        mpz_set_ui(part, hi);
+        mpz_mul_2exp(part, part, 32);
+        mpz_add_ui(part, part, lo);
+        mpz_add(out, out, part);
+        mpz_set_ui(part, neg);
+        mpz_mul_2exp(part, part, 64);
+        mpz_sub(out, out, part);
+    }
+    mpz_clear(part);
+}
+
+static void cells_bitop(int64_t *dst, const int64_t *src, long int n, int op) {
+    long int i = 0;
+#if defined(__x86_64__)
+    i = cpu_has_avx2() ? cells_bitop_avx2(dst, src, n, op) : cells_bitop_sse2(dst, src, n, op);
+#endif
+    for (; i < n; i++) dst[i] = op == CELL_AND ? dst[i] & src[i] : op == CELL_OR ? dst[i] | src[i] : dst[i] ^ src[i];
+}
+
+static int cells_equal(const int64_t *a, const int64_t *b, long int n) {
+    int equal = 1;
+    long int i = 0;
+#if defined(__x86_64__)
+    i = cpu_has_avx2() ? cells_equal_avx2(a, b, n, &equal) : cells_equal_sse2(a, b, n, &equal);
+#endif
+    for (; i < n && equal; i++) equal = a[i] == b[i];
+    return equal;
+}
+
+static Memory *pop_array(Stack *stack, const char *op) {
+    pop(stack, session->mpz_pool[0]);
+    if (session->error_flag) return NULL;
+    if (mpz_fits_slong_p(session->mpz_pool[0])) {
+        long int idx = mpz_get_si(session->mpz_pool[0]);
+        if (idx >= 0 && idx < session->memory_count &&
+            (session->memory[idx].type == MEMORY_ARRAY || session->memory[idx].type == MEMORY_CELLS)) return &session->memory[idx];
+    }
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: Not an array", op);
+    set_error(msg);
+    return NULL;
+}
+
+// Mot du dictionnaire ou opérateur arithmétique appliqué par MAP et REDUCE
+static int resolve_bulk_word(const char *name, Instruction *out) {
+    static const struct { const char *name; OpCode opcode; } ops[] = {
+        {"+", OP_ADD}, {"-", OP_SUB}, {"*", OP_MUL}, {"/", OP_DIV}, {"MOD", OP_MOD},
+        {"&", OP_BIT_AND}, {"|", OP_BIT_OR}, {"^", OP_BIT_XOR}, {"~", OP_BIT_NOT}, {"NOT", OP_NOT}
+    };
+    int index = findCompiledWordIndex((char *)name);
+    if (index >= 0) {
+        *out = (Instruction){OP_CALL, index};
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strcmp(ops[i].name, name) == 0) {
+            *out = (Instruction){ops[i].opcode, 0};
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Forme SLICE : le nombre d'éléments au sommet (-1 sans SLICE)
+static long int pop_slice_count(Stack *stack, Instruction instr, const char *op) {
+    if (!(instr.operand & BULK_SLICE)) return -1;
+    pop(stack, session->mpz_pool[0]);
+    if (session->error_flag) return -1;
+    if (mpz_sgn(session->mpz_pool[0]) >= 0 && mpz_fits_slong_p(session->mpz_pool[0])) return mpz_get_si(session->mpz_pool[0]);
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: Invalid slice count", op);
+    set_error(msg);
+    return -1;
+}
+
+// Tableau entier, ou « tableau début » et count éléments avec SLICE ; *start est le premier indice
+static Memory *pop_range(Stack *stack, const char *op, long int count, long int *start) {
+    *start = 0;
+    if (count >= 0) {
+        pop(stack, session->mpz_pool[0]);
+        if (session->error_flag) return NULL;
+        *start = mpz_fits_slong_p(session->mpz_pool[0]) ? mpz_get_si(session->mpz_pool[0]) : -1;
+    }
+    Memory *arr = pop_array(stack, op);
+    if (!arr) return NULL;
+    if (count >= 0 && (*start < 0 || *start > arr->size - count)) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s: Slice out of bounds", op);
+        set_error(msg);
+        return NULL;
+    }
+    return arr;
+}
+
+// Mots de tableau qui acceptent SLICE (-1 : aucun)
+static int slice_opcode(const char *name) {
+    static const struct { const char *name; OpCode opcode; } words[] = {
+        {"FILL", OP_FILL}, {"SUM", OP_SUM}, {"DOT", OP_DOT_PRODUCT}, {"PREFIX-SUM", OP_PREFIX_SUM}, {"MINMAX", OP_MINMAX},
+        {"REVERSE", OP_REVERSE}, {"COPY", OP_COPY}, {"MAP", OP_MAP}, {"REDUCE", OP_REDUCE}
+    };
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+        if (strcmp(words[i].name, name) == 0) return words[i].opcode;
+    }
+    return -1;
+}
+
+// Une seule boucle C par tableau ou tranche, sans revalider les bornes à chaque élément
+void exec_bulk(Instruction instr, Stack *stack, CompiledWord *word, int word_index) {
+    Memory *arr, *src;
+    long int lo, src_lo, n;
+    mpz_t acc, tmp;
+    mpz_init(acc);
+    mpz_init(tmp);
+    switch (instr.opcode) {
+        case OP_FILL:
+            n = pop_slice_count(stack, instr, "FILL");
+            arr = session->error_flag ? NULL : pop_range(stack, "FILL", n, &lo);
+            if (!session->error_flag) pop(stack, tmp);
+            if (!session->error_flag) {
+                if (n < 0) n = arr->size;
+                txn_memory_write(arr - session->memory, -1);
+                if (arr->type == MEMORY_CELLS && mpz_fits_slong_p(tmp)) {
+                    cells_fill(arr->cells + lo, n, mpz_get_si(tmp));
+                    break;
+                }
+                if (arr->type == MEMORY_CELLS && !promote_cells(arr)) break;
+                for (long int i = lo; i < lo + n; i++) mpz_set(arr->values[i], tmp);
+            }
+            break;
+        case OP_SUM:
+            n = pop_slice_count(stack, instr, "SUM");
+            arr = session->error_flag ? NULL : pop_range(stack, "SUM", n, &lo);
+            if (!session->error_flag) {
+                if (n < 0) n = arr->size;
+                if (arr->type == MEMORY_CELLS) {
+                    cells_sum(arr->cells + lo, n, acc);
+                } else {
+                    for (long int i = lo; i < lo + n; i++) mpz_add(acc, acc, arr->values[i]);
+                }
+                push(stack, acc);
+            }
+            break;
+        case OP_DOT_PRODUCT:
+            n = pop_slice_count(stack, instr, "DOT");
+            arr = session->error_flag ? NULL : pop_range(stack, "DOT", n, &lo);
+            src = session->error_flag ? NULL : pop_range(stack, "DOT", n, &src_lo);
+            if (!session->error_flag) {
+                if (n < 0 && arr->size != src->size) {
+                    set_error("DOT: Arrays differ in size");
+                    break;
+                }
+                if (n < 0) n = arr->size;
+                if (arr->type == MEMORY_CELLS && src->type == MEMORY_CELLS) {
+                    __int128 partial = 0;
+                    for (long int i = 0; i < n; i++) {
+                        __int128 product = (__int128)src->cells[src_lo + i] * arr->cells[lo + i], sum;
+                        if (__builtin_add_overflow(partial, product, &sum)) {
+                            mpz_set_int128(tmp, partial); // Vidé dans l'accumulateur mpz
+                            mpz_add(acc, acc, tmp);
+                            sum = product;
+                        }
+                        partial = sum;
+                    }
+                    mpz_set_int128(tmp, partial);
+                    mpz_add(acc, acc, tmp);
+                } else {
+                    mpz_t x;
+                    mpz_init(x);
+                    for (long int i = 0; i < n; i++) {
+                        array_get(src, src_lo + i, x);
+                        array_get(arr, lo + i, tmp);
+                        if (!check_result_bits(mpz_sizeinbase(x, 2) + mpz_sizeinbase(tmp, 2), "DOT")) break;
+                        mpz_addmul(acc, x, tmp);
+                    }
+                    mpz_clear(x);
+                }
+                if (!session->error_flag) push(stack, acc);
+            }
+            break;
+        case OP_PREFIX_SUM:
+            n = pop_slice_count(stack, instr, "PREFIX-SUM");
+            arr = session->error_flag ? NULL : pop_range(stack, "PREFIX-SUM", n, &lo);
+            if (!session->error_flag) {
+                if (n < 0) n = arr->size;
+                txn_memory_write(arr - session->memory, -1);
+                long int i = lo + 1;
+                if (arr->type == MEMORY_CELLS) {
+                    for (; i < lo + n; i++) {
+                        int64_t sum;
+                        if (__builtin_add_overflow(arr->cells[i], arr->cells[i - 1], &sum)) break;
+                        arr->cells[i] = sum;
+                    }
+                    if (i >= lo + n || !promote_cells(arr)) break;
+                }
+                for (; i < lo + n; i++) mpz_add(arr->values[i], arr->values[i], arr->values[i - 1]);
+            }
+            break;
+        case OP_MINMAX:
+            n = pop_slice_count(stack, instr, "MINMAX");
+            arr = session->error_flag ? NULL : pop_range(stack, "MINMAX", n, &lo);
+            if (!session->error_flag) {
+                if (n < 0) n = arr->size;
+                if (n == 0) {
+                    set_error("MINMAX: Empty array");
+                    break;
+                }
+                if (arr->type == MEMORY_CELLS) {
+                    int64_t min = arr->cells[lo], max = arr->cells[lo];
+                    for (long int i = lo + 1; i < lo + n; i++) {
+                        if (arr->cells[i] < min) min = arr->cells[i];
+                        if (arr->cells[i] > max) max = arr->cells[i];
+                    }
+                    mpz_set_si(acc, min);
+                    mpz_set_si(tmp, max);
+                    push(stack, acc);
+                    push(stack, tmp);
+                    break;
+                }
+                long int min = lo, max = lo;
+                for (long int i = lo + 1; i < lo + n; i++) {
+                    if (mpz_cmp(arr->values[i], arr->values[min]) < 0) min = i;
+                    else if (mpz_cmp(arr->values[i], arr->values[max]) > 0) max = i;
+                }
+                push(stack, arr->values[min]);
+                push(stack, arr->values[max]);
+            }
+            break;
+        case OP_REVERSE:
+            n = pop_slice_count(stack, instr, "REVERSE");
+            arr = session->error_flag ? NULL : pop_range(stack, "REVERSE", n, &lo);
+            if (!session->error_flag) {
+                if (n < 0) n = arr->size;
+                txn_memory_write(arr - session->memory, -1);
+                for (long int i = lo, j = lo + n - 1; i < j; i++, j--) {
+                    if (arr->type == MEMORY_CELLS) {
+                        int64_t swap = arr->cells[i];
+                        arr->cells[i] = arr->cells[j];
+                        arr->cells[j] = swap;
+                    } else {
+                        mpz_swap(arr->values[i], arr->values[j]);
+                    }
+                }
+            }
+            break;
+        case OP_COPY:
+            n = pop_slice_count(stack, instr, "COPY");
+            arr = session->error_flag ? NULL : pop_range(stack, "COPY", n, &lo); // Destination
+            src = session->error_flag ? NULL : pop_range(stack, "COPY", n, &src_lo);
+            if (!session->error_flag) {
+                if (n < 0 && arr->size < src->size) {
+                    set_error("COPY: Destination too small");
+                    break;
+                }
+                if (n < 0) n = src->size;
+                if (arr->type == MEMORY_CELLS && src->type == MEMORY_CELLS) {
+                    txn_memory_write(arr - session->memory, -1);
+                    memmove(arr->cells + lo, src->cells + src_lo, n * sizeof(int64_t));
+                } else if (arr == src && lo > src_lo) { // Tranches qui se chevauchent : par la fin
+                    for (long int i = n - 1; i >= 0 && !session->error_flag; i--) {
+                        array_get(src, src_lo + i, tmp);
+                        array_set(arr, lo + i, tmp);
+                    }
+                } else {
+                    for (long int i = 0; i < n && !session->error_flag; i++) {
+                        array_get(src, src_lo + i, tmp);
+                        array_set(arr, lo + i, tmp);
+                    }
+                }
+            }
+            break;
+        case OP_MAP:
+        case OP_REDUCE: {
+            const char *op = instr.opcode == OP_MAP ? "MAP" : "REDUCE";
+            long int name = instr.operand & ~BULK_SLICE;
+            Instruction apply;
+            n = pop_slice_count(stack, instr, op);
+            arr = session->error_flag ? NULL : pop_range(stack, op, n, &lo);
+            if (session->error_flag) break;
+            if (n < 0) n = arr->size;
+            if (name < 0 || name >= word->string_count || !resolve_bulk_word(word->strings[name], &apply)) {
+                char msg[256]; // set_error préfixe "Error: " dans 512 octets
+                snprintf(msg, sizeof(msg), "%s: Unknown word: %s", op, name >= 0 && name < word->string_count ? word->strings[name] : "?");
+                set_error(msg);
+                break;
+            }
+            long int ip = 0;
+            if (instr.opcode == OP_MAP) {
+                for (long int i = lo; i < lo + n && !session->error_flag; i++) {
+                    array_get(arr, i, tmp);
+                    push(stack, tmp);
+                    executeInstruction(apply, stack, &ip, word, word_index);
+                    pop(stack, tmp);
+                    if (!session->error_flag) array_set(arr, i, tmp);
+                }
+            } else if (n == 0) {
+                set_error("REDUCE: Empty array");
+            } else {
+                array_get(arr, lo, tmp);
+                push(stack, tmp);
+                for (long int i = lo + 1; i < lo + n && !session->error_flag; i++) {
+                    array_get(arr, i, tmp);
+                    push(stack, tmp);
+                    executeInstruction(apply, stack, &ip, word, word_index);
+                }
+            }
+            break;
+        }
+        case OP_ARRAY_AND:
+        case OP_ARRAY_OR:
+        case OP_ARRAY_XOR: {
+            const char *op = instr.opcode == OP_ARRAY_AND ? "ARRAY-AND" : instr.opcode == OP_ARRAY_OR ? "ARRAY-OR" : "ARRAY-XOR";
+            arr = pop_array(stack, op); // Destination
+            src = session->error_flag ? NULL : pop_array(stack, op);
+            if (session->error_flag) break;
+            if (arr->size != src->size) {
+                char msg[128];
+                snprintf(msg, sizeof(msg), "%s: Arrays differ in size", op);
+                set_error(msg);
+                break;
+            }
+            if (arr->type == MEMORY_CELLS && src->type == MEMORY_CELLS) {
+                txn_memory_write(arr - session->memory, -1);
+                cells_bitop(arr->cells, src->cells, arr->size,
+                            instr.opcode == OP_ARRAY_AND ? CELL_AND : instr.opcode == OP_ARRAY_OR ? CELL_OR : CELL_XOR);
+                break;
+            }
+            mpz_t x;
+            mpz_init(x);
+            for (long int i = 0; i < arr->size && !session->error_flag; i++) {
+                array_get(src, i, x);
+                array_get(arr, i, tmp);
+                if (instr.opcode == OP_ARRAY_AND) mpz_and(tmp, tmp, x);
+                else if (instr.opcode == OP_ARRAY_OR) mpz_ior(tmp, tmp, x);
+                else mpz_xor(tmp, tmp, x);
+                array_set(arr, i, tmp);
+            }
+            mpz_clear(x);
+            break;
+        }
+        case OP_ARRAY_EQ:
+            arr = pop_array(stack, "ARRAY=");
+            src = session->error_flag ? NULL : pop_array(stack, "ARRAY=");
+            if (!session->error_flag) {
+                int equal = arr->size == src->size;
+                if (equal && arr->type == MEMORY_CELLS && src->type == MEMORY_CELLS) {
+                    equal = cells_equal(src->cells, arr->cells, arr->size);
+                } else {
+                    for (long int i = 0; i < arr->size && equal; i++) {
+                        array_get(src, i, acc);
+                        array_get(arr, i, tmp);
+                        equal = mpz_cmp(acc, tmp) == 0;
+                    }
+                }
+                mpz_set_si(acc, equal ? 1 : 0);
+                push(stack, acc);
+            }
+            break;
+        default: // Appelé pour les seuls mots de tableau
+            break;
+    }
+    mpz_clear(acc);
+    mpz_clear(tmp);
+}
+
+void print_word_definition_irc(int index, Stack *stack) {
+    if (index < 0 || index >= session->dict_count) {
+        send_to_channel("SEE: Unknown word");
+        return;
+    }
+    CompiledWord *word = session->dictionary[index];
+    char def_msg[512] = "";
+    if (word->generator) {
+        snprintf(def_msg, sizeof(def_msg), "GENERATOR %s ", word->name);
+        if (word->generator_args > 0) {
+            strncat(def_msg, "( ", sizeof(def_msg) - strlen(def_msg) - 1);
+            for (long int i = 0; i < word->generator_args && i < 16; i++) strncat(def_msg, "x ", sizeof(def_msg) - strlen(def_msg) - 1);
+            strncat(def_msg, "-- ) ", sizeof(def_msg) - strlen(def_msg) - 1);
+        }
+    } else {
+        snprintf(def_msg, sizeof(def_msg), ": %s ", word->name);
+    }
+
+    long int branch_targets[WORD_CODE_SIZE];
+    int branch_depth = 0;
+    int has_semicolon = 0;
+
+    for (int i = 0; i < word->code_length; i++) {
+        Instruction instr = word->code[i];
+        char instr_str[64] = "";
+        const char *slice = instr.operand & BULK_SLICE ? "SLICE " : ""; // Mots de tableau seulement
+
+        switch (instr.opcode) {
+            case OP_PUSH:
+                if (instr.operand < word->string_count && word->strings[instr.operand]) {
+                    snprintf(instr_str, sizeof(instr_str), "%s ", word->strings[instr.operand]);
+                } else {
+                    snprintf(instr_str, sizeof(instr_str), "%ld ", instr.operand);
+                }
+                break;
+            case OP_ADD: snprintf(instr_str, sizeof(instr_str), "+ "); break;
+            case OP_SUB: snprintf(instr_str, sizeof(instr_str), "- "); break;
+            case OP_MUL: snprintf(instr_str, sizeof(instr_str), "* "); break;
+            case OP_DIV: snprintf(instr_str, sizeof(instr_str), "/ "); break;
+            case OP_MOD: snprintf(instr_str, sizeof(instr_str), "MOD "); break;
+            case OP_DUP: snprintf(instr_str, sizeof(instr_str), "DUP "); break;
+            case OP_SWAP: snprintf(instr_str, sizeof(instr_str), "SWAP "); break;
+            case OP_OVER: snprintf(instr_str, sizeof(instr_str), "OVER "); break;
+            case OP_ROT: snprintf(instr_str, sizeof(instr_str), "ROT "); break;
+            case OP_DROP: snprintf(instr_str, sizeof(instr_str), "DROP "); break;
+            case OP_NIP: snprintf(instr_str, sizeof(instr_str), "NIP "); break;
             case OP_DOT: snprintf(instr_str, sizeof(instr_str), ". "); break;
             case OP_DOT_S: snprintf(instr_str, sizeof(instr_str), ".S "); break;
             case OP_DOT_QUOTE:
@@ -371,8 +2201,8 @@ void print_word_definition_irc(int index, Stack *stack) {
                 }
                 break;
             case OP_CALL:
-                if (instr.operand < dict_count) {
-                    snprintf(instr_str, sizeof(instr_str), "%s ", dictionary[instr.operand].name);
+                if (instr.operand < session->dict_count) {
+                    snprintf(instr_str, sizeof(instr_str), "%s ", session->dictionary[instr.operand]->name);
                 } else {
                     snprintf(instr_str, sizeof(instr_str), "(CALL %ld) ", instr.operand);
                 }
@@ -410,6 +2240,46 @@ void print_word_definition_irc(int index, Stack *stack) {
                 if (branch_depth > 0) branch_depth--; // Ferme l’OF
                 break;
             case OP_ENDCASE: snprintf(instr_str, sizeof(instr_str), "ENDCASE "); break;
+            case OP_SET_BASE:
+                switch (instr.operand) {
+                    case 16: snprintf(instr_str, sizeof(instr_str), "HEX "); break;
+                    case 2: snprintf(instr_str, sizeof(instr_str), "BINARY "); break;
+                    case 8: snprintf(instr_str, sizeof(instr_str), "OCTAL "); break;
+                    default: snprintf(instr_str, sizeof(instr_str), "DECIMAL "); break;
+                }
+                break;
+            case OP_MEMSTATS: snprintf(instr_str, sizeof(instr_str), "MEMSTATS "); break;
+            case OP_QUEUESTATS: snprintf(instr_str, sizeof(instr_str), "QUEUESTATS "); break;
+            case OP_CACHESTATS: snprintf(instr_str, sizeof(instr_str), "CACHESTATS "); break;
+            case OP_STATS: snprintf(instr_str, sizeof(instr_str), "STATS "); break;
+            case OP_PROFILE:
+                snprintf(instr_str, sizeof(instr_str), "PROFILE %s ",
+                         instr.operand == PROFILE_ON ? "ON" : instr.operand == PROFILE_OFF ? "OFF" : "REPORT");
+                break;
+            case OP_PROFILE_DUMP: snprintf(instr_str, sizeof(instr_str), "PROFILE-DUMP "); break;
+            case OP_JOBS: snprintf(instr_str, sizeof(instr_str), "JOBS "); break;
+            case OP_KILL: snprintf(instr_str, sizeof(instr_str), "KILL "); break;
+            case OP_RESULT: snprintf(instr_str, sizeof(instr_str), "RESULT "); break;
+            case OP_YIELD: snprintf(instr_str, sizeof(instr_str), "YIELD "); break;
+            case OP_NEXT: snprintf(instr_str, sizeof(instr_str), "NEXT "); break;
+            case OP_TAKE: snprintf(instr_str, sizeof(instr_str), "TAKE "); break;
+            case OP_FILL: snprintf(instr_str, sizeof(instr_str), "%sFILL ", slice); break;
+            case OP_SUM: snprintf(instr_str, sizeof(instr_str), "%sSUM ", slice); break;
+            case OP_DOT_PRODUCT: snprintf(instr_str, sizeof(instr_str), "%sDOT ", slice); break;
+            case OP_PREFIX_SUM: snprintf(instr_str, sizeof(instr_str), "%sPREFIX-SUM ", slice); break;
+            case OP_MINMAX: snprintf(instr_str, sizeof(instr_str), "%sMINMAX ", slice); break;
+            case OP_REVERSE: snprintf(instr_str, sizeof(instr_str), "%sREVERSE ", slice); break;
+            case OP_COPY: snprintf(instr_str, sizeof(instr_str), "%sCOPY ", slice); break;
+            case OP_CELLS_ALLOT: snprintf(instr_str, sizeof(instr_str), "CELLS-ALLOT "); break;
+            case OP_ARRAY_AND: snprintf(instr_str, sizeof(instr_str), "ARRAY-AND "); break;
+            case OP_ARRAY_OR: snprintf(instr_str, sizeof(instr_str), "ARRAY-OR "); break;
+            case OP_ARRAY_XOR: snprintf(instr_str, sizeof(instr_str), "ARRAY-XOR "); break;
+            case OP_ARRAY_EQ: snprintf(instr_str, sizeof(instr_str), "ARRAY= "); break;
+            case OP_MAP:
+            case OP_REDUCE:
+                snprintf(instr_str, sizeof(instr_str), "%s%s %s ", slice, instr.opcode == OP_MAP ? "MAP" : "REDUCE",
+                         (instr.operand & ~BULK_SLICE) < word->string_count ? word->strings[instr.operand & ~BULK_SLICE] : "???");
+                break;
             default: snprintf(instr_str, sizeof(instr_str), "(OP_%d) ", instr.opcode); break;
         }
 
@@ -424,54 +2294,123 @@ void print_word_definition_irc(int index, Stack *stack) {
     if (!has_semicolon) {
         strncat(def_msg, ";", sizeof(def_msg) - strlen(def_msg) - 1);
     }
+    if (word->memo) strncat(def_msg, def_msg[strlen(def_msg) - 1] == ' ' ? "MEMO" : " MEMO", sizeof(def_msg) - strlen(def_msg) - 1);
     send_to_channel(def_msg);
 }
-void send_to_channel(const char *msg) {
-    if (irc_socket != -1) {
-        char response[512];
-        size_t msg_len = strlen(msg);
-        size_t chunk_size = 400;
-        size_t offset = 0;
-
-        while (offset < msg_len) {
-            size_t remaining = msg_len - offset;
-            size_t current_chunk_size = (remaining > chunk_size) ? chunk_size : remaining;
-            // Si présence d'espaces, couper au dernier espace avant chunk_size
-            if (current_chunk_size < remaining && strchr(msg + offset, ' ') != NULL) {
-                for (size_t i = current_chunk_size; i > 0; i--) {
-                    if (msg[offset + i] == ' ') {
-                        current_chunk_size = i;
-                        break;
-                    }
+// Réponses d'une commande regroupées en un seul tampon de lignes PRIVMSG, une seule entrée dans output_queue
+void output_flush() {
+    if (output_batch.len == 0) return;
+    char *data = output_batch.data;
+    output_batch.data = NULL;
+    output_batch.len = output_batch.cap = 0;
+    while (!mpsc_push(&output_queue, data)) {
+        usleep(1000); // File pleine : le thread réseau est en retard
+    }
+}
+
+static void output_line(const char *target, size_t target_len, const char *text, size_t len) {
+    if (output_batch.len > 0 && (output_batch.data[0] != '0' + output_lane || output_batch.data[1] != '0' + reply_network)) {
+        output_flush(); // Changement de voie ou de réseau
+    }
+    size_t need = output_batch.len + 2 + 8 + target_len + 2 + len + 2 + 1;
+    if (need > output_batch.cap) {
+        size_t cap = output_batch.cap ? output_batch.cap * 2 : 1024;
+        while (cap < need) cap *= 2;
+        char *data = realloc(output_batch.data, cap);
+        if (!data) return;
+        output_batch.data = data;
+        output_batch.cap = cap;
+    }
+    if (output_batch.len == 0) {
+        output_batch.data[output_batch.len++] = '0' + output_lane;
+        output_batch.data[output_batch.len++] = '0' + reply_network;
+        output_batch.first_us = now_us();
+    }
+    char *p = output_batch.data + output_batch.len;
+    memcpy(p, "PRIVMSG ", 8);
+    memcpy(p + 8, target, target_len);
+    memcpy(p + 8 + target_len, " :", 2);
+    memcpy(p + 10 + target_len, text, len);
+    memcpy(p + 10 + target_len + len, "\r\n", 3);
+    output_batch.len += 12 + target_len + len;
+}
+
+// Appelé par les threads de travail : les lignes partent par output_queue
+static void send_lines(const char *msg) {
+    if (sandbox_fd >= 0) {
+        sandbox_send('O', msg, strlen(msg)); // Relayé par le parent
+        return;
+    }
+    if (session->cache_rec) result_cache_record(msg);
+    if (session->job) {
+        job_capture(session->job, msg);
+        return;
+    }
+    // Lignes de OUTPUT_CHUNK caractères au plus, coupées au dernier espace si possible ; une passe linéaire
+    size_t msg_len = strlen(msg);
+    size_t target_len = strlen(reply_target);
+    size_t offset = 0;
+    while (offset < msg_len) {
+        size_t chunk = msg_len - offset;
+        if (chunk > OUTPUT_CHUNK) {
+            chunk = OUTPUT_CHUNK;
+            for (size_t i = OUTPUT_CHUNK; i > 0; i--) {
+                if (msg[offset + i] == ' ') {
+                    chunk = i;
+                    break;
                 }
             }
-            char chunk[401];
-            strncpy(chunk, msg + offset, current_chunk_size);
-            chunk[current_chunk_size] = '\0';
-            snprintf(response, sizeof(response), "PRIVMSG %s :%s\r\n", CHANNEL, chunk);
-            if (send(irc_socket, response, strlen(response), 0) < 0) {
-                printf("Failed to send to channel: %s\n", chunk);
-                break;
-            }
-            offset += current_chunk_size;
-            // Passe les espaces uniquement si on en a trouvé
-            while (offset < msg_len && msg[offset] == ' ') offset++;
         }
-    } else {
-        printf("IRC socket not initialized\n");
+        output_line(reply_target, target_len, msg + offset, chunk);
+        offset += chunk;
+        while (offset < msg_len && msg[offset] == ' ') offset++;
     }
+    if (!output_batching || output_batch.len >= OUTPUT_BATCH_MAX ||
+        now_us() - output_batch.first_us >= OUTPUT_BATCH_MILLISECONDS * 1000LL) {
+        output_flush();
+    }
+}
+
+void send_to_channel(const char *msg) {
+    int previous = phase_switch(PHASE_SEND);
+    send_lines(msg);
+    phase_switch(previous);
 }
 void buffer_char(char c) {
-    if (emit_buffer_pos < sizeof(emit_buffer) - 1) {
-        emit_buffer[emit_buffer_pos++] = c;
-        emit_buffer[emit_buffer_pos] = '\0'; // Terminateur
+    if (session->emit_buffer_pos < sizeof(session->emit_buffer) - 1) {
+        session->emit_buffer[session->emit_buffer_pos++] = c;
+        session->emit_buffer[session->emit_buffer_pos] = '\0'; // Terminateur
     } else {
         set_error("EMIT: Buffer full");
     }
 }
+// Opcodes qui ne lisent ni n'écrivent rien d'autre que la pile (OP_CALL : selon le mot appelé).
+// I, DO et LOOP lisent la pile de boucles, qui peut appartenir à l'appelant : pas purs.
+int opcode_is_pure(OpCode op) {
+    switch (op) {
+        case OP_PUSH: case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
+        case OP_DUP: case OP_SWAP: case OP_OVER: case OP_ROT: case OP_DROP: case OP_NIP:
+        case OP_EQ: case OP_LT: case OP_GT: case OP_AND: case OP_OR: case OP_NOT:
+        case OP_BIT_AND: case OP_BIT_OR: case OP_BIT_XOR: case OP_BIT_NOT: case OP_LSHIFT: case OP_RSHIFT:
+        case OP_BRANCH_FALSE: case OP_BRANCH: case OP_END: case OP_EXIT:
+        case OP_BEGIN: case OP_WHILE: case OP_REPEAT: case OP_CASE: case OP_OF: case OP_ENDOF: case OP_ENDCASE:
+        case OP_RECURSE: case OP_CALL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledWord *word, int word_index) {
-    if (error_flag) return;
-    mpz_t *a = &mpz_pool[0], *b = &mpz_pool[1], *result = &mpz_pool[2];
+    if (session->error_flag) return;
+    if (sandbox_fd >= 0 && sandbox_delegate(instr, stack)) return;
+    // La pile de boucles est vidée à chaque commande : une ligne entière reste déterministe avec I/DO/LOOP
+    if (session->cache_rec && !opcode_is_pure(instr.opcode) &&
+        instr.opcode != OP_DOT && instr.opcode != OP_CR && instr.opcode != OP_DOT_QUOTE &&
+        instr.opcode != OP_I && instr.opcode != OP_DO && instr.opcode != OP_LOOP) {
+        session->cache_rec = 0; // Résultat dépendant de l'état de la session : pas de cache
+    }
+    mpz_t *a = &session->mpz_pool[0], *b = &session->mpz_pool[1], *result = &session->mpz_pool[2];
 
     switch (instr.opcode) {
         case OP_PUSH:
@@ -488,23 +2427,28 @@ void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledW
         case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
             exec_arith(instr, stack);
             break;
+        case OP_FILL: case OP_SUM: case OP_DOT_PRODUCT: case OP_PREFIX_SUM: case OP_MINMAX:
+        case OP_REVERSE: case OP_COPY: case OP_MAP: case OP_REDUCE:
+        case OP_ARRAY_AND: case OP_ARRAY_OR: case OP_ARRAY_XOR: case OP_ARRAY_EQ:
+            exec_bulk(instr, stack, word, word_index);
+            break;
         case OP_DUP:
             pop(stack, *a);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 push(stack, *a);
                 push(stack, *a);
             }
             break;
         case OP_SWAP:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 push(stack, *a);
                 push(stack, *b);
             }
             break;
         case OP_OVER:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 push(stack, *b);
                 push(stack, *a);
                 push(stack, *b);
@@ -515,6 +2459,8 @@ void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledW
                 mpz_set(*a, stack->data[stack->top - 2]);
                 mpz_set(*b, stack->data[stack->top - 1]);
                 mpz_set(*result, stack->data[stack->top]);
+                txn_stack_write(stack, stack->top - 2);
+                if (stack->top - 3 < session->memo_low) session->memo_low = stack->top - 3;
                 mpz_set(stack->data[stack->top - 2], *b);
                 mpz_set(stack->data[stack->top - 1], *result);
                 mpz_set(stack->data[stack->top], *a);
@@ -527,31 +2473,34 @@ void executeInstruction(Instruction instr, Stack *stack, long int *ip, CompiledW
             break;
         case OP_NIP:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 push(stack, *a);
             }
             break;
 case OP_DOT:
     if (stack->top >= 0) {
         pop(stack, *a);
-        char dot_msg[1024] = {0}; // Zéro pour éviter résidus
-        int written = gmp_snprintf(dot_msg, sizeof(dot_msg), "%Zd", *a);
-        if (written < 0 || written >= sizeof(dot_msg)) {
+        char *dot_msg = format_number(*a);
+        if (!dot_msg || strlen(dot_msg) >= 1024) {
             send_to_channel("<overflow>");
         } else {
             send_to_channel(dot_msg); // Chunking géré par send_to_channel
         }
+        free(dot_msg);
     } else {
         send_to_channel("Stack empty");
+        session->cache_rec = 0; // Réponse qui dépend de la profondeur de pile, pas des jetons
     }
     break;
         case OP_DOT_S:
             if (stack->top >= 0) {
                 char stack_msg[1024] = "Stack: ";
                 for (int i = 0; i <= stack->top; i++) {
-                    char num[64];
-                    gmp_snprintf(num, sizeof(num), "%Zd ", stack->data[i]);
+                    char *num = format_number(stack->data[i]);
+                    if (!num) break;
                     strncat(stack_msg, num, sizeof(stack_msg) - strlen(stack_msg) - 1);
+                    strncat(stack_msg, " ", sizeof(stack_msg) - strlen(stack_msg) - 1);
+                    free(num);
                 }
                 send_to_channel(stack_msg);
             } else {
@@ -566,10 +2515,10 @@ case OP_DOT_QUOTE:
             }
             break;
 case OP_CR:
-    if (emit_buffer_pos > 0) {
-        send_to_channel(emit_buffer);
-        emit_buffer[0] = '\0'; // Réinitialise le buffer
-        emit_buffer_pos = 0;
+    if (session->emit_buffer_pos > 0) {
+        send_to_channel(session->emit_buffer);
+        session->emit_buffer[0] = '\0'; // Réinitialise le buffer
+        session->emit_buffer_pos = 0;
     } else {
         send_to_channel(""); // Envoie une ligne vide si rien dans le buffer
     }
@@ -579,48 +2528,48 @@ case OP_CR:
             break;
         case OP_EQ:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_set_si(*result, mpz_cmp(*b, *a) == 0 ? 1 : 0);
                 push(stack, *result);
             }
             break;
         case OP_LT:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_set_si(*result, mpz_cmp(*b, *a) < 0 ? 1 : 0);
                 push(stack, *result);
             }
             break;
         case OP_GT:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_set_si(*result, mpz_cmp(*b, *a) > 0 ? 1 : 0);
                 push(stack, *result);
             }
             break;
         case OP_AND:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_set_si(*result, (mpz_cmp_si(*b, 0) != 0 && mpz_cmp_si(*a, 0) != 0) ? 1 : 0);
                 push(stack, *result);
             }
             break;
         case OP_OR:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_set_si(*result, (mpz_cmp_si(*b, 0) != 0 || mpz_cmp_si(*a, 0) != 0) ? 1 : 0);
                 push(stack, *result);
             }
             break;
         case OP_NOT:
             pop(stack, *a);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_set_si(*result, mpz_cmp_si(*a, 0) == 0 ? 1 : 0);
                 push(stack, *result);
             }
             break;
         case OP_I:
-            if (loop_stack_top >= 0) push(stack, loop_stack[loop_stack_top].index);
+            if (session->loop_stack_top >= 0) push(stack, session->loop_stack[session->loop_stack_top].index);
             else set_error("I used outside of a loop");
             break;
         case OP_DO:
@@ -630,24 +2579,24 @@ case OP_CR:
             }
             pop(stack, *b); // Start
             pop(stack, *a); // Limit
-            if (!error_flag && loop_stack_top < LOOP_STACK_SIZE - 1) {
-                loop_stack_top++;
-                mpz_init_set(loop_stack[loop_stack_top].index, *b);
-                mpz_init_set(loop_stack[loop_stack_top].limit, *a);
-                loop_stack[loop_stack_top].addr = *ip + 1;
-            } else if (!error_flag) {
+            if (!session->error_flag && session->loop_stack_top < LOOP_STACK_SIZE - 1) {
+                session->loop_stack_top++;
+                mpz_init_set(session->loop_stack[session->loop_stack_top].index, *b);
+                mpz_init_set(session->loop_stack[session->loop_stack_top].limit, *a);
+                session->loop_stack[session->loop_stack_top].addr = *ip + 1;
+            } else if (!session->error_flag) {
                 set_error("Loop stack overflow");
             }
             break;
         case OP_LOOP:
-            if (loop_stack_top >= 0) {
-                mpz_add_ui(loop_stack[loop_stack_top].index, loop_stack[loop_stack_top].index, 1);
-                if (mpz_cmp(loop_stack[loop_stack_top].index, loop_stack[loop_stack_top].limit) < 0) {
-                    *ip = loop_stack[loop_stack_top].addr - 1;
+            if (session->loop_stack_top >= 0) {
+                mpz_add_ui(session->loop_stack[session->loop_stack_top].index, session->loop_stack[session->loop_stack_top].index, 1);
+                if (mpz_cmp(session->loop_stack[session->loop_stack_top].index, session->loop_stack[session->loop_stack_top].limit) < 0) {
+                    *ip = session->loop_stack[session->loop_stack_top].addr - 1;
                 } else {
-                    mpz_clear(loop_stack[loop_stack_top].index);
-                    mpz_clear(loop_stack[loop_stack_top].limit);
-                    loop_stack_top--;
+                    mpz_clear(session->loop_stack[session->loop_stack_top].index);
+                    mpz_clear(session->loop_stack[session->loop_stack_top].limit);
+                    session->loop_stack_top--;
                 }
             } else {
                 set_error("LOOP without DO");
@@ -655,14 +2604,14 @@ case OP_CR:
             break;
         case OP_BRANCH_FALSE:
             pop(stack, *a);
-            if (!error_flag && mpz_cmp_si(*a, 0) == 0) *ip = instr.operand - 1;
+            if (!session->error_flag && mpz_cmp_si(*a, 0) == 0) *ip = instr.operand - 1;
             break;
         case OP_BRANCH:
             *ip = instr.operand - 1;
             break;
         case OP_CALL:
-            if (instr.operand >= 0 && instr.operand < dict_count) {
-                executeCompiledWord(&dictionary[instr.operand], stack, instr.operand);
+            if (instr.operand >= 0 && instr.operand < session->dict_count) {
+                executeCompiledWord(session->dictionary[instr.operand], stack, instr.operand);
             } else if (instr.operand >= 0 && instr.operand < word->string_count) {
                 FILE *file = fopen(word->strings[instr.operand], "r");
                 if (!file) {
@@ -685,7 +2634,7 @@ case OP_CR:
             break;
         case OP_OF:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag && mpz_cmp(*a, *b) != 0) {
+            if (!session->error_flag && mpz_cmp(*a, *b) != 0) {
                 push(stack, *b);
                 *ip = instr.operand - 1;
             }
@@ -703,7 +2652,7 @@ case OP_CR:
             break;
         case OP_WHILE:
             pop(stack, *a);
-            if (!error_flag && mpz_cmp_si(*a, 0) == 0) {
+            if (!session->error_flag && mpz_cmp_si(*a, 0) == 0) {
                 *ip = instr.operand - 1;
             }
             break;
@@ -712,55 +2661,59 @@ case OP_CR:
             break;
         case OP_BIT_AND:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_and(*result, *b, *a);
                 push(stack, *result);
             }
             break;
         case OP_BIT_OR:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_ior(*result, *b, *a);
                 push(stack, *result);
             }
             break;
         case OP_BIT_XOR:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_xor(*result, *b, *a);
                 push(stack, *result);
             }
             break;
         case OP_BIT_NOT:
             pop(stack, *a);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_com(*result, *a);
                 push(stack, *result);
             }
             break;
         case OP_LSHIFT:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
-                mpz_mul_2exp(*result, *b, mpz_get_ui(*a));
-                push(stack, *result);
+            if (!session->error_flag) {
+                if (!mpz_fits_ulong_p(*a)) {
+                    set_error("LSHIFT: Invalid shift count");
+                } else if (check_result_bits(mpz_sizeinbase(*b, 2) + mpz_get_ui(*a), "LSHIFT")) {
+                    mpz_mul_2exp(*result, *b, mpz_get_ui(*a));
+                    push(stack, *result);
+                }
             }
             break;
         case OP_RSHIFT:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 mpz_tdiv_q_2exp(*result, *b, mpz_get_ui(*a));
                 push(stack, *result);
             }
             break;
 case OP_WORDS:
-    if (dict_count > 0) {
+    if (session->dict_count > 0) {
         char words_msg[512] = "";
         size_t remaining = sizeof(words_msg) - 1;
-        for (int i = 0; i < dict_count && remaining > 1; i++) {
-            if (dictionary[i].name) {
-                size_t name_len = strlen(dictionary[i].name);
+        for (int i = 0; i < session->dict_count && remaining > 1; i++) {
+            if (session->dictionary[i]->name) {
+                size_t name_len = strlen(session->dictionary[i]->name);
                 if (name_len + 1 < remaining) {
-                    strncat(words_msg, dictionary[i].name, remaining);
+                    strncat(words_msg, session->dictionary[i]->name, remaining);
                     strncat(words_msg, " ", remaining - name_len);
                     remaining -= (name_len + 1);
                 } else {
@@ -778,197 +2731,227 @@ case OP_WORDS:
     }
     break;
         case OP_FORGET:
-            if (instr.operand >= 0 && instr.operand < dict_count) {
-                for (int i = instr.operand; i < dict_count; i++) {
-                    if (dictionary[i].name) {
-                        free(dictionary[i].name);
-                        dictionary[i].name = NULL;
-                    }
-                    for (int j = 0; j < dictionary[i].string_count; j++) {
-                        if (dictionary[i].strings[j]) {
-                            free(dictionary[i].strings[j]);
-                            dictionary[i].strings[j] = NULL;
-                        }
-                    }
+            if (instr.operand >= 0 && instr.operand < session->dict_count) {
+                memo_reset(&session->memo);
+                dict_changed();
+                for (int i = instr.operand; i < session->dict_count; i++) {
+                    txn_word_write(i);
+                    forget_word(i);
                 }
-                dict_count = instr.operand;
+                session->dict_count = instr.operand;
             } else {
                 set_error("FORGET: Word index out of range");
             }
             break;
         case OP_VARIABLE:
-            if (memory_count < VAR_SIZE) {
-                memory[memory_count].name = strdup(word->strings[instr.operand]);
-                memory[memory_count].type = MEMORY_VARIABLE;
-                memory[memory_count].size = 1;
-                memory[memory_count].values = malloc(1 * sizeof(mpz_t));
-                if (!memory[memory_count].values) {
+            if (session->memory_count < VAR_SIZE) {
+                session->memory[session->memory_count].name = strdup(word->strings[instr.operand]);
+                session->memory[session->memory_count].type = MEMORY_VARIABLE;
+                session->memory[session->memory_count].size = 1;
+                session->memory[session->memory_count].values = malloc(1 * sizeof(mpz_t));
+                if (!session->memory[session->memory_count].values) {
                     set_error("VARIABLE: Memory allocation failed");
                     break;
                 }
-                mpz_init(memory[memory_count].values[0]);
-                mpz_set_ui(memory[memory_count].values[0], 0);
-                Instruction var_code[1] = {{OP_PUSH, memory_count}};
+                mpz_init(session->memory[session->memory_count].values[0]);
+                mpz_set_ui(session->memory[session->memory_count].values[0], 0);
+                Instruction var_code[1] = {{OP_PUSH, session->memory_count}};
                 char *var_strings[1] = {NULL};
-                addCompiledWord(memory[memory_count].name, var_code, 1, var_strings, 0);
-                mpz_set_si(*result, memory_count);
+                addCompiledWord(session->memory[session->memory_count].name, var_code, 1, var_strings, 0);
+                mpz_set_si(*result, session->memory_count);
                 push(stack, *result);
-                memory_count++;
+                session->memory_count++;
             } else {
                 set_error("Memory table full");
             }
             break;
         case OP_CREATE:
-            if (memory_count < VAR_SIZE) {
-                memory[memory_count].name = strdup(word->strings[instr.operand]);
-                memory[memory_count].type = MEMORY_ARRAY;
-                memory[memory_count].size = 0;
-                memory[memory_count].values = NULL;
-                Instruction var_code[1] = {{OP_PUSH, memory_count}};
+            if (session->memory_count < VAR_SIZE) {
+                session->memory[session->memory_count].name = strdup(word->strings[instr.operand]);
+                session->memory[session->memory_count].type = MEMORY_ARRAY;
+                session->memory[session->memory_count].size = 0;
+                session->memory[session->memory_count].values = NULL;
+                Instruction var_code[1] = {{OP_PUSH, session->memory_count}};
                 char *var_strings[1] = {NULL};
-                addCompiledWord(memory[memory_count].name, var_code, 1, var_strings, 0);
-                mpz_set_si(*result, memory_count);
+                addCompiledWord(session->memory[session->memory_count].name, var_code, 1, var_strings, 0);
+                mpz_set_si(*result, session->memory_count);
                 push(stack, *result);
-                memory_count++;
+                session->memory_count++;
             } else {
                 set_error("Memory table full");
             }
             break;
         case OP_ALLOT:
+        case OP_CELLS_ALLOT: {
+            const char *op = instr.opcode == OP_ALLOT ? "ALLOT" : "CELLS-ALLOT";
+            size_t cell_bytes = instr.opcode == OP_ALLOT ? sizeof(mpz_t) : sizeof(int64_t);
             pop(stack, *a); // Size
             pop(stack, *b); // Memory index
-            if (!error_flag && mpz_fits_slong_p(*a) && mpz_fits_slong_p(*b)) {
+            if (!session->error_flag && mpz_fits_slong_p(*a) && mpz_fits_slong_p(*b)) {
                 long int size = mpz_get_si(*a);
                 int index = mpz_get_si(*b);
-                if (index >= 0 && index < memory_count && memory[index].type == MEMORY_ARRAY) {
-                    if (memory[index].values) {
-                        for (int i = 0; i < memory[index].size; i++) {
-                            mpz_clear(memory[index].values[i]);
+                char msg[256];
+                if (size < 0) {
+                    snprintf(msg, sizeof(msg), "%s: Negative size", op);
+                    set_error(msg);
+                } else if (active_quota->max_live_bytes && (size_t)size > active_quota->max_live_bytes / cell_bytes) {
+                    snprintf(msg, sizeof(msg), "Quota exceeded: %s of %ld cells (limit %zu bytes)",
+                             op, size, active_quota->max_live_bytes);
+                    set_error(msg);
+                } else if (index >= 0 && index < session->memory_count &&
+                           (session->memory[index].type == MEMORY_ARRAY || session->memory[index].type == MEMORY_CELLS)) {
+                    txn_memory_write(index, -1);
+                    if (session->memory[index].values) {
+                        for (int i = 0; i < session->memory[index].size; i++) {
+                            mpz_clear(session->memory[index].values[i]);
+                        }
+                        free(session->memory[index].values);
+                        session->memory[index].values = NULL;
+                    }
+                    free(session->memory[index].cells);
+                    session->memory[index].cells = NULL;
+                    session->memory[index].size = 0;
+                    if (instr.opcode == OP_CELLS_ALLOT) {
+                        session->memory[index].type = MEMORY_CELLS;
+                        session->memory[index].cells = calloc(size ? size : 1, sizeof(int64_t));
+                        if (!session->memory[index].cells) {
+                            set_error("CELLS-ALLOT: Memory allocation failed");
+                            break;
                         }
-                        free(memory[index].values);
+                        session->memory[index].size = size;
+                        break;
                     }
-                    memory[index].values = malloc(size * sizeof(mpz_t));
-                    if (!memory[index].values) {
+                    session->memory[index].type = MEMORY_ARRAY;
+                    session->memory[index].values = malloc(size * sizeof(mpz_t));
+                    if (!session->memory[index].values) {
                         set_error("ALLOT: Memory allocation failed");
                         break;
                     }
-                    memory[index].size = size;
+                    session->memory[index].size = size;
                     for (int i = 0; i < size; i++) {
-                        mpz_init(memory[index].values[i]);
-                        mpz_set_ui(memory[index].values[i], 0);
+                        mpz_init(session->memory[index].values[i]);
+                        mpz_set_ui(session->memory[index].values[i], 0);
                     }
-                } else if (!error_flag) {
-                    set_error("ALLOT: Invalid memory index or not an array");
+                } else if (!session->error_flag) {
+                    snprintf(msg, sizeof(msg), "%s: Invalid memory index or not an array", op);
+                    set_error(msg);
                 }
-            } else if (!error_flag) {
-                set_error("ALLOT: Invalid size or memory index");
+            } else if (!session->error_flag) {
+                char msg[256];
+                snprintf(msg, sizeof(msg), "%s: Invalid size or memory index", op);
+                set_error(msg);
             }
             break;
+        }
 case OP_FETCH:
             pop(stack, *b); // Index de la mémoire (ex. GREET)
-            if (!error_flag && mpz_fits_slong_p(*b) && mpz_get_si(*b) >= 0 && mpz_get_si(*b) < memory_count) {
+            if (!session->error_flag && mpz_fits_slong_p(*b) && mpz_get_si(*b) >= 0 && mpz_get_si(*b) < session->memory_count) {
                 int idx = mpz_get_si(*b);
-                if (memory[idx].type == MEMORY_VARIABLE) {
-                    push(stack, memory[idx].values[0]);
-                } else if (memory[idx].type == MEMORY_ARRAY) {
+                if (session->memory[idx].type == MEMORY_VARIABLE) {
+                    push(stack, session->memory[idx].values[0]);
+                } else if (session->memory[idx].type == MEMORY_ARRAY || session->memory[idx].type == MEMORY_CELLS) {
                     pop(stack, *a);
-                    if (!error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < memory[idx].size) {
-                        push(stack, memory[idx].values[mpz_get_si(*a)]);
-                    } else if (!error_flag) {
+                    if (!session->error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < session->memory[idx].size) {
+                        array_get(&session->memory[idx], mpz_get_si(*a), *result);
+                        push(stack, *result);
+                    } else if (!session->error_flag) {
                         set_error("FETCH: Index out of bounds for array");
                     }
-                } else if (memory[idx].type == MEMORY_STRING) {
+                } else if (session->memory[idx].type == MEMORY_STRING) {
                     push(stack, *b); // Pousse l’index de la mémoire sur la pile
                 }
-            } else if (!error_flag) {
+            } else if (!session->error_flag) {
                 set_error("FETCH: Invalid memory index");
             }
             break;
 case OP_STORE:
     pop(stack, *result); // Index mémoire (ex. TEST, sommet de la pile)
-    if (!error_flag && mpz_fits_slong_p(*result) && mpz_get_si(*result) >= 0 && mpz_get_si(*result) < memory_count) {
+    if (!session->error_flag && mpz_fits_slong_p(*result) && mpz_get_si(*result) >= 0 && mpz_get_si(*result) < session->memory_count) {
         int idx = mpz_get_si(*result);
-        if (memory[idx].type == MEMORY_VARIABLE) {
+        if (session->memory[idx].type == MEMORY_VARIABLE) {
             // Cas variable simple : 12345 ZAZA !
             pop(stack, *a); // Valeur (ex. 12345)
-            if (!error_flag) {
-                mpz_set(memory[idx].values[0], *a); // Stocke la valeur dans la variable
+            if (!session->error_flag) {
+                txn_memory_write(idx, 0);
+                mpz_set(session->memory[idx].values[0], *a); // Stocke la valeur dans la variable
             }
-        } else if (memory[idx].type == MEMORY_ARRAY) {
+        } else if (session->memory[idx].type == MEMORY_ARRAY || session->memory[idx].type == MEMORY_CELLS) {
             // Cas tableau : 12345 5 ZAZA !
             pop(stack, *b); // Index dans le tableau (ex. 5)
             pop(stack, *a); // Valeur (ex. 12345)
-            if (!error_flag) {
-                if (mpz_fits_slong_p(*b) && mpz_get_si(*b) >= 0 && mpz_get_si(*b) < memory[idx].size) {
-                    mpz_set(memory[idx].values[mpz_get_si(*b)], *a); // Stocke la valeur à l’index du tableau
+            if (!session->error_flag) {
+                if (mpz_fits_slong_p(*b) && mpz_get_si(*b) >= 0 && mpz_get_si(*b) < session->memory[idx].size) {
+                    array_set(&session->memory[idx], mpz_get_si(*b), *a); // Stocke la valeur à l’index du tableau
                 } else {
                     set_error("STORE: Index out of bounds for array");
                 }
             }
-        } else if (memory[idx].type == MEMORY_STRING) {
+        } else if (session->memory[idx].type == MEMORY_STRING) {
             // Cas chaîne : "A string" TEST !
             pop(stack, *a); // Index de la chaîne dans string_stack
-            if (!error_flag && mpz_fits_slong_p(*a) && 
-                mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= string_stack_top) {
-                char *str = string_stack[mpz_get_si(*a)];
+            if (!session->error_flag && mpz_fits_slong_p(*a) && 
+                mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= session->string_stack_top) {
+                char *str = session->string_stack[mpz_get_si(*a)];
                 if (str) {
-                    if (memory[idx].string) free(memory[idx].string);
-                    memory[idx].string = strdup(str);
-                    string_stack_top--; // Retire la chaîne de string_stack après stockage
+                    txn_memory_write(idx, -1);
+                    if (session->memory[idx].string) free(session->memory[idx].string);
+                    session->memory[idx].string = strdup(str);
+                    session->string_stack_top--; // Retire la chaîne de string_stack après stockage
                 } else {
                     set_error("STORE: No string at stack index");
                 }
-            } else if (!error_flag) {
+            } else if (!session->error_flag) {
                 set_error("STORE: Invalid string stack index");
             }
         } else {
             set_error("STORE: Unknown memory type");
         }
-    } else if (!error_flag) {
+    } else if (!session->error_flag) {
         set_error("STORE: Invalid memory index");
     }
     break;
 case OP_STRING:
-            if (memory_count < VAR_SIZE) {
-                memory[memory_count].name = strdup(word->strings[instr.operand]);
-                memory[memory_count].type = MEMORY_STRING;
-                memory[memory_count].string = strdup("");
-                memory[memory_count].values = NULL;
-                memory[memory_count].size = 0;
-                Instruction var_code[1] = {{OP_PUSH, memory_count}};
+            if (session->memory_count < VAR_SIZE) {
+                session->memory[session->memory_count].name = strdup(word->strings[instr.operand]);
+                session->memory[session->memory_count].type = MEMORY_STRING;
+                session->memory[session->memory_count].string = strdup("");
+                session->memory[session->memory_count].values = NULL;
+                session->memory[session->memory_count].size = 0;
+                Instruction var_code[1] = {{OP_PUSH, session->memory_count}};
                 char *var_strings[1] = {NULL};
-                addCompiledWord(memory[memory_count].name, var_code, 1, var_strings, 0);
-                mpz_set_si(*result, memory_count);
+                addCompiledWord(session->memory[session->memory_count].name, var_code, 1, var_strings, 0);
+                mpz_set_si(*result, session->memory_count);
                 push(stack, *result);
-                memory_count++;
+                session->memory_count++;
             } else {
                 set_error("Memory table full");
             }
             break;
 case OP_PRINT:
             pop(stack, *a); // Index de la mémoire (ex. GREET)
-            if (!error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < memory_count) {
+            if (!session->error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < session->memory_count) {
                 int idx = mpz_get_si(*a);
-                if (memory[idx].type == MEMORY_STRING && memory[idx].string) {
-                    send_to_channel(memory[idx].string);
+                if (session->memory[idx].type == MEMORY_STRING && session->memory[idx].string) {
+                    send_to_channel(session->memory[idx].string);
                 } else {
                     set_error("PRINT: Not a string or empty");
                 }
-            } else if (!error_flag) {
+            } else if (!session->error_flag) {
                 set_error("PRINT: Invalid memory index");
             }
             break;
 case OP_STORE_STRING:
     pop(stack, *a); // Index dans string_stack
     pop(stack, *result); // Index de la mémoire (ex. toto)
-    if (!error_flag && mpz_fits_slong_p(*result) && mpz_get_si(*result) >= 0 && mpz_get_si(*result) < memory_count) {
+    if (!session->error_flag && mpz_fits_slong_p(*result) && mpz_get_si(*result) >= 0 && mpz_get_si(*result) < session->memory_count) {
         int idx = mpz_get_si(*result);
-        if (memory[idx].type == MEMORY_STRING) {
-            if (mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= string_stack_top) {
+        if (session->memory[idx].type == MEMORY_STRING) {
+            if (mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) <= session->string_stack_top) {
                 char *str = pop_string();
                 if (str) {
-                    if (memory[idx].string) free(memory[idx].string);
-                    memory[idx].string = strdup(str);
+                    txn_memory_write(idx, -1);
+                    if (session->memory[idx].string) free(session->memory[idx].string);
+                    session->memory[idx].string = strdup(str);
                 } else {
                     set_error("S!: No string to store");
                 }
@@ -978,14 +2961,14 @@ case OP_STORE_STRING:
         } else {
             set_error("S!: Not a string variable");
         }
-    } else if (!error_flag) {
+    } else if (!session->error_flag) {
         set_error("S!: Invalid memory index");
     }
     break;
 case OP_QUOTE:
     if (instr.operand >= 0 && instr.operand < word->string_count && word->strings[instr.operand]) {
         push_string(word->strings[instr.operand]);
-        mpz_set_si(*result, string_stack_top);
+        mpz_set_si(*result, session->string_stack_top);
         push(stack, *result);
     } else {
         set_error("QUOTE: Invalid string index");
@@ -993,7 +2976,7 @@ case OP_QUOTE:
     break;
 case OP_EMIT:
     pop(stack, *a);
-    if (!error_flag) {
+    if (!session->error_flag) {
         long val = mpz_get_si(*a);
         if (val >= 0 && val <= 255) { // Vérification ASCII
             buffer_char((char)val);
@@ -1004,7 +2987,7 @@ case OP_EMIT:
     break;
         case OP_PICK:
             pop(stack, *a);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 long int n = mpz_get_si(*a);
                 if (n >= 0 && n <= stack->top) {
                     mpz_set(*result, stack->data[stack->top - n]);
@@ -1017,7 +3000,7 @@ case OP_EMIT:
             break;
         case OP_ROLL:
             pop(stack, *a);
-            if (!error_flag) {
+            if (!session->error_flag) {
                 long int n = mpz_get_si(*a);
                 if (n < 0 || n > stack->top + 1) {
                     set_error("ROLL: Invalid index or stack underflow");
@@ -1025,6 +3008,7 @@ case OP_EMIT:
                 } else if (n > 0) {
                     int index = stack->top + 1 - n;
                     mpz_set(*result, stack->data[index]);
+                    txn_stack_write(stack, index);
                     for (int i = index; i < stack->top; i++) {
                         mpz_set(stack->data[i], stack->data[i + 1]);
                     }
@@ -1034,9 +3018,9 @@ case OP_EMIT:
             break;
         case OP_PLUSSTORE:
             pop(stack, *a); pop(stack, *b);
-            if (!error_flag && mpz_fits_slong_p(*b) && mpz_get_si(*b) >= 0 && mpz_get_si(*b) < var_count) {
-                mpz_add(variables[mpz_get_si(*b)].value, variables[mpz_get_si(*b)].value, *a);
-            } else if (!error_flag) {
+            if (!session->error_flag && mpz_fits_slong_p(*b) && mpz_get_si(*b) >= 0 && mpz_get_si(*b) < session->var_count) {
+                mpz_add(session->variables[mpz_get_si(*b)].value, session->variables[mpz_get_si(*b)].value, *a);
+            } else if (!session->error_flag) {
                 set_error("PLUSSTORE: Invalid variable index");
             }
             break;
@@ -1046,9 +3030,9 @@ case OP_EMIT:
             break;
         case OP_TOP:
             if (stack->top >= 0) {
-                char top_msg[512];
-                gmp_snprintf(top_msg, sizeof(top_msg), "%Zd", stack->data[stack->top]);
-                send_to_channel(top_msg);
+                char *top_msg = format_number(stack->data[stack->top]);
+                if (top_msg) send_to_channel(top_msg);
+                free(top_msg);
             } else {
                 set_error("TOP: Stack underflow");
             }
@@ -1061,48 +3045,673 @@ case OP_EMIT:
             set_error("IRC-SEND not implemented");
             break;
         case OP_RECURSE:
-            if (word_index >= 0 && word_index < dict_count) {
-                executeCompiledWord(&dictionary[word_index], stack, word_index);
+            if (word_index >= 0 && word_index < session->dict_count) {
+                executeCompiledWord(session->dictionary[word_index], stack, word_index);
             } else {
                 set_error("RECURSE called with invalid word index");
             }
             break;
 case OP_SEE:
-    if (compiling || word_index >= 0) { // Mode compilé ou dans une définition
+    if (session->compiling || word_index >= 0) { // Mode compilé ou dans une définition
         print_word_definition_irc(instr.operand, stack);
     } else { // Mode immédiat
         pop(stack, *a);
-        if (!error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < dict_count) {
+        if (!session->error_flag && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < session->dict_count) {
             print_word_definition_irc(mpz_get_si(*a), stack);
-        } else if (!error_flag) {
+        } else if (!session->error_flag) {
             set_error("SEE: Invalid word index");
         }
     }
     break;
+        case OP_SET_BASE:
+            if (session->base_index >= 0) {
+                txn_memory_write(session->base_index, 0);
+                mpz_set_si(session->memory[session->base_index].values[0], instr.operand);
+            } else {
+                set_error("BASE not initialized");
+            }
+            break;
+        case OP_MEMSTATS: {
+            long rss_pages = 0;
+            FILE *statm = fopen("/proc/self/statm", "r");
+            if (statm) {
+                if (fscanf(statm, "%*s %ld", &rss_pages) != 1) rss_pages = 0;
+                fclose(statm);
+            }
+            char stats_msg[512];
+            snprintf(stats_msg, sizeof(stats_msg),
+                     "GMP live: %zu B (peak %zu, huge %zu), arena: %zu B, scratch: %zu B (%lu allocs), "
+                     "allocs: %lu reallocs: %lu frees: %lu, "
+                     "last command: %lu allocs, %+ld B, peak +%ld B, sessions: %ld, RSS: %ld KB, "
+                     "memo: %ld entries, %zu B, %lu hits, %lu misses",
+                     (size_t)gmp_totals.live_bytes, (size_t)gmp_totals.peak_bytes, (size_t)gmp_totals.huge_bytes,
+                     (size_t)gmp_totals.arena_bytes, (size_t)gmp_totals.scratch_bytes,
+                     (unsigned long)gmp_totals.scratch_allocs, (unsigned long)gmp_totals.allocs,
+                     (unsigned long)gmp_totals.reallocs, (unsigned long)gmp_totals.frees,
+                     session->last_cmd_allocs, session->last_cmd_delta, session->last_cmd_peak,
+                     session_count,
+                     rss_pages * (sysconf(_SC_PAGESIZE) / 1024),
+                     session->memo.entries, session->memo.bytes, session->memo.hits, session->memo.misses);
+            send_to_channel(stats_msg);
+            break;
+        }
+        case OP_QUEUESTATS: {
+            char stats_msg[512];
+            pthread_mutex_lock(&scheduler.lock);
+            unsigned long dispatched = scheduler.dispatched;
+            snprintf(stats_msg, sizeof(stats_msg),
+                     "Workers: %d (%d busy, %d heavy, max heavy %d), queued: %ld, sessions: %ld, "
+                     "dispatched: %lu, wait avg %.1f ms, max %.1f ms, last %.1f ms",
+                     scheduler.workers, scheduler.running, scheduler.heavy_running, scheduler.max_heavy,
+                     scheduler.queued, session_count, dispatched,
+                     dispatched ? scheduler.wait_total_us / 1000.0 / dispatched : 0.0,
+                     scheduler.wait_max_us / 1000.0, scheduler.wait_last_us / 1000.0);
+            pthread_mutex_unlock(&scheduler.lock);
+            size_t used = strlen(stats_msg);
+            long queued = 0, sent = 0, suppressed = 0;
+            for (int i = 0; i < network_count; i++) {
+                queued += atomic_load_explicit(&networks[i].out.queued, memory_order_relaxed);
+                sent += atomic_load_explicit(&networks[i].out.sent, memory_order_relaxed);
+                suppressed += atomic_load_explicit(&networks[i].out.suppressed_total, memory_order_relaxed);
+            }
+            snprintf(stats_msg + used, sizeof(stats_msg) - used, ", outbound: %ld queued, %ld sent, %ld suppressed, %d networks",
+                     queued, sent, suppressed, network_count);
+            if (sandbox.enabled) {
+                unsigned long forks = atomic_load_explicit(&sandbox.forks, memory_order_relaxed);
+                used = strlen(stats_msg);
+                snprintf(stats_msg + used, sizeof(stats_msg) - used, ", sandbox: %lu forks (%lu aborted), start avg %.0f us, max %lld us",
+                         forks, atomic_load_explicit(&sandbox.killed, memory_order_relaxed),
+                         forks ? (double)atomic_load_explicit(&sandbox.fork_us_total, memory_order_relaxed) / forks : 0.0,
+                         atomic_load_explicit(&sandbox.fork_us_max, memory_order_relaxed));
+            }
+            send_to_channel(stats_msg);
+            break;
+        }
+        case OP_CACHESTATS: {
+            char stats_msg[512];
+            pthread_mutex_lock(&result_cache.lock);
+            snprintf(stats_msg, sizeof(stats_msg),
+                     "Result cache: %ld entries, %zu/%zu bytes, lookups: %lu, hits: %lu (%.1f%%), stores: %lu, uncacheable: %lu",
+                     result_cache.entries, result_cache.bytes, result_cache.max_bytes, result_cache.lookups, result_cache.hits,
+                     result_cache.lookups ? 100.0 * result_cache.hits / result_cache.lookups : 0.0,
+                     result_cache.stores, result_cache.uncacheable);
+            pthread_mutex_unlock(&result_cache.lock);
+            send_to_channel(stats_msg);
+            break;
+        }
+        case OP_STATS:
+            latency_report(session->nick);
+            break;
+        case OP_PROFILE:
+#ifdef FORTH_PROFILE
+            profile_command(instr.operand);
+#else
+            set_error("PROFILE: profiler not compiled in, rebuild with -DFORTH_PROFILE");
+#endif
+            break;
+        case OP_PROFILE_DUMP:
+            sampler_dump();
+            break;
+        case OP_JOBS: {
+            char jobs_msg[512] = "";
+            long long now = now_us();
+            pthread_mutex_lock(&scheduler.lock);
+            for (Job *job = active_jobs; job; job = job->next) {
+                char entry[160];
+                long long since = job->state == JOB_QUEUED ? job->submitted_us : job->started_us;
+                snprintf(entry, sizeof(entry), "%s#%ld %s %s %.1f s %ld KB: %.40s", jobs_msg[0] ? "; " : "", job->id, job->nick,
+                         job_state_name(job->state), (now - since) / 1e6,
+                         atomic_load_explicit(&job->bytes, memory_order_relaxed) / 1024, job->command);
+                strncat(jobs_msg, entry, sizeof(jobs_msg) - strlen(jobs_msg) - 1);
+            }
+            pthread_mutex_unlock(&scheduler.lock);
+            send_to_channel(jobs_msg[0] ? jobs_msg : "No jobs running");
+            break;
+        }
+        case OP_KILL: {
+            pop(stack, *a);
+            if (session->error_flag) break;
+            long int id = mpz_fits_slong_p(*a) ? mpz_get_si(*a) : -1;
+            char msg[128] = "";
+            pthread_mutex_lock(&scheduler.lock);
+            Job *job = active_jobs;
+            while (job && job->id != id) job = job->next;
+            if (!job) {
+                snprintf(msg, sizeof(msg), "KILL: no running job %ld", id);
+            } else if (strcmp(job->nick, session->nick) != 0) {
+                snprintf(msg, sizeof(msg), "KILL: job %ld belongs to %s", id, job->nick);
+            } else {
+                atomic_store_explicit(&job->cancel, 1, memory_order_relaxed);
+            }
+            pthread_mutex_unlock(&scheduler.lock);
+            if (msg[0]) {
+                set_error(msg);
+            } else {
+                snprintf(msg, sizeof(msg), "Job %ld cancellation requested", id);
+                send_to_channel(msg);
+            }
+            break;
+        }
+        case OP_YIELD:
+            generator_yield(stack, word);
+            break;
+        case OP_NEXT:
+            generator_next(stack);
+            break;
+        case OP_TAKE:
+            generator_take(stack);
+            break;
+        case OP_RESULT: {
+            pop(stack, *a);
+            if (session->error_flag) break;
+            long int id = mpz_fits_slong_p(*a) ? mpz_get_si(*a) : -1;
+            char *msg = NULL;
+            pthread_mutex_lock(&scheduler.lock);
+            for (int i = 0; i < JOB_RESULTS; i++) {
+                if (job_results[i] && job_results[i]->id == id) {
+                    msg = job_result_message(job_results[i], job_results[i]->state);
+                    break;
+                }
+            }
+            pthread_mutex_unlock(&scheduler.lock);
+            if (msg) {
+                send_to_channel(msg);
+                free(msg);
+            } else {
+                char err[128];
+                snprintf(err, sizeof(err), "RESULT: no finished job %ld (the last %d are kept)", id, JOB_RESULTS);
+                set_error(err);
+            }
+            break;
+        }
+        case OP_COUNT: // Sentinelle de l'énumération, jamais compilée
+            set_error("Invalid opcode");
+            break;
+    }
+}
 
+// Exécute depuis *ip ; s'arrête aussi sur un YIELD de l'instance en cours de reprise
+static void run_from(CompiledWord *word, Stack *stack, int word_index, long int *ip) {
+#ifdef FORTH_PROFILE
+    int previous_op = -1;
+#endif
+    if ((unsigned long)vm_frames.depth >= max_call_depth) { // Chaque niveau est un appel C récursif
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Return stack overflow: more than %lu nested calls", max_call_depth);
+        set_error(msg);
+        return;
+    }
+    VmFrame *frame = &vm_frames.frames[vm_frames.depth & (VM_FRAMES - 1)];
+    frame->word = word;
+    frame->ip = ip;
+    atomic_signal_fence(memory_order_release); // Cadre complet avant d'être visible par SIGPROF
+    vm_frames.depth++;
+    while (*ip < word->code_length && !session->error_flag) {
+#ifdef FORTH_PROFILE
+        long long gmp_start = profile_instruction(word->code[*ip].opcode, &previous_op);
+        executeInstruction(word->code[*ip], stack, ip, word, word_index);
+        if (gmp_start) profile_gmp(word_index, gmp_start);
+#else
+        executeInstruction(word->code[*ip], stack, ip, word, word_index);
+#endif
+        (*ip)++;
+        if (--vm_budget.slice_left <= 0) vm_slice_end();
+        if (gmp_heap.over_quota && !session->error_flag) {
+            char msg[256];
+            snprintf(msg, sizeof(msg), "Quota exceeded: command grew GMP memory by %ld bytes (limit %zu)",
+                     gmp_heap.cmd_peak_bytes, gmp_heap.cmd_limit_bytes);
+            set_error(msg);
+        }
+        if (session->generator_active && session->generator_active->yielded && word == &session->generator_active->word) break;
     }
+    vm_frames.depth--;
 }
 
-void executeCompiledWord(CompiledWord *word, Stack *stack, int word_index) {
+static void run_word(CompiledWord *word, Stack *stack, int word_index) {
     long int ip = 0;
-    while (ip < word->code_length && !error_flag) {
-        executeInstruction(word->code[ip], stack, &ip, word, word_index);
-        ip++;
-    }
-    if (error_flag) {
+    run_from(word, stack, word_index, &ip);
+    if (session->error_flag && vm_frames.depth == 0) { // Une fois, pas à chaque niveau d'appel
         send_to_channel("Execution aborted due to error");
     }
 }
 
-void addCompiledWord(char *name, Instruction *code, long int code_length, char **strings, long int string_count) {
-    int existing_index = findCompiledWordIndex(name);
+// Un mot est pur s'il n'utilise que la pile, l'arithmétique et le contrôle, et n'appelle que des mots purs
+static int word_is_pure(long int index, unsigned char *visited) {
+    if (index < 0 || index >= session->dict_count || !session->dictionary[index]) return 0;
+    if (visited[index]) return 1;
+    visited[index] = 1;
+    CompiledWord *word = session->dictionary[index];
+    if (word->generator) return 0;
+    for (long int i = 0; i < word->code_length; i++) {
+        if (!opcode_is_pure(word->code[i].opcode)) return 0;
+        if (word->code[i].opcode == OP_CALL && !word_is_pure(word->code[i].operand, visited)) return 0;
+    }
+    return 1;
+}
+
+static int memo_init(MemoCache *m) {
+    m->buckets = calloc(MEMO_BUCKETS, sizeof(MemoEntry *));
+    if (!m->buckets) return 0;
+    memset(m->pure, -1, sizeof(m->pure));
+    for (int i = 0; i < DICT_SIZE; i++) m->arity[i] = -1;
+    return 1;
+}
+
+static void memo_unlink(MemoCache *m, MemoEntry *e) {
+    if (e->prev) e->prev->next = e->next;
+    else m->head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else m->tail = e->prev;
+}
+
+static void memo_free_entry(MemoCache *m, MemoEntry *e) {
+    MemoEntry **link = &m->buckets[e->hash % MEMO_BUCKETS];
+    while (*link != e) link = &(*link)->chain;
+    *link = e->chain;
+    memo_unlink(m, e);
+    for (int i = 0; i < e->inputs + e->outputs; i++) mpz_clear(e->values[i]);
+    free(e->values);
+    m->bytes -= e->bytes;
+    m->entries--;
+    free(e);
+}
+
+// Redéfinition, FORGET ou annulation : plus rien dans le cache ne peut être cru
+void memo_reset(MemoCache *m) {
+    if (!m->buckets) return;
+    while (m->head) memo_free_entry(m, m->head);
+    memset(m->pure, -1, sizeof(m->pure));
+    for (int i = 0; i < DICT_SIZE; i++) m->arity[i] = -1;
+}
+
+static uint64_t memo_hash(int word, const mpz_t *args, int n) {
+    uint64_t hash = 1469598103934665603ULL ^ ((uint64_t)word * 0x9E3779B97F4A7C15ULL);
+    for (int i = 0; i < n; i++) {
+        size_t size = mpz_size(args[i]);
+        hash = (hash ^ (uint64_t)mpz_sgn(args[i])) * 1099511628211ULL;
+        for (size_t j = 0; j < size; j++) {
+            hash = (hash ^ mpz_getlimbn(args[i], j)) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+// inputs (n valeurs) appartient désormais au cache ; les résultats sont au sommet de la pile
+static void memo_store(MemoCache *m, int index, uint64_t hash, mpz_t *inputs, int n, Stack *stack, int produced) {
+    size_t bytes = sizeof(MemoEntry) + (n + produced) * sizeof(mpz_t);
+    for (int i = 0; i < n; i++) bytes += mpz_size(inputs[i]) * sizeof(mp_limb_t);
+    for (long int i = stack->top - produced + 1; i <= stack->top; i++) bytes += mpz_size(stack->data[i]) * sizeof(mp_limb_t);
+    MemoEntry *e = bytes <= memo_max_bytes ? malloc(sizeof(MemoEntry)) : NULL;
+    mpz_t *values = e ? malloc((n + produced ? n + produced : 1) * sizeof(mpz_t)) : NULL;
+    if (!values) {
+        free(e);
+        for (int i = 0; i < n; i++) mpz_clear(inputs[i]);
+        return;
+    }
+    while (m->tail && m->bytes + bytes > memo_max_bytes) memo_free_entry(m, m->tail);
+    for (int i = 0; i < n; i++) {
+        values[i][0] = inputs[i][0]; // Reprend les limbs sans copie
+    }
+    for (int i = 0; i < produced; i++) mpz_init_set(values[n + i], stack->data[stack->top - produced + 1 + i]);
+    e->hash = hash;
+    e->word = index;
+    e->inputs = n;
+    e->outputs = produced;
+    e->values = values;
+    e->bytes = bytes;
+    e->chain = m->buckets[hash % MEMO_BUCKETS];
+    m->buckets[hash % MEMO_BUCKETS] = e;
+    e->prev = NULL;
+    e->next = m->head;
+    if (m->head) m->head->prev = e;
+    else m->tail = e;
+    m->head = e;
+    m->bytes += bytes;
+    m->entries++;
+}
+
+// Appel d'un mot MEMO : sert le résultat du cache ou exécute le mot et l'enregistre.
+// L'arité est apprise au premier appel (profondeur la plus basse atteinte par la pile).
+// Renvoie 0 si le mot doit s'exécuter normalement.
+static int memo_call(CompiledWord *word, Stack *stack, int index) {
+    MemoCache *m = &session->memo;
+    if (!m->buckets && !memo_init(m)) return 0;
+    if (m->pure[index] < 0) {
+        unsigned char visited[DICT_SIZE] = {0};
+        m->pure[index] = word_is_pure(index, visited);
+    }
+    int n = m->arity[index];
+    if (!m->pure[index] || n == -2 || stack->top + 1 < n) return 0;
+    uint64_t hash = 0;
+    if (n >= 0) {
+        hash = memo_hash(index, (const mpz_t *)&stack->data[stack->top - n + 1], n);
+        for (MemoEntry *e = m->buckets[hash % MEMO_BUCKETS]; e; e = e->chain) {
+            if (e->hash != hash || e->word != index || e->inputs != n) continue;
+            int same = 1;
+            for (int i = 0; i < n && same; i++) same = mpz_cmp(e->values[i], stack->data[stack->top - n + 1 + i]) == 0;
+            if (!same) continue;
+            for (int i = 0; i < n; i++) pop(stack, session->mpz_pool[0]);
+            for (int i = 0; i < e->outputs; i++) push(stack, e->values[n + i]);
+            memo_unlink(m, e);
+            e->prev = NULL;
+            e->next = m->head;
+            if (m->head) m->head->prev = e;
+            else m->tail = e;
+            m->head = e;
+            m->hits++;
+            return 1;
+        }
+    }
+    mpz_t *inputs = n > 0 ? malloc(n * sizeof(mpz_t)) : NULL;
+    if (n > 0 && !inputs) return 0;
+    for (int i = 0; i < n; i++) mpz_init_set(inputs[i], stack->data[stack->top - n + 1 + i]);
+    long int entry_top = stack->top, outer_low = session->memo_low;
+    session->memo_low = stack->top;
+    run_word(word, stack, index);
+    int consumed = entry_top - session->memo_low, produced = stack->top - session->memo_low;
+    if (outer_low < session->memo_low) session->memo_low = outer_low;
+    m->misses++;
+    if (!session->error_flag && n < 0) {
+        m->arity[index] = consumed; // Mis en cache à partir du prochain appel
+    } else if (!session->error_flag && consumed != n) {
+        m->arity[index] = -2;
+    } else if (!session->error_flag) {
+        memo_store(m, index, hash, inputs, n, stack, produced);
+        free(inputs);
+        return 1;
+    }
+    for (int i = 0; i < n; i++) mpz_clear(inputs[i]);
+    free(inputs);
+    return 1;
+}
+
+// MEMO après une définition : le dernier mot défini passe par le cache
+static void memo_declare() {
+    long int index = session->last_word_index;
+    if (index < 0 || index >= session->dict_count || !session->dictionary[index]) {
+        set_error("MEMO: no word defined");
+        return;
+    }
+    unsigned char visited[DICT_SIZE] = {0};
+    if (!word_is_pure(index, visited)) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "MEMO: %s is not pure (only stack, arithmetic and branches allowed, no DO loops)",
+                 session->dictionary[index]->name);
+        set_error(msg);
+        return;
+    }
+    CompiledWord *old = session->dictionary[index];
+    txn_word_write(index);
+    CompiledWord *word = word_for_write(index);
+    if (!word) {
+        set_error("MEMO: Memory allocation failed");
+        return;
+    }
+    if (word != old) word_copy(word, old);
+    word->memo = 1;
+}
+
+// GENERATOR : une instance garde sa copie du mot, sa pile et ses boucles entre deux NEXT
+static Generator *generator_new(const CompiledWord *word) {
+    Generator *g = calloc(1, sizeof(Generator));
+    if (!g) return NULL;
+    g->stack = malloc(sizeof(Stack));
+    if (!g->stack) {
+        free(g);
+        return NULL;
+    }
+    g->stack->top = -1;
+    for (int i = 0; i < STACK_SIZE; i++) mpz_init(g->stack->data[i]);
+    word_copy(&g->word, word);
+    return g;
+}
+
+void generator_free(Generator *g) {
+    for (int i = 0; i < STACK_SIZE; i++) mpz_clear(g->stack->data[i]);
+    free(g->stack);
+    for (long int i = 0; i < g->loop_count; i++) {
+        mpz_clear(g->loops[i].index);
+        mpz_clear(g->loops[i].limit);
+    }
+    free(g->loops);
+    if (g->word.name) free(g->word.name);
+    for (long int i = 0; i < g->word.string_count; i++) {
+        if (g->word.strings[i]) free(g->word.strings[i]);
+    }
+    free(g);
+}
+
+Generator *generator_copy(const Generator *src) {
+    Generator *g = generator_new(&src->word);
+    if (!g) return NULL;
+    g->id = src->id;
+    g->ip = src->ip;
+    g->last_used = src->last_used;
+    for (long int i = 0; i <= src->stack->top; i++) mpz_set(g->stack->data[i], src->stack->data[i]);
+    g->stack->top = src->stack->top;
+    if (src->loop_count) {
+        g->loops = malloc(src->loop_count * sizeof(LoopControl));
+        if (!g->loops) {
+            generator_free(g);
+            return NULL;
+        }
+        for (long int i = 0; i < src->loop_count; i++) {
+            mpz_init_set(g->loops[i].index, src->loops[i].index);
+            mpz_init_set(g->loops[i].limit, src->loops[i].limit);
+            g->loops[i].addr = src->loops[i].addr;
+        }
+        g->loop_count = src->loop_count;
+    }
+    return g;
+}
+
+// Appel d'un mot GENERATOR : ses arguments passent sur la pile de l'instance, son numéro est empilé
+static void generator_create(CompiledWord *word, Stack *stack) {
+    if (stack->top + 1 < word->generator_args) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "%s: Stack underflow (generator takes %ld arguments)", word->name, word->generator_args);
+        set_error(msg);
+        return;
+    }
+    int slot = -1;
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        if (!session->generators[i]) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 || session->generators[i]->last_used < session->generators[slot]->last_used) slot = i;
+    }
+    Generator *g = generator_new(word);
+    if (!g) {
+        set_error("GENERATOR: Memory allocation failed");
+        return;
+    }
+    if (session->generators[slot]) generator_free(session->generators[slot]); // Toutes prises : la moins récente part
+    session->generators[slot] = g;
+    g->id = ++session->generator_ids;
+    g->last_used = ++session->generator_clock;
+    long int first = stack->top - word->generator_args + 1;
+    for (long int i = first; i <= stack->top; i++) mpz_set(g->stack->data[++g->stack->top], stack->data[i]);
+    mpz_t *a = &session->mpz_pool[0];
+    for (long int i = 0; i < word->generator_args; i++) pop(stack, *a);
+    mpz_set_si(*a, g->id);
+    push(stack, *a);
+}
+
+static int generator_slot(Stack *stack, const char *op) {
+    mpz_t *a = &session->mpz_pool[0];
+    pop(stack, *a);
+    if (session->error_flag) return -1;
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        if (session->generators[i] && mpz_cmp_si(*a, session->generators[i]->id) == 0) return i;
+    }
+    char msg[128];
+    snprintf(msg, sizeof(msg), "%s: No such generator (finished or evicted)", op);
+    set_error(msg);
+    return -1;
+}
+
+// Reprend l'instance jusqu'au prochain YIELD (1, valeur sur la pile de l'appelant) ou jusqu'à sa fin (0, libérée)
+static int generator_resume(int slot, Stack *caller) {
+    Generator *g = session->generators[slot];
+    long int loop_base = session->loop_stack_top;
+    if (loop_base + g->loop_count >= LOOP_STACK_SIZE) {
+        set_error("Loop stack overflow");
+        return 0;
+    }
+    for (long int i = 0; i < g->loop_count; i++) session->loop_stack[++session->loop_stack_top] = g->loops[i];
+    g->loop_count = 0;
+    g->caller = caller;
+    g->yielded = 0;
+    g->last_used = ++session->generator_clock;
+    Generator *outer = session->generator_active;
+    session->generator_active = g;
+    run_from(&g->word, g->stack, -1, &g->ip);
+    session->generator_active = outer;
+    long int loops = session->loop_stack_top - loop_base;
+    if (g->yielded && !session->error_flag) {
+        if (loops > 0) {
+            LoopControl *saved = realloc(g->loops, loops * sizeof(LoopControl));
+            if (!saved) {
+                set_error("GENERATOR: Memory allocation failed");
+                return 0;
+            }
+            g->loops = saved;
+            memcpy(g->loops, &session->loop_stack[loop_base + 1], loops * sizeof(LoopControl));
+            g->loop_count = loops;
+        }
+        session->loop_stack_top = loop_base;
+        return 1;
+    }
+    while (session->loop_stack_top > loop_base) {
+        mpz_clear(session->loop_stack[session->loop_stack_top].index);
+        mpz_clear(session->loop_stack[session->loop_stack_top].limit);
+        session->loop_stack_top--;
+    }
+    session->generators[slot] = NULL;
+    generator_free(g);
+    return 0;
+}
+
+// NEXT ( g -- x 1 | 0 )
+void generator_next(Stack *stack) {
+    int slot = generator_slot(stack, "NEXT");
+    if (slot < 0) return;
+    int yielded = generator_resume(slot, stack);
+    if (session->error_flag) return;
+    mpz_set_si(session->mpz_pool[1], yielded);
+    push(stack, session->mpz_pool[1]);
+}
+
+// TAKE ( g n -- ) : affiche jusqu'à n valeurs, regroupées en lignes de TAKE_LINE_MAX caractères
+void generator_take(Stack *stack) {
+    mpz_t *a = &session->mpz_pool[0];
+    pop(stack, *a);
+    if (session->error_flag) return;
+    long int count = mpz_fits_slong_p(*a) ? mpz_get_si(*a) : LONG_MAX;
+    int slot = generator_slot(stack, "TAKE");
+    if (slot < 0) return;
+    char line[TAKE_LINE_MAX + 1] = "";
+    size_t len = 0;
+    for (long int n = 0; n < count && generator_resume(slot, stack); n++) {
+        pop(stack, *a);
+        char *text = format_number(*a);
+        if (!text) {
+            set_error("TAKE: Memory allocation failed");
+            return;
+        }
+        size_t text_len = strlen(text);
+        if (len > 0 && len + 1 + text_len > TAKE_LINE_MAX) {
+            send_to_channel(line);
+            len = 0;
+        }
+        if (text_len > TAKE_LINE_MAX) {
+            send_to_channel(text); // Trop long pour être regroupé : découpé par send_to_channel
+        } else {
+            len += snprintf(line + len, sizeof(line) - len, "%s%s", len ? " " : "", text);
+        }
+        free(text);
+    }
+    if (len > 0) send_to_channel(line);
+}
+
+// YIELD ( x -- ) : rend x à l'appelant de NEXT et suspend l'instance après cette instruction
+void generator_yield(Stack *stack, CompiledWord *word) {
+    Generator *g = session->generator_active;
+    if (!g || word != &g->word) {
+        set_error("YIELD outside of a generator");
+        return;
+    }
+    mpz_t *a = &session->mpz_pool[0];
+    pop(stack, *a);
+    if (session->error_flag) return;
+    push(g->caller, *a);
+    g->yielded = 1;
+}
+
+// Commande annulée : les instances qu'elle a créées ne sont plus référencées
+void generators_rollback(long int ids) {
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        if (session->generators[i] && session->generators[i]->id > ids) {
+            generator_free(session->generators[i]);
+            session->generators[i] = NULL;
+        }
+    }
+    session->generator_ids = ids;
+}
+
+// `;` d'un GENERATOR : le mot défini crée des instances au lieu de s'exécuter
+static void generator_declare(long int args) {
+    long int index = session->last_word_index;
+    if (index < 0 || index >= session->dict_count || !session->dictionary[index]) return;
+    CompiledWord *word = word_for_write(index);
+    if (!word) {
+        set_error("GENERATOR: Memory allocation failed");
+        return;
+    }
+    word->generator = 1;
+    word->generator_args = args;
+}
+
+void executeCompiledWord(CompiledWord *word, Stack *stack, int word_index) {
+    int previous = phase_switch(PHASE_EXECUTE);
+#ifdef FORTH_PROFILE
+    Profile *profile = session->profile && session->profile->enabled ? session->profile : NULL;
+    long long profile_start = 0, profile_children = 0;
+    // L'interpréteur appelle un mot par un OP_CALL temporaire qui porte son index : compté comme ligne interactive
+    int profile_slot = word_index >= 0 && word_index < session->dict_count && session->dictionary[word_index] == word ? word_index : PROFILE_TOP;
+    if (profile) profile_start = profile_enter(profile, profile_slot, &profile_children);
+#endif
+    if (word->generator) {
+        generator_create(word, stack);
+    } else if (!(word->memo && word_index >= 0 && memo_call(word, stack, word_index))) {
+        run_word(word, stack, word_index);
+    }
+#ifdef FORTH_PROFILE
+    if (profile) profile_leave(profile, profile_slot, profile_start, profile_children);
+#endif
+    phase_switch(previous);
+}
+
+void addCompiledWord(char *name, Instruction *code, long int code_length, char **strings, long int string_count) {
+    int existing_index = findCompiledWordIndex(name);
     if (existing_index >= 0) {
-        CompiledWord *word = &dictionary[existing_index];
+        txn_word_write(existing_index);
+        memo_reset(&session->memo);
+        dict_changed();
+        session->last_word_index = existing_index;
+        CompiledWord *word = word_for_write(existing_index);
+        if (!word) {
+            set_error("addCompiledWord: Memory allocation failed");
+            return;
+        }
         if (word->name) free(word->name);
         for (int i = 0; i < word->string_count; i++) {
             if (word->strings[i]) free(word->strings[i]);
         }
         word->name = strdup(name);
+        word->memo = 0;
+        word->generator = 0;
         if (code_length <= WORD_CODE_SIZE) {
             memcpy(word->code, code, code_length * sizeof(Instruction));
             word->code_length = code_length;
@@ -1113,18 +3722,26 @@ void addCompiledWord(char *name, Instruction *code, long int code_length, char *
         } else {
             set_error("addCompiledWord: Code length exceeds limit");
         }
-    } else if (dict_count < DICT_SIZE) {
-        dictionary[dict_count].name = strdup(name);
+    } else if (session->dict_count < DICT_SIZE) {
+        session->last_word_index = session->dict_count;
+        dict_changed();
+        CompiledWord *word = word_for_write(session->dict_count);
+        if (!word) {
+            set_error("addCompiledWord: Memory allocation failed");
+            return;
+        }
+        word->name = strdup(name);
         if (code_length <= WORD_CODE_SIZE) {
-            memcpy(dictionary[dict_count].code, code, code_length * sizeof(Instruction));
-            dictionary[dict_count].code_length = code_length;
-            dictionary[dict_count].string_count = string_count;
+            memcpy(word->code, code, code_length * sizeof(Instruction));
+            word->code_length = code_length;
+            word->string_count = string_count;
             for (int i = 0; i < string_count; i++) {
-                dictionary[dict_count].strings[i] = strings[i] ? strdup(strings[i]) : NULL;
+                word->strings[i] = strings[i] ? strdup(strings[i]) : NULL;
             }
-            dict_count++;
+            session->dict_count++;
             if (findMemoryIndex("DP") >= 0) {
-                mpz_set_si(memory[findMemoryIndex("DP")].values[0], dict_count);
+                txn_memory_write(findMemoryIndex("DP"), 0);
+                mpz_set_si(session->memory[findMemoryIndex("DP")].values[0], session->dict_count);
             }
         } else {
             set_error("addCompiledWord: Code length exceeds limit");
@@ -1133,104 +3750,237 @@ void addCompiledWord(char *name, Instruction *code, long int code_length, char *
         set_error("Dictionary full");
     }
 }
+// Argument de PROFILE ; -1 s'il manque ou n'est pas reconnu
+static int profile_mode(const char *arg) {
+    if (!arg) return -1;
+    if (strcmp(arg, "ON") == 0) return PROFILE_ON;
+    if (strcmp(arg, "OFF") == 0) return PROFILE_OFF;
+    if (strcmp(arg, "REPORT") == 0) return PROFILE_REPORT;
+    return -1;
+}
+
 void compileToken(char *token, char **input_rest, int *compile_error) {
     Instruction instr = {0};
     if (strcmp(token, "+") == 0) {
         instr.opcode = OP_ADD;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "-") == 0) {
         instr.opcode = OP_SUB;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "*") == 0) {
         instr.opcode = OP_MUL;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "/") == 0) {
         instr.opcode = OP_DIV;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "MOD") == 0) {
         instr.opcode = OP_MOD;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "DUP") == 0) {
         instr.opcode = OP_DUP;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "SWAP") == 0) {
         instr.opcode = OP_SWAP;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "OVER") == 0) {
         instr.opcode = OP_OVER;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "ROT") == 0) {
         instr.opcode = OP_ROT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "DROP") == 0) {
         instr.opcode = OP_DROP;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "NIP") == 0) {
         instr.opcode = OP_NIP;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "=") == 0) {
         instr.opcode = OP_EQ;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "<") == 0) {
         instr.opcode = OP_LT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, ">") == 0) {
         instr.opcode = OP_GT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "AND") == 0) {
         instr.opcode = OP_AND;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "OR") == 0) {
         instr.opcode = OP_OR;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "NOT") == 0) {
         instr.opcode = OP_NOT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "I") == 0) {
         instr.opcode = OP_I;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "CR") == 0) {
         instr.opcode = OP_CR;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, ".S") == 0) {
         instr.opcode = OP_DOT_S;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, ".") == 0) {
         instr.opcode = OP_DOT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "FLUSH") == 0) {
         instr.opcode = OP_FLUSH;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "IF") == 0) {
         instr.opcode = OP_BRANCH_FALSE;
         instr.operand = 0;
-        currentWord.code[currentWord.code_length++] = instr;
-        control_stack[control_stack_top++] = (ControlEntry){CT_IF, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        session->control_stack[session->control_stack_top++] = (ControlEntry){CT_IF, session->currentWord.code_length - 1};
     } else if (strcmp(token, "ELSE") == 0) {
         instr.opcode = OP_BRANCH;
         instr.operand = 0;
-        currentWord.code[currentWord.code_length++] = instr;
-        if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_IF) {
-            currentWord.code[control_stack[--control_stack_top].addr].operand = currentWord.code_length;
-            control_stack[control_stack_top++] = (ControlEntry){CT_IF, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        if (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_IF) {
+            session->currentWord.code[session->control_stack[--session->control_stack_top].addr].operand = session->currentWord.code_length;
+            session->control_stack[session->control_stack_top++] = (ControlEntry){CT_IF, session->currentWord.code_length - 1};
         }
     } else if (strcmp(token, "THEN") == 0) {
-        if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_IF) {
-            currentWord.code[control_stack[--control_stack_top].addr].operand = currentWord.code_length;
+        if (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_IF) {
+            session->currentWord.code[session->control_stack[--session->control_stack_top].addr].operand = session->currentWord.code_length;
         }
     } else if (strcmp(token, "DO") == 0) {
         instr.opcode = OP_DO;
-        currentWord.code[currentWord.code_length++] = instr;
-        control_stack[control_stack_top++] = (ControlEntry){CT_DO, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        session->control_stack[session->control_stack_top++] = (ControlEntry){CT_DO, session->currentWord.code_length - 1};
     } else if (strcmp(token, "LOOP") == 0) {
-        if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_DO) {
+        if (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_DO) {
             instr.opcode = OP_LOOP;
-            currentWord.code[currentWord.code_length++] = instr;
-            control_stack_top--;
+            session->currentWord.code[session->currentWord.code_length++] = instr;
+            session->control_stack_top--;
         }
     } else if (strcmp(token, "EXIT") == 0) {
         instr.opcode = OP_EXIT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "HEX") == 0 || strcmp(token, "DECIMAL") == 0 ||
+               strcmp(token, "BINARY") == 0 || strcmp(token, "OCTAL") == 0) {
+        instr.opcode = OP_SET_BASE;
+        instr.operand = token[0] == 'H' ? 16 : token[0] == 'B' ? 2 : token[0] == 'O' ? 8 : 10;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "MEMSTATS") == 0) {
+        instr.opcode = OP_MEMSTATS;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "QUEUESTATS") == 0) {
+        instr.opcode = OP_QUEUESTATS;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "CACHESTATS") == 0) {
+        instr.opcode = OP_CACHESTATS;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "STATS") == 0) {
+        instr.opcode = OP_STATS;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "PROFILE-DUMP") == 0) {
+        instr.opcode = OP_PROFILE_DUMP;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "PROFILE") == 0) {
+        char *next_token = strtok_r(NULL, " \t\n", input_rest);
+        instr.opcode = OP_PROFILE;
+        instr.operand = profile_mode(next_token);
+        if (instr.operand < 0) {
+            send_to_channel("PROFILE requires ON, OFF or REPORT");
+            *compile_error = 1;
+            return;
+        }
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "JOBS") == 0) {
+        instr.opcode = OP_JOBS;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "KILL") == 0) {
+        instr.opcode = OP_KILL;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "RESULT") == 0) {
+        instr.opcode = OP_RESULT;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "YIELD") == 0) {
+        if (!session->currentWord.generator) {
+            set_error("YIELD outside of a generator");
+            *compile_error = 1;
+            return;
+        }
+        instr.opcode = OP_YIELD;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "NEXT") == 0) {
+        instr.opcode = OP_NEXT;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "TAKE") == 0) {
+        instr.opcode = OP_TAKE;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "@") == 0) {
+        instr.opcode = OP_FETCH;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "!") == 0) {
+        instr.opcode = OP_STORE;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "FILL") == 0) {
+        instr.opcode = OP_FILL;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "SUM") == 0) {
+        instr.opcode = OP_SUM;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "DOT") == 0) {
+        instr.opcode = OP_DOT_PRODUCT;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "PREFIX-SUM") == 0) {
+        instr.opcode = OP_PREFIX_SUM;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "MINMAX") == 0) {
+        instr.opcode = OP_MINMAX;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "REVERSE") == 0) {
+        instr.opcode = OP_REVERSE;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "COPY") == 0) {
+        instr.opcode = OP_COPY;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "CELLS-ALLOT") == 0) {
+        instr.opcode = OP_CELLS_ALLOT;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "ARRAY-AND") == 0) {
+        instr.opcode = OP_ARRAY_AND;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "ARRAY-OR") == 0) {
+        instr.opcode = OP_ARRAY_OR;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "ARRAY-XOR") == 0) {
+        instr.opcode = OP_ARRAY_XOR;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "ARRAY=") == 0) {
+        instr.opcode = OP_ARRAY_EQ;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "MAP") == 0 || strcmp(token, "REDUCE") == 0) {
+        char *next_token = strtok_r(NULL, " \t\n", input_rest);
+        if (!next_token) {
+            char msg[64];
+            snprintf(msg, sizeof(msg), "%s requires a word name", token);
+            send_to_channel(msg);
+            *compile_error = 1;
+            return;
+        }
+        instr.opcode = token[0] == 'M' ? OP_MAP : OP_REDUCE;
+        instr.operand = session->currentWord.string_count;
+        session->currentWord.strings[session->currentWord.string_count++] = strdup(next_token);
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+    } else if (strcmp(token, "SLICE") == 0) {
+        char *next_token = strtok_r(NULL, " \t\n", input_rest);
+        int opcode = next_token ? slice_opcode(next_token) : -1;
+        char *name = opcode == OP_MAP || opcode == OP_REDUCE ? strtok_r(NULL, " \t\n", input_rest) : NULL;
+        if (opcode < 0 || ((opcode == OP_MAP || opcode == OP_REDUCE) && !name)) {
+            send_to_channel("SLICE requires FILL, SUM, DOT, PREFIX-SUM, MINMAX, REVERSE, COPY, MAP word or REDUCE word");
+            *compile_error = 1;
+            return;
+        }
+        instr.opcode = opcode;
+        instr.operand = BULK_SLICE;
+        if (name) {
+            instr.operand |= session->currentWord.string_count;
+            session->currentWord.strings[session->currentWord.string_count++] = strdup(name);
+        }
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "LOAD") == 0) {
         char *start = *input_rest;
         while (*start && (*start == ' ' || *start == '\t')) start++;
@@ -1249,9 +3999,9 @@ void compileToken(char *token, char **input_rest, int *compile_error) {
         strncpy(filename, start, len);
         filename[len] = '\0';
         instr.opcode = OP_CALL;
-        instr.operand = currentWord.string_count;
-        currentWord.strings[currentWord.string_count++] = filename;
-        currentWord.code[currentWord.code_length++] = instr;
+        instr.operand = session->currentWord.string_count;
+        session->currentWord.strings[session->currentWord.string_count++] = filename;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
         *input_rest = end + 1;
         return;
     } else if (strcmp(token, ".\"") == 0) {
@@ -1266,9 +4016,9 @@ void compileToken(char *token, char **input_rest, int *compile_error) {
         strncpy(str, start, len);
         str[len] = '\0';
         instr.opcode = OP_DOT_QUOTE;
-        instr.operand = currentWord.string_count;
-        currentWord.strings[currentWord.string_count++] = str;
-        currentWord.code[currentWord.code_length++] = instr;
+        instr.operand = session->currentWord.string_count;
+        session->currentWord.strings[session->currentWord.string_count++] = str;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
         *input_rest = end + 1;
         return;
     } else if (strcmp(token, "STRING") == 0) {
@@ -1278,78 +4028,75 @@ void compileToken(char *token, char **input_rest, int *compile_error) {
             return;
         }
         instr.opcode = OP_STRING;
-        instr.operand = currentWord.string_count;
-        currentWord.strings[currentWord.string_count++] = strdup(next_token);
-        currentWord.code[currentWord.code_length++] = instr;
+        instr.operand = session->currentWord.string_count;
+        session->currentWord.strings[session->currentWord.string_count++] = strdup(next_token);
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "EMIT") == 0) {
         instr.opcode = OP_EMIT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "PRINT") == 0) {
         instr.opcode = OP_PRINT;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "S!") == 0) {
         instr.opcode = OP_STORE_STRING;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "PICK") == 0) { // Déjà ajouté
         instr.opcode = OP_PICK;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "RECURSE") == 0) { // Déjà ajouté
         instr.opcode = OP_RECURSE;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else if (strcmp(token, "BEGIN") == 0) {
         instr.opcode = OP_BEGIN;
-        currentWord.code[currentWord.code_length++] = instr;
-        control_stack[control_stack_top++] = (ControlEntry){CT_DO, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        session->control_stack[session->control_stack_top++] = (ControlEntry){CT_DO, session->currentWord.code_length - 1};
     } else if (strcmp(token, "WHILE") == 0) {
         instr.opcode = OP_WHILE;
         instr.operand = 0;
-        currentWord.code[currentWord.code_length++] = instr;
-        control_stack[control_stack_top++] = (ControlEntry){CT_DO, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        session->control_stack[session->control_stack_top++] = (ControlEntry){CT_DO, session->currentWord.code_length - 1};
     } else if (strcmp(token, "REPEAT") == 0) {
-        if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_DO) {
+        if (session->control_stack_top > 1 && session->control_stack[session->control_stack_top-1].type == CT_DO &&
+            session->control_stack[session->control_stack_top-2].type == CT_DO) {
             instr.opcode = OP_REPEAT;
-            currentWord.code[currentWord.code_length++] = instr;
-            int begin_addr = control_stack[control_stack_top-1].addr;
-            currentWord.code[currentWord.code_length-1].operand = begin_addr;
-            instr.opcode = OP_BRANCH;
-            instr.operand = currentWord.code_length;
-            currentWord.code[control_stack[control_stack_top-2].addr].operand = currentWord.code_length;
-            currentWord.code[currentWord.code_length++] = instr;
-            control_stack_top -= 2;
+            instr.operand = session->control_stack[session->control_stack_top-2].addr; // Retour au BEGIN
+            session->currentWord.code[session->currentWord.code_length++] = instr;
+            session->currentWord.code[session->control_stack[session->control_stack_top-1].addr].operand = session->currentWord.code_length; // Sortie du WHILE
+            session->control_stack_top -= 2;
         } else {
             set_error("REPEAT without BEGIN/WHILE");
             *compile_error = 1;
         }
     } else if (strcmp(token, "CASE") == 0) {
         instr.opcode = OP_CASE;
-        currentWord.code[currentWord.code_length++] = instr;
-        control_stack[control_stack_top++] = (ControlEntry){CT_CASE, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        session->control_stack[session->control_stack_top++] = (ControlEntry){CT_CASE, session->currentWord.code_length - 1};
     } else if (strcmp(token, "OF") == 0) {
         instr.opcode = OP_OF;
         instr.operand = 0;
-        currentWord.code[currentWord.code_length++] = instr;
-        control_stack[control_stack_top++] = (ControlEntry){CT_OF, currentWord.code_length - 1};
+        session->currentWord.code[session->currentWord.code_length++] = instr;
+        session->control_stack[session->control_stack_top++] = (ControlEntry){CT_OF, session->currentWord.code_length - 1};
     } else if (strcmp(token, "ENDOF") == 0) {
-        if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_OF) {
+        if (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_OF) {
             instr.opcode = OP_ENDOF;
             instr.operand = 0;
-            currentWord.code[currentWord.code_length++] = instr;
-            currentWord.code[control_stack[control_stack_top-1].addr].operand = currentWord.code_length;
-            control_stack[control_stack_top-1].type = CT_ENDOF;
-            control_stack[control_stack_top-1].addr = currentWord.code_length - 1;
+            session->currentWord.code[session->currentWord.code_length++] = instr;
+            session->currentWord.code[session->control_stack[session->control_stack_top-1].addr].operand = session->currentWord.code_length;
+            session->control_stack[session->control_stack_top-1].type = CT_ENDOF;
+            session->control_stack[session->control_stack_top-1].addr = session->currentWord.code_length - 1;
         } else {
             set_error("ENDOF without OF");
             *compile_error = 1;
         }
     } else if (strcmp(token, "ENDCASE") == 0) {
-        if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_ENDOF) {
+        if (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_ENDOF) {
             instr.opcode = OP_ENDCASE;
-            currentWord.code[currentWord.code_length++] = instr;
-            while (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_ENDOF) {
-                currentWord.code[control_stack[--control_stack_top].addr].operand = currentWord.code_length;
+            session->currentWord.code[session->currentWord.code_length++] = instr;
+            while (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_ENDOF) {
+                session->currentWord.code[session->control_stack[--session->control_stack_top].addr].operand = session->currentWord.code_length;
             }
-            if (control_stack_top > 0 && control_stack[control_stack_top-1].type == CT_CASE) {
-                control_stack_top--; // Ferme le CASE
+            if (session->control_stack_top > 0 && session->control_stack[session->control_stack_top-1].type == CT_CASE) {
+                session->control_stack_top--; // Ferme le CASE
             } else {
                 set_error("ENDCASE without CASE");
                 *compile_error = 1;
@@ -1369,7 +4116,7 @@ void compileToken(char *token, char **input_rest, int *compile_error) {
     if (index >= 0) {
         instr.opcode = OP_SEE;
         instr.operand = index;
-        currentWord.code[currentWord.code_length++] = instr;
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else {
         char msg[512];
         snprintf(msg, sizeof(msg), "SEE: Unknown word: %s", next_token);
@@ -1383,23 +4130,26 @@ void compileToken(char *token, char **input_rest, int *compile_error) {
             return;
         }
         instr.opcode = OP_VARIABLE;
-        instr.operand = currentWord.string_count;
-        currentWord.strings[currentWord.string_count++] = strdup(next_token);
-        currentWord.code[currentWord.code_length++] = instr;
+        instr.operand = session->currentWord.string_count;
+        session->currentWord.strings[session->currentWord.string_count++] = strdup(next_token);
+        session->currentWord.code[session->currentWord.code_length++] = instr;
     } else {
         long int index = findCompiledWordIndex(token);
         if (index >= 0) {
             instr.opcode = OP_CALL;
             instr.operand = index;
-            currentWord.code[currentWord.code_length++] = instr;
+            session->currentWord.code[session->currentWord.code_length++] = instr;
         } else {
             mpz_t test_num;
             mpz_init(test_num);
-            if (mpz_set_str(test_num, token, 10) == 0) {
+            if (parse_number(test_num, token) == 0) {
+                // Littéral converti en décimal à la compilation : OP_PUSH le relit en base 10
+                char *literal = malloc(mpz_sizeinbase(test_num, 10) + 2);
+                mpz_get_str(literal, 10, test_num);
                 instr.opcode = OP_PUSH;
-                instr.operand = currentWord.string_count;
-                currentWord.strings[currentWord.string_count++] = strdup(token);
-                currentWord.code[currentWord.code_length++] = instr;
+                instr.operand = session->currentWord.string_count;
+                session->currentWord.strings[session->currentWord.string_count++] = literal;
+                session->currentWord.code[session->currentWord.code_length++] = instr;
             } else {
                 char msg[512];
                 snprintf(msg, sizeof(msg), "Unknown word: %s", token);
@@ -1410,58 +4160,61 @@ void compileToken(char *token, char **input_rest, int *compile_error) {
         }
     }
 }
-void interpret(char *input, Stack *stack) {
-    error_flag = 0;
+static void interpret_line(char *input, Stack *stack) {
+    session->error_flag = 0;
     int compile_error = 0;
     char *saveptr;
     char *token = strtok_r(input, " \t\n", &saveptr);
 
-    while (token && !error_flag) {
-        if (compiling) {
+    while (token && !session->error_flag) {
+        if (session->compiling) {
+            int previous = phase_switch(PHASE_COMPILE);
             if (strcmp(token, ";") == 0) {
-                if (currentWord.code_length >= WORD_CODE_SIZE - 1) {
+                if (session->currentWord.code_length >= WORD_CODE_SIZE - 1) {
                     char msg[512];
-                    snprintf(msg, sizeof(msg), "Definition failed for %s: code length exceeds %d", currentWord.name, WORD_CODE_SIZE);
+                    snprintf(msg, sizeof(msg), "Definition failed for %s: code length exceeds %d", session->currentWord.name, WORD_CODE_SIZE);
                     send_to_channel(msg);
                     compile_error = 1;
                 } else {
                     Instruction end = {OP_END, 0};
-                    currentWord.code[currentWord.code_length++] = end;
+                    session->currentWord.code[session->currentWord.code_length++] = end;
                 }
 
                 if (compile_error) {
-                    int index = findCompiledWordIndex(currentWord.name);
+                    int index = findCompiledWordIndex(session->currentWord.name);
                     if (index >= 0) {
                         Instruction forget_instr = {OP_FORGET, index};
                         CompiledWord temp = {.code_length = 1, .string_count = 0};
                         temp.code[0] = forget_instr;
                         executeCompiledWord(&temp, stack, -1);
                         char msg[512];
-                        snprintf(msg, sizeof(msg), "Definition aborted due to error, %s forgotten", currentWord.name);
+                        snprintf(msg, sizeof(msg), "Definition aborted due to error, %s forgotten", session->currentWord.name);
                         send_to_channel(msg);
                     } else {
                         char msg[512];
-                        snprintf(msg, sizeof(msg), "Definition failed for %s: compilation error", currentWord.name);
+                        snprintf(msg, sizeof(msg), "Definition failed for %s: compilation error", session->currentWord.name);
                         send_to_channel(msg);
                     }
                 } else {
-                    addCompiledWord(currentWord.name, currentWord.code, currentWord.code_length, 
-                                    currentWord.strings, currentWord.string_count);
+                    addCompiledWord(session->currentWord.name, session->currentWord.code, session->currentWord.code_length, 
+                                    session->currentWord.strings, session->currentWord.string_count);
+                    if (session->currentWord.generator && !session->error_flag) generator_declare(session->currentWord.generator_args);
                     // char msg[512];
                     // snprintf(msg, sizeof(msg), "Defined: %s", currentWord.name);
                     // send_to_channel(msg);
                 }
 
-                free(currentWord.name);
-                for (int i = 0; i < currentWord.string_count; i++) {
-                    if (currentWord.strings[i]) free(currentWord.strings[i]);
+                free(session->currentWord.name);
+                for (int i = 0; i < session->currentWord.string_count; i++) {
+                    if (session->currentWord.strings[i]) free(session->currentWord.strings[i]);
                 }
-                compiling = 0;
-                current_word_index = -1;
+                session->compiling = 0;
+                session->current_word_index = -1;
                 compile_error = 0;
             } else {
                 compileToken(token, &saveptr, &compile_error);
             }
+            phase_switch(previous);
         } else {
             CompiledWord temp = {.code_length = 0, .string_count = 0};
             mpz_t big_value;
@@ -1485,19 +4238,34 @@ void interpret(char *input, Stack *stack) {
                 temp.strings[temp.string_count++] = str;
                 executeCompiledWord(&temp, stack, -1);
                 saveptr = end + 1; // Avance après le " fermant
-            } else if (mpz_set_str(big_value, token, 10) == 0) {
+            } else if ((current_base() <= 10 || strchr("$%#", token[0])) && parse_number(big_value, token) == 0) {
                 push(stack, big_value);
-            } else if (strcmp(token, ":") == 0) {
+            } else if (strcmp(token, ":") == 0 || strcmp(token, "GENERATOR") == 0) {
+                int generator = token[0] == 'G';
                 token = strtok_r(NULL, " \t\n", &saveptr);
                 if (token) {
-                    compiling = 1;
-                    currentWord.name = strdup(token);
-                    currentWord.code_length = 0;
-                    currentWord.string_count = 0;
-                    current_word_index = findCompiledWordIndex(currentWord.name);
-                    if (current_word_index < 0) current_word_index = dict_count;
+                    session->compiling = 1;
+                    session->currentWord.name = strdup(token);
+                    session->currentWord.code_length = 0;
+                    session->currentWord.string_count = 0;
+                    session->currentWord.generator = generator;
+                    session->currentWord.generator_args = 0;
+                    session->current_word_index = findCompiledWordIndex(session->currentWord.name);
+                    if (session->current_word_index < 0) session->current_word_index = session->dict_count;
+                    char *rest = saveptr;
+                    while (generator && (*rest == ' ' || *rest == '\t')) rest++;
+                    if (generator && rest[0] == '(' && (rest[1] == ' ' || rest[1] == '\t')) {
+                        // ( a b -- ) : les valeurs avant -- sont prises sur la pile à la création
+                        int before = 1;
+                        strtok_r(NULL, " \t\n", &saveptr);
+                        while ((token = strtok_r(NULL, " \t\n", &saveptr)) && strcmp(token, ")") != 0) {
+                            if (strcmp(token, "--") == 0) before = 0;
+                            else if (before) session->currentWord.generator_args++;
+                        }
+                        if (before) session->currentWord.generator_args = 0; // Simple commentaire
+                    }
                 } else {
-                    send_to_channel("Colon requires a word name");
+                    send_to_channel(generator ? "GENERATOR requires a word name" : "Colon requires a word name");
                 }
             } else if (strcmp(token, "LOAD") == 0) {
                 char *start = saveptr;
@@ -1643,6 +4411,140 @@ void interpret(char *input, Stack *stack) {
                 temp.code_length = 1;
                 temp.code[0] = (Instruction){OP_EXIT, 0};
                 executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "HEX") == 0 || strcmp(token, "DECIMAL") == 0 ||
+                       strcmp(token, "BINARY") == 0 || strcmp(token, "OCTAL") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_SET_BASE, token[0] == 'H' ? 16 : token[0] == 'B' ? 2 : token[0] == 'O' ? 8 : 10};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "MEMSTATS") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_MEMSTATS, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "QUEUESTATS") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_QUEUESTATS, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "CACHESTATS") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_CACHESTATS, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "STATS") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_STATS, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "PROFILE-DUMP") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_PROFILE_DUMP, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "PROFILE") == 0) {
+                int mode = profile_mode(strtok_r(NULL, " \t\n", &saveptr));
+                if (mode < 0) {
+                    send_to_channel("PROFILE requires ON, OFF or REPORT");
+                    mpz_clear(big_value);
+                    return;
+                }
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_PROFILE, mode};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "JOBS") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_JOBS, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "KILL") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_KILL, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "RESULT") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_RESULT, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "MEMO") == 0) {
+                memo_declare();
+            } else if (strcmp(token, "YIELD") == 0 || strcmp(token, "NEXT") == 0 || strcmp(token, "TAKE") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){token[0] == 'Y' ? OP_YIELD : token[0] == 'N' ? OP_NEXT : OP_TAKE, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "SPAWN") == 0) {
+                job_spawn(saveptr); // Le reste de la ligne devient le job
+                saveptr += strlen(saveptr);
+            } else if (strcmp(token, "FILL") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_FILL, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "SUM") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_SUM, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "DOT") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_DOT_PRODUCT, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "PREFIX-SUM") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_PREFIX_SUM, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "MINMAX") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_MINMAX, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "REVERSE") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_REVERSE, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "COPY") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_COPY, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "CELLS-ALLOT") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_CELLS_ALLOT, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "ARRAY-AND") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_ARRAY_AND, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "ARRAY-OR") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_ARRAY_OR, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "ARRAY-XOR") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_ARRAY_XOR, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "ARRAY=") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_ARRAY_EQ, 0};
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "MAP") == 0 || strcmp(token, "REDUCE") == 0) {
+                char *next_token = strtok_r(NULL, " \t\n", &saveptr);
+                if (!next_token) {
+                    char msg[64];
+                    snprintf(msg, sizeof(msg), "%s requires a word name", token);
+                    send_to_channel(msg);
+                    mpz_clear(big_value);
+                    return;
+                }
+                temp.code_length = 1;
+                temp.code[0].opcode = token[0] == 'M' ? OP_MAP : OP_REDUCE;
+                temp.code[0].operand = temp.string_count;
+                temp.strings[temp.string_count++] = next_token; // Utilisé avant la fin de interpret
+                executeCompiledWord(&temp, stack, -1);
+            } else if (strcmp(token, "SLICE") == 0) {
+                char *next_token = strtok_r(NULL, " \t\n", &saveptr);
+                int opcode = next_token ? slice_opcode(next_token) : -1;
+                char *name = opcode == OP_MAP || opcode == OP_REDUCE ? strtok_r(NULL, " \t\n", &saveptr) : NULL;
+                if (opcode < 0 || ((opcode == OP_MAP || opcode == OP_REDUCE) && !name)) {
+                    send_to_channel("SLICE requires FILL, SUM, DOT, PREFIX-SUM, MINMAX, REVERSE, COPY, MAP word or REDUCE word");
+                    mpz_clear(big_value);
+                    return;
+                }
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){opcode, BULK_SLICE};
+                if (name) {
+                    temp.code[0].operand |= temp.string_count;
+                    temp.strings[temp.string_count++] = name; // Utilisé avant la fin de interpret
+                }
+                executeCompiledWord(&temp, stack, -1);
             } else if (strcmp(token, "&") == 0) {
                 temp.code_length = 1;
                 temp.code[0] = (Instruction){OP_BIT_AND, 0};
@@ -1786,10 +4688,10 @@ else if (strcmp(token, "STRING") == 0) {
                 temp.code[0] = (Instruction){OP_IRC_SEND, 0};
                 executeCompiledWord(&temp, stack, -1);
             } else if (strcmp(token, "RECURSE") == 0) {
-                if (current_word_index >= 0) {
+                if (session->current_word_index >= 0) {
                     temp.code_length = 1;
                     temp.code[0] = (Instruction){OP_RECURSE, 0};
-                    executeCompiledWord(&temp, stack, current_word_index);
+                    executeCompiledWord(&temp, stack, session->current_word_index);
                 } else {
                     send_to_channel("RECURSE used outside a definition");
                 }
@@ -1811,6 +4713,8 @@ else if (strcmp(token, "STRING") == 0) {
                     temp.code_length = 1;
                     temp.code[0] = (Instruction){OP_CALL, index};
                     executeCompiledWord(&temp, stack, index);
+                } else if (parse_number(big_value, token) == 0) {
+                    push(stack, big_value); // Base > 10 : les mots passent avant les nombres
                 } else {
                     char msg[512];
                     snprintf(msg, sizeof(msg), "Unknown word: %s", token);
@@ -1822,111 +4726,2785 @@ else if (strcmp(token, "STRING") == 0) {
         token = strtok_r(NULL, " \t\n", &saveptr);
     }
 
-    if (compiling && !token) {
+    if (session->compiling && !token) {
         send_to_channel("Error: Incomplete definition detected, resetting compilation");
-        free(currentWord.name);
-        for (int i = 0; i < currentWord.string_count; i++) {
-            if (currentWord.strings[i]) free(currentWord.strings[i]);
+        free(session->currentWord.name);
+        for (int i = 0; i < session->currentWord.string_count; i++) {
+            if (session->currentWord.strings[i]) free(session->currentWord.strings[i]);
         }
-        compiling = 0;
-        current_word_index = -1;
+        session->compiling = 0;
+        session->current_word_index = -1;
         compile_error = 0;
     }
 }
-void irc_connect(Stack *stack) {
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        printf("Socket creation failed\n");
-        return;
+// Une commande est une transaction : si set_error s'est déclenché, rien n'en reste
+void interpret(char *input, Stack *stack) {
+    txn_begin();
+    interpret_line(input, stack);
+    txn_end();
+}
+void mpsc_init(MpscQueue *queue) {
+    for (unsigned long i = 0; i < queue->size; i++) {
+        atomic_store_explicit(&queue->cells[i].sequence, i, memory_order_relaxed);
+    }
+    if (pipe(queue->wake) == 0) {
+        fcntl(queue->wake[0], F_SETFL, O_NONBLOCK);
+        fcntl(queue->wake[1], F_SETFL, O_NONBLOCK);
+    }
+}
+
+// Retourne 0 si la file est pleine
+int mpsc_push(MpscQueue *queue, void *item) {
+    unsigned long pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    while (1) {
+        QueueCell *cell = &queue->cells[pos & (queue->size - 1)];
+        unsigned long sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+        long diff = (long)(sequence - pos);
+        if (diff == 0) {
+            // Case libre : on la réserve en avançant tail
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                cell->item = item;
+                atomic_store_explicit(&cell->sequence, pos + 1, memory_order_release);
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
     }
+    if (queue->wake[1] != -1) {
+        char c = 0;
+        if (write(queue->wake[1], &c, 1) < 0) { /* Tube plein : un réveil est déjà en attente */ }
+    }
+    return 1;
+}
 
-    struct sockaddr_in server;
-    server.sin_family = AF_INET;
-    server.sin_port = htons(6667);
-    server.sin_addr.s_addr = inet_addr("213.165.83.201"); 
+// Retourne NULL si la file est vide
+void *mpsc_pop(MpscQueue *queue) {
+    unsigned long pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    QueueCell *cell = &queue->cells[pos & (queue->size - 1)];
+    unsigned long sequence = atomic_load_explicit(&cell->sequence, memory_order_acquire);
+    if ((long)(sequence - (pos + 1)) < 0) return NULL;
+    void *item = cell->item;
+    atomic_store_explicit(&cell->sequence, pos + queue->size, memory_order_release);
+    atomic_store_explicit(&queue->head, pos + 1, memory_order_relaxed);
+    return item;
+}
 
-    if (connect(sock, (struct sockaddr*)&server, sizeof(server)) < 0) {
-        printf("Connection to labynet.fr failed\n");
-        close(sock);
-        return;
+// Découpe une ligne IRC sans copie : [@tags] [:nick!user@host] COMMANDE params [:dernier]
+// Les spans pointent dans line ; renvoie 0 si la ligne n'a pas de commande
+int irc_parse(const char *line, size_t len, IrcMessage *msg) {
+    const char *p = line, *end = line + len;
+    memset(msg, 0, sizeof(*msg));
+    if (p < end && *p == '@') {
+        const char *space = memchr(p, ' ', end - p);
+        if (!space) return 0;
+        msg->tags = (Span){p + 1, space - p - 1};
+        p = space;
+        while (p < end && *p == ' ') p++;
+    }
+    if (p < end && *p == ':') {
+        const char *space = memchr(p, ' ', end - p);
+        if (!space) return 0;
+        const char *q = p + 1;
+        msg->nick.p = q;
+        while (q < space && *q != '!' && *q != '@') q++;
+        msg->nick.len = q - msg->nick.p;
+        if (q < space && *q == '!') {
+            msg->user.p = ++q;
+            while (q < space && *q != '@') q++;
+            msg->user.len = q - msg->user.p;
+        }
+        if (q < space && *q == '@') msg->host = (Span){q + 1, space - q - 1};
+        p = space;
+        while (p < end && *p == ' ') p++;
+    }
+    msg->command.p = p;
+    while (p < end && *p != ' ') p++;
+    msg->command.len = p - msg->command.p;
+    if (msg->command.len == 0) return 0;
+    while (p < end && msg->param_count < IRC_MAX_PARAMS) {
+        while (p < end && *p == ' ') p++;
+        if (p >= end) break;
+        Span *param = &msg->params[msg->param_count++];
+        if (*p == ':' || msg->param_count == IRC_MAX_PARAMS) { // Dernier paramètre : jusqu'au bout de la ligne
+            if (*p == ':') p++;
+            *param = (Span){p, end - p};
+            break;
+        }
+        param->p = p;
+        while (p < end && *p != ' ') p++;
+        param->len = p - param->p;
     }
+    return 1;
+}
+
+static int span_eq(Span span, const char *text, size_t len) {
+    return span.len == len && memcmp(span.p, text, len) == 0;
+}
 
-    irc_socket = sock;
+static void irc_on_ping(Network *net, const IrcMessage *msg) {
+    char pong[IRC_LINE_MAX + 16];
+    Span token = msg->param_count ? msg->params[0] : (Span){"", 0};
+    int len = snprintf(pong, sizeof(pong), "PONG :%.*s\r\n", (int)token.len, token.p);
+    outbound_push(net, OUTPUT_PRIORITY, pong, len < (int)sizeof(pong) ? len : (int)sizeof(pong) - 1);
+}
 
-    char nick_cmd[512], user_cmd[512], join_cmd[512];
-    snprintf(nick_cmd, sizeof(nick_cmd), "NICK %s\r\n", BOT_NAME);
-    snprintf(user_cmd, sizeof(user_cmd), "USER %s 0 * :Forth IRC Bot\r\n", BOT_NAME);
-    snprintf(join_cmd, sizeof(join_cmd), "JOIN %s\r\n", CHANNEL);
-    send(irc_socket, nick_cmd, strlen(nick_cmd), 0);
-    send(irc_socket, user_cmd, strlen(user_cmd), 0);
-    send(irc_socket, join_cmd, strlen(join_cmd), 0);
+// Enregistrement accepté : rejoint les canaux du réseau
+static void irc_on_welcome(Network *net, const IrcMessage *msg) {
+    (void)msg;
+    printf("Registered on %s as %s\n", net->name, net->nick);
+    for (int i = 0; i < net->channel_count; i++) {
+        char join[96];
+        int len = snprintf(join, sizeof(join), "JOIN %s\r\n", net->channels[i]);
+        outbound_push(net, OUTPUT_PRIORITY, join, len);
+    }
+}
 
-    mpz_set_si(mpz_pool[0], irc_socket);
-    push(stack, mpz_pool[0]);
+// Pseudo déjà pris : on réessaie avec un « _ » de plus
+static void irc_on_nick_in_use(Network *net, const IrcMessage *msg) {
+    (void)msg;
+    size_t len = strlen(net->nick);
+    if (len + 1 >= sizeof(net->nick)) return;
+    net->nick[len] = '_';
+    net->nick[len + 1] = '\0';
+    char nick[64];
+    int n = snprintf(nick, sizeof(nick), "NICK %s\r\n", net->nick);
+    outbound_push(net, OUTPUT_PRIORITY, nick, n);
 }
 
- 
-int main() {
-    int sock;
-    Stack stack;
-    initStack(&stack);
-    init_mpz_pool();
-    char dp_cmd[] = "VARIABLE DP DROP";
-    interpret(dp_cmd, &stack);
-    int dp_idx = findMemoryIndex("DP");
-    if (dp_idx >= 0) {
-        mpz_set_si(memory[dp_idx].values[0], 0);
-    } else {
-        printf("DP non trouvé\n");
+static int network_has_channel(Network *net, Span target) {
+    for (int i = 0; i < net->channel_count; i++) {
+        if (strlen(net->channels[i]) == target.len && strncasecmp(net->channels[i], target.p, target.len) == 0) return 1;
     }
-    printf("Forth-like interpreter with GMP\n");
-    char buffer[512];
-    while (1) {
-        irc_connect(&stack);
-        if (stack.top < 0) {
-            printf("Failed to connect, retrying in 5 seconds...\n");
-            sleep(5);
-            continue;
-        }
-        sock = mpz_get_si(stack.data[stack.top]);
-        stack.top--;
+    return 0;
+}
 
-        printf("Connected to labynet.fr\n");
+// « pseudo: commande » sur un canal du réseau, ou n'importe quel texte en message privé ; la réponse part au même endroit
+static void irc_on_privmsg(Network *net, const IrcMessage *msg) {
+    if (msg->param_count < 2 || msg->nick.len == 0) return;
+    Span target = msg->params[0], text = msg->params[1];
+    size_t nick_len = strlen(net->nick);
+    int query = target.len == nick_len && strncasecmp(target.p, net->nick, nick_len) == 0;
+    int prefixed = text.len > nick_len && strncmp(text.p, net->nick, nick_len) == 0 && text.p[nick_len] == ':';
+    if (!query && !(prefixed && network_has_channel(net, target))) return;
+    if (prefixed) {
+        text.p += nick_len + 1;
+        text.len -= nick_len + 1;
+    }
+    Span reply = query ? msg->nick : target;
+    if (!network_submit(net, msg->nick, text, reply)) {
+        char busy[128];
+        int len = snprintf(busy, sizeof(busy), "PRIVMSG %.*s :Busy: command dropped\r\n", (int)reply.len, reply.p);
+        outbound_push(net, OUTPUT_PRIORITY, busy, len < (int)sizeof(busy) ? len : (int)sizeof(busy) - 1);
+    }
+}
 
-        while (1) {
-            int bytes = recv(sock, buffer, sizeof(buffer) - 1, 0);
-            if (bytes <= 0) {
-                printf("Disconnected from labynet.fr, attempting to reconnect in 5 seconds...\n");
-                close(sock);
-                sleep(5);
-                break;
-            }
-            buffer[bytes] = '\0';
-            //printf("Received: %s", buffer);
+static const struct {
+    const char *command;
+    size_t len;
+    void (*handler)(Network *net, const IrcMessage *msg);
+} irc_handlers[] = {
+    {"PING", 4, irc_on_ping},
+    {"PRIVMSG", 7, irc_on_privmsg},
+    {"001", 3, irc_on_welcome},
+    {"433", 3, irc_on_nick_in_use},
+};
 
-            if (strstr(buffer, "PING ") == buffer) {
-                char pong[512];
-                snprintf(pong, sizeof(pong), "PONG %s\r\n", buffer + 5);
-                send(sock, pong, strlen(pong), 0);
-                //printf("Sent: %s", pong);
-                continue;
-            }
+// Thread réseau : une ligne reçue, sans CRLF, transmise au gestionnaire de sa commande
+void irc_handle_data(Network *net, int slot, char *buffer) {
+    (void)slot;
+    IrcMessage msg;
+    if (!irc_parse(buffer, strlen(buffer), &msg)) return;
+    for (size_t i = 0; i < sizeof(irc_handlers) / sizeof(irc_handlers[0]); i++) {
+        if (span_eq(msg.command, irc_handlers[i].command, irc_handlers[i].len)) {
+            irc_handlers[i].handler(net, &msg);
+            return;
+        }
+    }
+}
 
-            char prefix[512];
-            snprintf(prefix, sizeof(prefix), "PRIVMSG %s :%s:", CHANNEL, BOT_NAME);
-            char *msg = strstr(buffer, prefix);
-            if (msg) {
-                char forth_cmd[512];
-                snprintf(forth_cmd, sizeof(forth_cmd), "%s", msg + strlen(prefix));
-                forth_cmd[strcspn(forth_cmd, "\r\n")] = '\0';
-                //printf("Executing: %s\n", forth_cmd);
-                interpret(forth_cmd, &stack);
+// FORTH_FLOOD_BURST lignes d'avance, puis une toutes les FORTH_FLOOD_INTERVAL_MS ; FORTH_OUTPUT_BACKLOG lignes en attente au plus.
+// Un seau par réseau, chaque serveur compte de son côté.
+void init_outbound() {
+    char *env = getenv("FORTH_FLOOD_BURST");
+    if (env && atoi(env) > 0) flood.burst = atoi(env);
+    env = getenv("FORTH_FLOOD_INTERVAL_MS");
+    if (env) flood.interval_ms = strtoul(env, NULL, 10);
+    env = getenv("FORTH_OUTPUT_BACKLOG");
+    if (env && atol(env) > 0) flood.backlog = atol(env);
+    for (int i = 0; i < MAX_NETWORKS; i++) {
+        networks[i].out.tokens = flood.burst;
+        networks[i].out.refill_us = now_us();
+    }
+}
+
+static void outbound_append(Outbound *out, int lane, OutLine *line) {
+    line->next = NULL;
+    if (out->tail[lane]) out->tail[lane]->next = line;
+    else out->head[lane] = line;
+    out->tail[lane] = line;
+    out->count[lane]++;
+    atomic_fetch_add_explicit(&out->queued, 1, memory_order_relaxed);
+}
+
+// Thread réseau : ajoute une ligne "...\r\n" ; au-delà du plafond, les lignes de volume sont comptées puis jetées
+void outbound_push(Network *net, int lane, const char *text, size_t len) {
+    Outbound *out = &net->out;
+    if (lane == OUTPUT_BULK && out->count[OUTPUT_BULK] >= flood.backlog) {
+        const char *target = text + 8; // "PRIVMSG cible :..."
+        size_t target_len = strcspn(target, " ");
+        if (strncmp(text, "PRIVMSG ", 8) == 0 && target_len < sizeof(out->suppressed_target)) {
+            memcpy(out->suppressed_target, target, target_len);
+            out->suppressed_target[target_len] = '\0';
+        }
+        out->suppressed++;
+        atomic_fetch_add_explicit(&out->suppressed_total, 1, memory_order_relaxed);
+        return;
+    }
+    OutLine *line = malloc(sizeof(OutLine) + len);
+    if (!line) return;
+    memcpy(line->text, text, len);
+    line->len = len;
+    outbound_append(out, lane, line);
+}
+
+// Un lot d'output_queue : octet de voie, octet de réseau, puis lignes PRIVMSG
+static void outbound_take(Network *net, const char *batch) {
+    int lane = batch[0] == '0' + OUTPUT_PRIORITY ? OUTPUT_PRIORITY : OUTPUT_BULK;
+    for (const char *p = batch + 2, *end; *p; p = end + 2) {
+        end = strstr(p, "\r\n");
+        if (!end) break;
+        outbound_push(net, lane, p, end + 2 - p);
+    }
+}
+
+// Intervalle nul : pas de seau, chaque tour remplit un writev entier quelle que soit la rafale
+static void outbound_refill(Outbound *out) {
+    long long now = now_us();
+    if (flood.interval_ms == 0) {
+        out->tokens = OUTPUT_WRITEV_MAX;
+    } else {
+        out->tokens += (double)(now - out->refill_us) / (flood.interval_ms * 1000.0);
+        if (out->tokens > flood.burst) out->tokens = flood.burst;
+    }
+    out->refill_us = now;
+}
+
+// Envoie ce que le seau autorise, voie prioritaire d'abord, sans bloquer ; une ligne entamée a déjà payé son jeton
+static void outbound_send(Network *net) {
+    Outbound *out = &net->out;
+    while (1) {
+        outbound_refill(out);
+        if (out->suppressed && !out->head[OUTPUT_BULK]) {
+            char summary[160];
+            int len = snprintf(summary, sizeof(summary), "PRIVMSG %s :... %ld lines suppressed\r\n",
+                               out->suppressed_target[0] ? out->suppressed_target : net->channels[0], out->suppressed);
+            out->suppressed = 0;
+            outbound_push(net, OUTPUT_BULK, summary, len);
+        }
+        while (out->tokens >= 1 && out->inflight_count < OUTPUT_WRITEV_MAX) {
+            int lane = out->head[OUTPUT_PRIORITY] ? OUTPUT_PRIORITY : OUTPUT_BULK;
+            OutLine *line = out->head[lane];
+            if (!line) break;
+            out->head[lane] = line->next;
+            if (!out->head[lane]) out->tail[lane] = NULL;
+            out->count[lane]--;
+            out->inflight[out->inflight_count++] = line;
+            out->tokens -= 1;
+        }
+        if (out->inflight_count == 0) return;
+        struct iovec iov[OUTPUT_WRITEV_MAX];
+        for (int i = 0; i < out->inflight_count; i++) {
+            iov[i] = (struct iovec){out->inflight[i]->text, out->inflight[i]->len};
+        }
+        iov[0].iov_base = (char *)iov[0].iov_base + out->offset;
+        iov[0].iov_len -= out->offset;
+        ssize_t sent = writev(net->sock, iov, out->inflight_count);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            out->blocked = errno == EAGAIN || errno == EWOULDBLOCK; // Reprise sur EPOLLOUT
+            return;
+        }
+        out->blocked = 0;
+        int done = 0;
+        while (done < out->inflight_count && (size_t)sent >= iov[done].iov_len) {
+            sent -= iov[done].iov_len;
+            free(out->inflight[done++]);
+            out->offset = 0;
+            atomic_fetch_sub_explicit(&out->queued, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&out->sent, 1, memory_order_relaxed);
+        }
+        out->offset += sent;
+        memmove(out->inflight, out->inflight + done, (out->inflight_count - done) * sizeof(OutLine *));
+        out->inflight_count -= done;
+        if (out->inflight_count > 0) { // Écriture partielle : le socket est plein
+            out->blocked = 1;
+            return;
+        }
+    }
+}
+
+// Thread réseau : délai d'attente jusqu'au prochain jeton (-1 : rien à attendre)
+int outbound_timeout_ms(Network *net) {
+    Outbound *out = &net->out;
+    if (net->sock < 0 || net->connecting || out->blocked || (!out->head[OUTPUT_PRIORITY] && !out->head[OUTPUT_BULK])) return -1;
+    if (out->tokens >= 1) return 0;
+    return (int)((1 - out->tokens) * flood.interval_ms) + 1;
+}
+
+// Connexion perdue : tout ce qui attendait est jeté
+static void outbound_reset(Network *net) {
+    Outbound *out = &net->out;
+    for (int lane = 0; lane < 2; lane++) {
+        while (out->head[lane]) {
+            OutLine *line = out->head[lane];
+            out->head[lane] = line->next;
+            free(line);
+        }
+        out->tail[lane] = NULL;
+        out->count[lane] = 0;
+    }
+    for (int i = 0; i < out->inflight_count; i++) free(out->inflight[i]);
+    out->inflight_count = 0;
+    out->offset = 0;
+    out->blocked = 0;
+    out->suppressed = 0;
+    atomic_store_explicit(&out->queued, 0, memory_order_relaxed);
+    out->tokens = flood.burst;
+    out->refill_us = now_us();
+}
+
+// Thread de travail : une commande d'un transport local est terminée ; il peut relire s'il était à sa limite
+void network_command_done(int index) {
+    Network *net = &networks[index];
+    if (atomic_fetch_sub_explicit(&net->commands, 1, memory_order_relaxed) == net->max_commands) {
+        char c = 0;
+        if (write(output_queue.wake[1], &c, 1) < 0) { /* Tube plein : un réveil est déjà en attente */ }
+    }
+}
+
+static int network_paused(Network *net) {
+    return net->max_commands && atomic_load_explicit(&net->commands, memory_order_relaxed) >= net->max_commands;
+}
+
+// Thread réseau : commande lue par un transport, exécutée dans la session « nick » (« nick@réseau » après le premier)
+// et dont la réponse part vers reply_to ; 0 si la file de l'ordonnanceur est pleine
+int network_submit(Network *net, Span nick, Span command, Span reply_to) {
+    PendingCommand *pending = malloc(sizeof(PendingCommand));
+    if (!pending) return 0;
+    int index = (int)(net - networks);
+    if (index == 0) snprintf(pending->nick, sizeof(pending->nick), "%.*s", (int)nick.len, nick.p);
+    else snprintf(pending->nick, sizeof(pending->nick), "%.*s@%s", (int)nick.len, nick.p, net->name);
+    snprintf(pending->command, sizeof(pending->command), "%.*s", (int)command.len, command.p);
+    snprintf(pending->reply_to, sizeof(pending->reply_to), "%.*s", (int)reply_to.len, reply_to.p);
+    pending->network = index;
+    pending->counted = net->max_commands > 0;
+    if (pending->counted) atomic_fetch_add_explicit(&net->commands, 1, memory_order_relaxed);
+    if (scheduler_submit(pending)) return 1;
+    if (pending->counted) atomic_fetch_sub_explicit(&net->commands, 1, memory_order_relaxed);
+    free(pending);
+    return 0;
+}
+
+// Surveillance epoll d'un descripteur : ajout, modification, ou retrait quand plus rien n'est attendu
+static void network_watch(int epfd, int fd, uint64_t key, unsigned int *current, unsigned int events) {
+    if (*current == events) return;
+    struct epoll_event ev = {.events = events, .data.u64 = key};
+    epoll_ctl(epfd, !events ? EPOLL_CTL_DEL : *current ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+    *current = events;
+}
+
+// Ligne "PRIVMSG cible :texte\r\n" d'un lot : cible et texte, pour les transports sans IRC
+static int batch_line(const char **p, Span *target, Span *text) {
+    const char *end = strstr(*p, "\r\n");
+    if (!end) return 0;
+    target->p = *p + 8;
+    target->len = strcspn(target->p, " ");
+    text->p = target->p + target->len + 2;
+    text->len = text->p < end ? (size_t)(end - text->p) : 0;
+    *p = end + 2;
+    return 1;
+}
+
+// Thread réseau : lit ce que le descripteur a reçu dans l'anneau (0 : fin de la connexion ou du fichier)
+long recv_ring_fill(RecvRing *ring, int fd) {
+    size_t used = ring->head - ring->tail;
+    size_t offset = ring->head & (IRC_RECV_SIZE - 1);
+    size_t room = IRC_RECV_SIZE - used;
+    if (room > IRC_RECV_SIZE - offset) room = IRC_RECV_SIZE - offset; // Jusqu'à la fin du tableau, la suite au tour suivant
+    long bytes = read(fd, ring->data + offset, room);
+    if (bytes > 0) ring->head += bytes;
+    return bytes;
+}
+
+// Thread réseau : passe au transport toutes les lignes complètes de l'anneau ; une ligne coupée attend la lecture
+// suivante, et un transport à sa limite de commandes garde les autres pour plus tard
+void recv_ring_lines(RecvRing *ring, Network *net, int slot) {
+    static char line[IRC_LINE_MAX + 1];
+    while (ring->scan < ring->head && !network_paused(net)) {
+        size_t offset = ring->scan & (IRC_RECV_SIZE - 1);
+        size_t span = ring->head - ring->scan;
+        if (span > IRC_RECV_SIZE - offset) span = IRC_RECV_SIZE - offset;
+        char *newline = memchr(ring->data + offset, '\n', span);
+        if (!newline) {
+            ring->scan += span;
+            if (ring->scan - ring->tail > IRC_LINE_MAX) { // Ligne trop longue : ignorée jusqu'au prochain \n
+                ring->overlong = 1;
+                ring->tail = ring->scan;
+            }
+            continue;
+        }
+        ring->scan += newline - (ring->data + offset) + 1;
+        size_t len = ring->scan - ring->tail - 1;
+        if (ring->overlong || len > IRC_LINE_MAX) {
+            ring->overlong = 0;
+        } else {
+            size_t start = ring->tail & (IRC_RECV_SIZE - 1);
+            size_t first = len < IRC_RECV_SIZE - start ? len : IRC_RECV_SIZE - start;
+            memcpy(line, ring->data + start, first);
+            memcpy(line + first, ring->data, len - first);
+            if (len > 0 && line[len - 1] == '\r') len--;
+            line[len] = '\0';
+            if (len > 0) net->transport->line(net, slot, line);
+        }
+        ring->tail = ring->scan;
+    }
+}
+
+static void recv_ring_reset(RecvRing *ring) {
+    ring->head = ring->tail = ring->scan = 0;
+    ring->overlong = 0;
+}
+
+// Serveur résolu par getaddrinfo() (nom, IPv4 ou IPv6), à libérer par freeaddrinfo() ; la résolution bloque
+static struct addrinfo *network_resolve(Network *net) {
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM}, *result = NULL;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", net->port);
+    int error = getaddrinfo(net->host, port, &hints, &result);
+    if (error) {
+        printf("Cannot resolve %s: %s\n", net->host, gai_strerror(error));
+        return NULL;
+    }
+    return result;
+}
+
+// Transport IRC. Connexion non bloquante ; NICK et USER attendent dans la voie prioritaire que le socket soit prêt
+static void irc_open_network(int epfd, Network *net) {
+    struct addrinfo *server = network_resolve(net);
+    net->sock = server ? socket(server->ai_family, SOCK_STREAM | SOCK_NONBLOCK, 0) : -1;
+    if (net->sock < 0 || (connect(net->sock, server->ai_addr, server->ai_addrlen) < 0 && errno != EINPROGRESS)) {
+        printf("Connection to %s failed, retrying in %d seconds...\n", net->name, RECONNECT_SECONDS);
+        if (server) freeaddrinfo(server);
+        if (net->sock >= 0) close(net->sock);
+        net->sock = -1;
+        net->retry_us = now_us() + RECONNECT_SECONDS * 1000000LL;
+        return;
+    }
+    freeaddrinfo(server);
+    net->connecting = 1;
+    net->events = 0;
+    recv_ring_reset(&net->ring);
+    network_watch(epfd, net->sock, NETWORK_KEY(net - networks, 0), &net->events, EPOLLIN | EPOLLOUT);
+    char line[128];
+    int len = snprintf(line, sizeof(line), "NICK %s\r\n", net->nick);
+    outbound_push(net, OUTPUT_PRIORITY, line, len);
+    len = snprintf(line, sizeof(line), "USER %s 0 * :Forth IRC Bot\r\n", net->nick);
+    outbound_push(net, OUTPUT_PRIORITY, line, len);
+}
+
+static void irc_drop(int epfd, Network *net) {
+    printf("Disconnected from %s, attempting to reconnect in %d seconds...\n", net->name, RECONNECT_SECONDS);
+    network_watch(epfd, net->sock, 0, &net->events, 0);
+    close(net->sock);
+    net->sock = -1;
+    net->connecting = 0;
+    net->retry_us = now_us() + RECONNECT_SECONDS * 1000000LL;
+    outbound_reset(net);
+}
+
+// Thread réseau : fin de connexion, puis lectures jusqu'à EAGAIN
+static void irc_event(int epfd, Network *net, int slot, unsigned int events) {
+    (void)slot;
+    if (net->sock < 0) return;
+    if (net->connecting) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (!(events & (EPOLLOUT | EPOLLERR | EPOLLHUP))) return;
+        if (getsockopt(net->sock, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
+            irc_drop(epfd, net);
+            return;
+        }
+        net->connecting = 0;
+        printf("Connected to %s (%s:%d)\n", net->name, net->host, net->port);
+    }
+    if (!(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) return;
+    while (1) {
+        long bytes = recv_ring_fill(&net->ring, net->sock);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (bytes <= 0) {
+            irc_drop(epfd, net);
+            return;
+        }
+        recv_ring_lines(&net->ring, net, 0);
+    }
+}
+
+// Un lot part dès son arrivée si le seau le permet, pour garder l'ordre entre commandes ;
+// ceux d'un réseau déconnecté sont jetés
+static void irc_deliver(Network *net, const char *batch) {
+    if (net->sock < 0) return;
+    outbound_take(net, batch);
+    if (!net->connecting) outbound_send(net);
+}
+
+static void irc_flush(int epfd, Network *net) {
+    if (net->sock < 0 && now_us() >= net->retry_us) irc_open_network(epfd, net);
+    if (net->sock < 0) return;
+    if (!net->connecting) outbound_send(net);
+    network_watch(epfd, net->sock, NETWORK_KEY(net - networks, 0), &net->events,
+                  EPOLLIN | (net->connecting || net->out.blocked ? EPOLLOUT : 0));
+}
+
+static int irc_timeout_ms(Network *net) {
+    if (net->sock >= 0) return outbound_timeout_ms(net);
+    long long wait = (net->retry_us - now_us() + 999) / 1000;
+    return wait > 0 ? (int)wait : 0;
+}
+
+// Transport stdio : une commande par ligne de l'entrée standard, session « stdin », réponses en texte brut sur la
+// sortie standard (les messages du bot passent sur la sortie d'erreur). Écritures bloquantes : c'est un outil local.
+static void stdio_open(int epfd, Network *net) {
+    net->sock = STDIN_FILENO;
+    struct epoll_event ev = {.events = EPOLLIN, .data.u64 = NETWORK_KEY(net - networks, 0)};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, net->sock, &ev) < 0) net->polled = 1; // Fichier ordinaire : lu à chaque tour
+    else net->events = EPOLLIN;
+}
+
+static void stdio_event(int epfd, Network *net, int slot, unsigned int events) {
+    (void)epfd;
+    (void)slot;
+    (void)events;
+    if (net->sock < 0 || network_paused(net)) return;
+    long bytes = recv_ring_fill(&net->ring, net->sock); // Une lecture par tour : l'entrée reste bloquante
+    if (bytes < 0 && (errno == EINTR || errno == EAGAIN)) return;
+    if (bytes <= 0) {
+        RecvRing *ring = &net->ring;
+        if (ring->head != ring->tail && ring->head - ring->tail < IRC_RECV_SIZE) { // Dernière ligne sans \n
+            ring->data[ring->head & (IRC_RECV_SIZE - 1)] = '\n';
+            ring->head++;
+        }
+        net->sock = -1;
+    }
+    recv_ring_lines(&net->ring, net, 0);
+}
+
+static void stdio_deliver_text(Network *net, const char *text, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(net->out_fd, text, len);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return;
+        text += written;
+        len -= written;
+    }
+}
+
+static void stdio_line(Network *net, int slot, char *line) {
+    (void)slot;
+    if (!network_submit(net, (Span){"stdin", 5}, (Span){line, strlen(line)}, (Span){"stdout", 6})) {
+        stdio_deliver_text(net, "Busy: command dropped\n", 22);
+    }
+}
+
+static void stdio_deliver(Network *net, const char *batch) {
+    size_t len = 0;
+    char *text = malloc(strlen(batch) + 1);
+    if (!text) return;
+    Span target, line;
+    for (const char *p = batch + 2; batch_line(&p, &target, &line);) {
+        memcpy(text + len, line.p, line.len);
+        len += line.len;
+        text[len++] = '\n';
+    }
+    stdio_deliver_text(net, text, len);
+    free(text);
+}
+
+static void stdio_flush(int epfd, Network *net) {
+    if (net->polled && net->sock >= 0) stdio_event(epfd, net, 0, EPOLLIN);
+    if (!network_paused(net)) recv_ring_lines(&net->ring, net, 0); // Lignes gardées pendant la pause
+    if (net->sock < 0) {
+        if (net->events) network_watch(epfd, STDIN_FILENO, 0, &net->events, 0);
+        net->finished = net->ring.scan == net->ring.head;
+    } else if (!net->polled) {
+        network_watch(epfd, net->sock, NETWORK_KEY(net - networks, 0), &net->events, network_paused(net) ? 0 : EPOLLIN);
+    }
+}
+
+static int stdio_timeout_ms(Network *net) {
+    if (network_paused(net)) return -1;
+    if ((net->polled && net->sock >= 0) || net->ring.scan < net->ring.head) return 0;
+    return -1;
+}
+
+// Transport UNIX : socket en écoute, une commande par ligne, réponses en texte brut au client qui l'a envoyée.
+// Chaque connexion a sa session « unixN » ; un client qui ne lit plus est déconnecté au-delà de CLIENT_OUTPUT_MAX.
+static void unix_open(int epfd, Network *net) {
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%.107s", net->host);
+    net->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    unlink(net->host);
+    if (net->sock < 0 || bind(net->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(net->sock, SOMAXCONN) < 0) {
+        printf("Cannot listen on %s\n", net->host);
+        if (net->sock >= 0) close(net->sock);
+        net->sock = -1;
+        net->finished = 1;
+        return;
+    }
+    printf("Listening on %s\n", net->host);
+    network_watch(epfd, net->sock, NETWORK_KEY(net - networks, 0), &net->events, EPOLLIN);
+}
+
+static void unix_close(int epfd, Network *net, int slot) {
+    Client *c = net->clients[slot - 1];
+    network_watch(epfd, c->fd, 0, &c->events, 0);
+    close(c->fd);
+    free(c->out);
+    free(c);
+    net->clients[slot - 1] = NULL;
+}
+
+static void unix_accept(int epfd, Network *net) {
+    while (1) {
+        int fd = accept(net->sock, NULL, NULL);
+        if (fd < 0) return;
+        int slot = 1;
+        while (slot <= MAX_CLIENTS && net->clients[slot - 1]) slot++;
+        Client *c = slot <= MAX_CLIENTS ? calloc(1, sizeof(Client)) : NULL;
+        if (!c) {
+            close(fd); // Trop de clients
+            continue;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        c->fd = fd;
+        c->id = ++net->client_ids;
+        net->clients[slot - 1] = c;
+        network_watch(epfd, fd, NETWORK_KEY(net - networks, slot), &c->events, EPOLLIN);
+    }
+}
+
+// Écrit la sortie en attente du client ; 0 s'il a été fermé
+static int unix_write(int epfd, Network *net, int slot) {
+    Client *c = net->clients[slot - 1];
+    size_t done = 0;
+    while (done < c->out_len) {
+        ssize_t sent = write(c->fd, c->out + done, c->out_len - done);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (sent <= 0) {
+            unix_close(epfd, net, slot);
+            return 0;
+        }
+        done += sent;
+    }
+    memmove(c->out, c->out + done, c->out_len - done);
+    c->out_len -= done;
+    if (c->out_len > CLIENT_OUTPUT_MAX) {
+        printf("Dropping client %ld on %s: output not read\n", c->id, net->name);
+        unix_close(epfd, net, slot);
+        return 0;
+    }
+    return 1;
+}
+
+static void unix_event(int epfd, Network *net, int slot, unsigned int events) {
+    if (slot == 0) {
+        if (net->sock >= 0) unix_accept(epfd, net);
+        return;
+    }
+    Client *c = slot <= MAX_CLIENTS ? net->clients[slot - 1] : NULL;
+    if (!c) return;
+    if ((events & EPOLLOUT) && !unix_write(epfd, net, slot)) return;
+    if (!(events & (EPOLLIN | EPOLLHUP | EPOLLERR))) return;
+    while (!network_paused(net)) {
+        long bytes = recv_ring_fill(&c->ring, c->fd);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (bytes <= 0) {
+            unix_close(epfd, net, slot);
+            return;
+        }
+        recv_ring_lines(&c->ring, net, slot);
+    }
+}
+
+static void unix_append(Client *c, const char *text, size_t len) {
+    if (c->out_len + len > c->out_cap) {
+        size_t cap = c->out_cap ? c->out_cap * 2 : 4096;
+        while (cap < c->out_len + len) cap *= 2;
+        char *out = realloc(c->out, cap);
+        if (!out) return;
+        c->out = out;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, text, len);
+    c->out_len += len;
+}
+
+static Client *unix_client(Network *net, Span id) {
+    long int wanted = strtol(id.p, NULL, 10);
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (net->clients[i] && net->clients[i]->id == wanted) return net->clients[i];
+    }
+    return NULL;
+}
+
+static void unix_line(Network *net, int slot, char *line) {
+    Client *c = net->clients[slot - 1];
+    char nick[32], id[24];
+    int nick_len = snprintf(nick, sizeof(nick), "unix%ld", c->id);
+    int id_len = snprintf(id, sizeof(id), "%ld", c->id);
+    if (!network_submit(net, (Span){nick, nick_len}, (Span){line, strlen(line)}, (Span){id, id_len})) {
+        unix_append(c, "Busy: command dropped\n", 22);
+    }
+}
+
+static void unix_deliver(Network *net, const char *batch) {
+    Span target, text;
+    for (const char *p = batch + 2; batch_line(&p, &target, &text);) {
+        Client *c = unix_client(net, target); // Client parti : réponse jetée
+        if (!c) continue;
+        unix_append(c, text.p, text.len);
+        unix_append(c, "\n", 1);
+    }
+}
+
+static void unix_flush(int epfd, Network *net) {
+    for (int slot = 1; slot <= MAX_CLIENTS; slot++) {
+        Client *c = net->clients[slot - 1];
+        if (!c || (c->out_len && !unix_write(epfd, net, slot))) continue;
+        if (!network_paused(net)) recv_ring_lines(&c->ring, net, slot); // Lignes gardées pendant la pause
+        network_watch(epfd, c->fd, NETWORK_KEY(net - networks, slot), &c->events,
+                      (network_paused(net) ? 0 : EPOLLIN) | (c->out_len ? EPOLLOUT : 0));
+    }
+}
+
+static int unix_timeout_ms(Network *net) {
+    (void)net;
+    return -1;
+}
+
+static const Transport irc_transport = {"irc", irc_open_network, irc_event, irc_handle_data, irc_deliver, irc_flush, irc_timeout_ms};
+static const Transport stdio_transport = {"stdio", stdio_open, stdio_event, stdio_line, stdio_deliver, stdio_flush, stdio_timeout_ms};
+static const Transport unix_transport = {"unix", unix_open, unix_event, unix_line, unix_deliver, unix_flush, unix_timeout_ms};
+
+// Thread réseau : lots de l'interpréteur vers le transport de leur commande, puis ce que chaque transport peut écrire
+void network_flush_output(int epfd) {
+    char *batch;
+    while ((batch = mpsc_pop(&output_queue))) {
+        int index = batch[1] - '0';
+        if (index >= 0 && index < network_count) networks[index].transport->deliver(&networks[index], batch);
+        free(batch);
+    }
+    for (int i = 0; i < network_count; i++) networks[i].transport->flush(epfd, &networks[i]);
+}
+
+// Thread réseau : délai d'epoll_wait() jusqu'au prochain jeton, à la prochaine reconnexion ou lecture
+static int network_timeout_ms() {
+    int timeout = -1;
+    for (int i = 0; i < network_count; i++) {
+        int t = networks[i].transport->timeout_ms(&networks[i]);
+        if (t >= 0 && (timeout < 0 || t < timeout)) timeout = t;
+    }
+    return timeout;
+}
+
+// Tous les transports ont fini (entrée standard épuisée) et plus rien ne tourne : le mode batch peut s'arrêter
+static int networks_finished() {
+    for (int i = 0; i < network_count; i++) {
+        if (!networks[i].finished) return 0;
+    }
+    pthread_mutex_lock(&scheduler.lock);
+    int idle = scheduler.queued == 0 && scheduler.running == 0 && !active_jobs;
+    pthread_mutex_unlock(&scheduler.lock);
+    return idle;
+}
+
+static Network *network_add(const Transport *transport, const char *name, const char *host, int port) {
+    if (network_count >= MAX_NETWORKS) return NULL;
+    Network *net = &networks[network_count++];
+    net->transport = transport;
+    snprintf(net->name, sizeof(net->name), "%.31s", name); // Nom de serveur de la config tronqué
+    snprintf(net->host, sizeof(net->host), "%s", host);
+    snprintf(net->nick, sizeof(net->nick), "%s", BOT_NAME);
+    net->port = port;
+    net->sock = -1;
+    if (transport != &irc_transport) net->max_commands = LOCAL_MAX_COMMANDS; // Lecture suspendue plutôt que « Busy »
+    if (transport == &stdio_transport) {
+        net->out_fd = dup(STDOUT_FILENO); // Réponses seules sur la sortie standard...
+        dup2(STDERR_FILENO, STDOUT_FILENO); // ... les printf() du bot sur la sortie d'erreur
+        setvbuf(stdout, NULL, _IOLBF, 0);
+    }
+    return net;
+}
+
+// FORTH_CONFIG : fichier de lignes « server NOM HÔTE PORT » (HÔTE : nom ou adresse), puis « nick PSEUDO » et « channel #CANAL »
+// pour ce serveur, « stdio », « unix CHEMIN » et « flood RAFALE INTERVALLE_MS [FILE] » (« flood 0 0 » : sans limite) ;
+// « # » en début de ligne commente.
+// Sans fichier : FORTH_TRANSPORT=stdio ou unix:CHEMIN, sinon CHANNEL sur SERVER_HOST.
+void init_networks() {
+    char *path = getenv("FORTH_CONFIG");
+    FILE *file = path ? fopen(path, "r") : NULL;
+    if (path && !file) printf("Cannot open config file %s, using defaults\n", path);
+    char line[256];
+    int line_number = 0;
+    Network *net = NULL;
+    while (file && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char key[16], a[128], b[128];
+        int port, burst, flood_fields = 0;
+        unsigned long interval;
+        long backlog = 0;
+        if (strncmp(line, "flood", 5) == 0) flood_fields = sscanf(line, "%*s %d %lu %ld", &burst, &interval, &backlog);
+        int fields = sscanf(line, "%15s %127s %127s %d", key, a, b, &port);
+        if (fields <= 0 || key[0] == '#') continue; // Ligne vide ou commentaire
+        if (strcmp(key, "server") == 0 && fields == 4 && port > 0 && port < 65536) {
+            net = network_add(&irc_transport, a, b, port);
+            if (!net) printf("Config line %d: too many servers (%d max)\n", line_number, MAX_NETWORKS);
+        } else if ((strcmp(key, "stdio") == 0 && fields == 1) || (strcmp(key, "unix") == 0 && fields == 2)) {
+            net = NULL; // Pas de nick ni de canal pour un transport local
+            if (!network_add(key[0] == 's' ? &stdio_transport : &unix_transport, key, fields == 2 ? a : "", 0)) {
+                printf("Config line %d: too many servers (%d max)\n", line_number, MAX_NETWORKS);
+            }
+        } else if (strcmp(key, "nick") == 0 && fields >= 2 && net) {
+            snprintf(net->nick, sizeof(net->nick), "%.31s", a);
+        } else if (strcmp(key, "channel") == 0 && fields >= 2 && net && net->channel_count < MAX_CHANNELS) {
+            snprintf(net->channels[net->channel_count++], sizeof(net->channels[0]), "%.63s", a);
+        } else if (strcmp(key, "flood") == 0 && flood_fields >= 2 && burst <= 0 && interval > 0) {
+            printf("Config line %d: flood burst must be positive unless the interval is 0 (no limit)\n", line_number);
+        } else if (strcmp(key, "flood") == 0 && flood_fields >= 2 && burst >= 0) {
+            flood.burst = burst;
+            flood.interval_ms = interval;
+            if (flood_fields == 3 && backlog > 0) flood.backlog = backlog;
+        } else {
+            printf("Ignoring config line %d: %s", line_number, line);
+        }
+    }
+    if (file) fclose(file);
+    char *transport = getenv("FORTH_TRANSPORT");
+    if (network_count == 0 && transport && strcmp(transport, "stdio") == 0) {
+        network_add(&stdio_transport, "stdio", "", 0);
+    } else if (network_count == 0 && transport && strncmp(transport, "unix:", 5) == 0) {
+        network_add(&unix_transport, "unix", transport + 5, 0);
+    } else if (network_count == 0) {
+        net = network_add(&irc_transport, "labynet", SERVER_HOST, SERVER_PORT);
+        snprintf(net->channels[net->channel_count++], sizeof(net->channels[0]), "%s", CHANNEL);
+    }
+}
+
+// FORTH_SESSION_MEMORY : mémoire totale des sessions avant éviction (octets) ; FORTH_MEMO_BYTES : cache MEMO par session
+void init_sessions() {
+    char *env = getenv("FORTH_SESSION_MEMORY");
+    if (env) session_memory_cap = strtoul(env, NULL, 10);
+    env = getenv("FORTH_MEMO_BYTES");
+    if (env) memo_max_bytes = strtoul(env, NULL, 10);
+}
+
+void memory_copy(Memory *dst, const Memory *src) {
+    *dst = *src;
+    dst->name = src->name ? strdup(src->name) : NULL;
+    if (src->values && src->size > 0) {
+        dst->values = malloc(src->size * sizeof(mpz_t));
+        for (long int j = 0; dst->values && j < src->size; j++) {
+            mpz_init_set(dst->values[j], src->values[j]);
+        }
+    }
+    if (src->string) dst->string = strdup(src->string);
+    if (src->cells && src->size > 0) {
+        dst->cells = malloc(src->size * sizeof(int64_t));
+        if (dst->cells) memcpy(dst->cells, src->cells, src->size * sizeof(int64_t));
+    }
+}
+
+void word_copy(CompiledWord *dst, const CompiledWord *src) {
+    memcpy(dst, src, sizeof(CompiledWord));
+    dst->name = src->name ? strdup(src->name) : NULL;
+    for (long int i = 0; i < src->string_count; i++) {
+        dst->strings[i] = src->strings[i] ? strdup(src->strings[i]) : NULL;
+    }
+}
+
+// Nouvelle session issue de src : pile et variables copiées ; les mots propres à src
+// sont dupliqués si copy_words, ceux qu'elle partage avec l'image de base le restent
+static Session *session_from(Session *src, const char *nick, int copy_words) {
+    Session *s = calloc(1, sizeof(Session));
+    if (!s) return NULL;
+    snprintf(s->nick, sizeof(s->nick), "%s", nick);
+    Session *saved = session;
+    session = s;
+    initStack(&s->stack);
+    init_mpz_pool();
+    s->string_stack_top = -1;
+    s->loop_stack_top = -1;
+    s->current_word_index = -1;
+    s->last_word_index = -1;
+    s->dict_version = atomic_fetch_add_explicit(&dict_versions, 1, memory_order_relaxed);
+    for (long int i = 0; i <= src->stack.top; i++) {
+        mpz_set(s->stack.data[i], src->stack.data[i]);
+    }
+    s->stack.top = src->stack.top;
+    for (long int i = 0; i < src->dict_count; i++) {
+        if (copy_words && src->dict_owned[i] && src->dictionary[i]) {
+            CompiledWord *word = word_for_write(i);
+            if (word) word_copy(word, src->dictionary[i]);
+        } else {
+            s->dictionary[i] = src->dictionary[i];
+        }
+    }
+    s->dict_count = src->dict_count;
+    for (long int i = 0; i < src->memory_count; i++) {
+        memory_copy(&s->memory[i], &src->memory[i]);
+    }
+    s->memory_count = src->memory_count;
+    for (int i = 0; copy_words && i < MAX_GENERATORS; i++) {
+        if (src->generators[i]) s->generators[i] = generator_copy(src->generators[i]);
+    }
+    s->generator_ids = src->generator_ids;
+    s->generator_clock = src->generator_clock;
+    s->base_index = src->base_index;
+    s->bytes = session_bytes(s);
+    session = saved;
+    return s;
+}
+
+// Nouvelle session : mots de l'image de base partagés, variables de base copiées
+Session *session_create(const char *nick) {
+    return session_from(&base_session, nick, 0);
+}
+
+// Copie indépendante d'une session, pour un job
+Session *session_clone(Session *src) {
+    return session_from(src, src->nick, 1);
+}
+
+void session_destroy(Session *s) {
+    Session *saved = session;
+    session = s;
+    if (s->compiling) {
+        free(s->currentWord.name);
+        for (int i = 0; i < s->currentWord.string_count; i++) {
+            if (s->currentWord.strings[i]) free(s->currentWord.strings[i]);
+        }
+    }
+    while (s->loop_stack_top >= 0) {
+        mpz_clear(s->loop_stack[s->loop_stack_top].index);
+        mpz_clear(s->loop_stack[s->loop_stack_top].limit);
+        s->loop_stack_top--;
+    }
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        if (s->generators[i]) generator_free(s->generators[i]);
+    }
+    clearStack(&s->stack);
+    clear_mpz_pool();
+    free(s->txn.memory_log);
+    memo_reset(&s->memo);
+    free(s->memo.buckets);
+#ifdef FORTH_PROFILE
+    free(s->profile);
+#endif
+    session = saved;
+    free(s);
+}
+
+// Trouve ou crée la session du pseudo et la place en tête de la liste LRU (verrou de l'ordonnanceur tenu)
+Session *session_for_nick(const char *nick) {
+    Session *s = sessions;
+    while (s && strcmp(s->nick, nick) != 0) s = s->next;
+    if (!s) {
+        s = session_create(nick);
+        if (!s) return NULL;
+        session_count++;
+    } else {
+        if (s->prev) s->prev->next = s->next;
+        else sessions = s->next;
+        if (s->next) s->next->prev = s->prev;
+    }
+    s->prev = NULL;
+    s->next = sessions;
+    if (sessions) sessions->prev = s;
+    sessions = s;
+    return s;
+}
+
+// Estimation de la mémoire retenue par une session
+size_t session_bytes(Session *s) {
+    size_t bytes = sizeof(Session) + s->memo.bytes;
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        Generator *g = s->generators[i];
+        if (!g) continue;
+        bytes += sizeof(Generator) + sizeof(Stack) + g->loop_count * sizeof(LoopControl);
+        for (long int j = 0; j <= g->stack->top; j++) bytes += mpz_size(g->stack->data[j]) * sizeof(mp_limb_t);
+    }
+    for (long int i = 0; i < s->dict_count; i++) {
+        if (s->dict_owned[i]) bytes += sizeof(CompiledWord);
+    }
+    for (long int i = 0; i <= s->stack.top; i++) {
+        bytes += mpz_size(s->stack.data[i]) * sizeof(mp_limb_t);
+    }
+    for (long int i = 0; i < s->memory_count; i++) {
+        Memory *m = &s->memory[i];
+        if (m->values) {
+            for (long int j = 0; j < m->size; j++) {
+                bytes += sizeof(mpz_t) + mpz_size(m->values[j]) * sizeof(mp_limb_t);
+            }
+        }
+        if (m->cells) bytes += m->size * sizeof(int64_t);
+        if (m->string) bytes += strlen(m->string) + 1;
+    }
+    return bytes;
+}
+
+// Évince les sessions inactives les moins récemment utilisées au-delà du plafond
+// (verrou de l'ordonnanceur tenu ; une session en cours ou avec des commandes en attente est gardée)
+void session_evict() {
+    size_t total = 0;
+    Session *tail = NULL;
+    for (Session *s = sessions; s; s = s->next) {
+        total += s->bytes;
+        tail = s;
+    }
+    while (total > session_memory_cap && tail) {
+        Session *victim = tail;
+        tail = tail->prev;
+        if (victim->running || victim->queue_head) continue;
+        total -= victim->bytes;
+        if (victim->prev) victim->prev->next = victim->next;
+        else sessions = victim->next;
+        if (victim->next) victim->next->prev = victim->prev;
+        session_destroy(victim);
+        session_count--;
+    }
+}
+
+// FORTH_RESULT_CACHE_BYTES : taille du cache de réponses (0 le désactive)
+void init_result_cache() {
+    char *env = getenv("FORTH_RESULT_CACHE_BYTES");
+    if (env) result_cache.max_bytes = strtoul(env, NULL, 10);
+}
+
+// Le dictionnaire de la session a changé : ses réponses en cache ne sont plus accessibles
+void dict_changed() {
+    session->dict_version = atomic_fetch_add_explicit(&dict_versions, 1, memory_order_relaxed);
+}
+
+// Nombres, mots du dictionnaire, primitives pures et `."` seulement.
+// *shared : la commande ne dépend que de l'image de base, sa réponse vaut pour toutes les sessions.
+static int result_cache_candidate(char *text, int *shared) {
+    static const char *allowed[] = {
+        "+", "-", "*", "/", "MOD", "DUP", "SWAP", "OVER", "ROT", "DROP", "NIP", "=", "<", ">",
+        "AND", "OR", "NOT", "&", "|", "^", "~", "LSHIFT", "RSHIFT", ".", "CR"
+    };
+    *shared = 1;
+    for (long int i = 0; i < base_session.dict_count; i++) {
+        if (session->dict_owned[i]) *shared = 0; // Un mot de base redéfini change les mots qui l'appellent
+    }
+    char *saveptr;
+    int ok = 1;
+    mpz_t number;
+    mpz_init(number);
+    for (char *token = strtok_r(text, " \t\n", &saveptr); token && ok; token = strtok_r(NULL, " \t\n", &saveptr)) {
+        if (strcmp(token, ".\"") == 0) {
+            char *end = strchr(saveptr, '"');
+            if (!end) ok = 0;
+            else saveptr = end + 1;
+            continue;
+        }
+        int index = findCompiledWordIndex(token);
+        if (index >= 0) {
+            if (session->dict_owned[index]) *shared = 0;
+            continue;
+        }
+        ok = 0;
+        for (size_t i = 0; i < sizeof(allowed) / sizeof(allowed[0]) && !ok; i++) ok = strcmp(token, allowed[i]) == 0;
+        if (!ok) ok = parse_number(number, token) == 0;
+    }
+    mpz_clear(number);
+    return ok;
+}
+
+static uint64_t result_cache_hash(const char *key) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (; *key; key++) hash = (hash ^ (unsigned char)*key) * 1099511628211ULL;
+    return hash;
+}
+
+static void result_cache_unlink(CachedResult *e) {
+    if (e->prev) e->prev->next = e->next;
+    else result_cache.head = e->next;
+    if (e->next) e->next->prev = e->prev;
+    else result_cache.tail = e->prev;
+}
+
+static void result_cache_push_front(CachedResult *e) {
+    e->prev = NULL;
+    e->next = result_cache.head;
+    if (result_cache.head) result_cache.head->prev = e;
+    else result_cache.tail = e;
+    result_cache.head = e;
+}
+
+// Verrou tenu
+static void result_cache_evict(CachedResult *e) {
+    CachedResult **link = &result_cache.buckets[e->hash % RESULT_CACHE_BUCKETS];
+    while (*link != e) link = &(*link)->chain;
+    *link = e->chain;
+    result_cache_unlink(e);
+    for (int i = 0; i < e->pushed_count; i++) mpz_clear(e->pushed[i]);
+    free(e->pushed);
+    free(e->output);
+    free(e->key);
+    result_cache.bytes -= e->bytes;
+    result_cache.entries--;
+    free(e);
+}
+
+// Avant l'exécution : rejoue la réponse si elle est en cache (renvoie 1). Sinon, pour une commande
+// candidate, démarre l'enregistrement et renvoie sa clé dans *key, à passer à result_cache_store.
+int result_cache_replay(Session *s, const char *command, char **key) {
+    *key = NULL;
+    if (!result_cache.max_bytes || s->emit_buffer_pos > 0) return 0; // CR viderait le tampon d'EMIT
+    char text[512], scan[512];
+    size_t len = 0;
+    int quoted = strchr(command, '"') != NULL;
+    for (const char *p = command; *p && len < sizeof(text) - 1; p++) {
+        int space = *p == ' ' || *p == '\t' || *p == '\n' || *p == '\r';
+        if (space && !quoted && (len == 0 || text[len - 1] == ' ')) continue; // Espaces regroupés hors chaînes
+        text[len++] = space && !quoted ? ' ' : *p;
+    }
+    while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t')) len--;
+    text[len] = '\0';
+    int shared;
+    memcpy(scan, text, len + 1);
+    if (len == 0 || !result_cache_candidate(scan, &shared)) return 0;
+    char owner[96] = "*";
+    if (!shared) snprintf(owner, sizeof(owner), "%s:%lu", s->nick, s->dict_version);
+    size_t key_len = len + strlen(owner) + 32;
+    char *k = malloc(key_len);
+    if (!k) return 0;
+    snprintf(k, key_len, "%s\x1f%d\x1f%s", text, current_base(), owner);
+    uint64_t hash = result_cache_hash(k);
+
+    char *output = NULL;
+    int hit = 0;
+    pthread_mutex_lock(&result_cache.lock);
+    result_cache.lookups++;
+    for (CachedResult *e = result_cache.buckets[hash % RESULT_CACHE_BUCKETS]; e; e = e->chain) {
+        if (e->hash != hash || strcmp(e->key, k) != 0) continue;
+        if (s->stack.top + e->pushed_count >= STACK_SIZE) break; // Débordement : l'exécution le signalera
+        for (int i = 0; i < e->pushed_count; i++) push(&s->stack, e->pushed[i]);
+        output = strdup(e->output);
+        result_cache_unlink(e);
+        result_cache_push_front(e);
+        result_cache.hits++;
+        hit = 1;
+        break;
+    }
+    pthread_mutex_unlock(&result_cache.lock);
+    if (hit) {
+        free(k);
+        s->error_flag = 0;
+        for (char *line = output, *end; line && (end = strchr(line, '\n')); line = end + 1) {
+            *end = '\0';
+            send_to_channel(line);
+        }
+        free(output);
+        return 1;
+    }
+    s->cache_rec = 1;
+    s->cache_top = s->stack.top;
+    s->memo_low = s->stack.top;
+    s->cache_out_len = 0;
+    *key = k;
+    return 0;
+}
+
+// Appelé par send_to_channel pendant l'enregistrement
+void result_cache_record(const char *msg) {
+    size_t len = strlen(msg);
+    if (session->cache_out_len + len + 1 >= sizeof(session->cache_out)) {
+        session->cache_rec = 0; // Réponse trop longue pour le cache
+        return;
+    }
+    memcpy(session->cache_out + session->cache_out_len, msg, len);
+    session->cache_out[session->cache_out_len + len] = '\n';
+    session->cache_out_len += len + 1;
+}
+
+// Après l'exécution : garde la réponse si la commande est restée déterministe ; libère key
+void result_cache_store(Session *s, char *key) {
+    int ok = s->cache_rec && !s->error_flag && s->memo_low >= s->cache_top;
+    s->cache_rec = 0;
+    int pushed_count = ok ? s->stack.top - s->cache_top : 0;
+    size_t bytes = sizeof(CachedResult) + strlen(key) + 1 + s->cache_out_len + 1 + pushed_count * sizeof(mpz_t);
+    for (long int i = s->cache_top + 1; ok && i <= s->stack.top; i++) bytes += mpz_size(s->stack.data[i]) * sizeof(mp_limb_t);
+    CachedResult *e = ok && bytes <= result_cache.max_bytes ? calloc(1, sizeof(CachedResult)) : NULL;
+    if (e) {
+        e->output = malloc(s->cache_out_len + 1);
+        e->pushed = malloc((pushed_count ? pushed_count : 1) * sizeof(mpz_t));
+    }
+    if (!e || !e->output || !e->pushed) {
+        if (e) {
+            free(e->output);
+            free(e->pushed);
+            free(e);
+        }
+        pthread_mutex_lock(&result_cache.lock);
+        result_cache.uncacheable++;
+        pthread_mutex_unlock(&result_cache.lock);
+        free(key);
+        return;
+    }
+    memcpy(e->output, s->cache_out, s->cache_out_len);
+    e->output[s->cache_out_len] = '\0';
+    for (int i = 0; i < pushed_count; i++) mpz_init_set(e->pushed[i], s->stack.data[s->cache_top + 1 + i]);
+    e->pushed_count = pushed_count;
+    e->key = key;
+    e->hash = result_cache_hash(key);
+    e->bytes = bytes;
+
+    pthread_mutex_lock(&result_cache.lock);
+    CachedResult *old = result_cache.buckets[e->hash % RESULT_CACHE_BUCKETS];
+    while (old && (old->hash != e->hash || strcmp(old->key, key) != 0)) old = old->chain;
+    if (old) result_cache_evict(old); // Même commande exécutée deux fois en parallèle
+    while (result_cache.tail && result_cache.bytes + bytes > result_cache.max_bytes) result_cache_evict(result_cache.tail);
+    e->chain = result_cache.buckets[e->hash % RESULT_CACHE_BUCKETS];
+    result_cache.buckets[e->hash % RESULT_CACHE_BUCKETS] = e;
+    result_cache_push_front(e);
+    result_cache.bytes += bytes;
+    result_cache.entries++;
+    result_cache.stores++;
+    pthread_mutex_unlock(&result_cache.lock);
+}
+
+// FORTH_SANDBOX=1 : une commande par enfant fork() ; FORTH_SANDBOX_MEMORY : marge d'espace d'adressage (octets)
+void init_sandbox() {
+    char *env = getenv("FORTH_SANDBOX");
+    if (env) sandbox.enabled = atoi(env) != 0;
+    env = getenv("FORTH_SANDBOX_MEMORY");
+    if (env) sandbox.max_memory = strtoul(env, NULL, 10);
+}
+
+static void put_long(FILE *f, long value) {
+    fwrite(&value, sizeof(value), 1, f);
+}
+
+static long get_long(FILE *f) {
+    long value = 0;
+    if (fread(&value, sizeof(value), 1, f) != 1) return -1;
+    return value;
+}
+
+static void put_str(FILE *f, const char *str) {
+    long len = str ? (long)strlen(str) : -1;
+    put_long(f, len);
+    if (len > 0) fwrite(str, 1, len, f);
+}
+
+static char *get_str(FILE *f) {
+    long len = get_long(f);
+    if (len < 0) return NULL;
+    char *str = malloc(len + 1);
+    if (!str) return NULL;
+    if (fread(str, 1, len, f) != (size_t)len) len = 0;
+    str[len] = '\0';
+    return str;
+}
+
+static void put_word(FILE *f, const CompiledWord *word) {
+    put_str(f, word->name);
+    put_long(f, word->code_length);
+    fwrite(word->code, sizeof(Instruction), word->code_length, f);
+    put_long(f, word->string_count);
+    for (long int i = 0; i < word->string_count; i++) put_str(f, word->strings[i]);
+    put_long(f, word->memo);
+    put_long(f, word->generator);
+    put_long(f, word->generator_args);
+}
+
+static int get_word(FILE *f, CompiledWord *word) {
+    word->name = get_str(f);
+    word->code_length = get_long(f);
+    if (word->code_length < 0 || word->code_length > WORD_CODE_SIZE) return 0;
+    if (fread(word->code, sizeof(Instruction), word->code_length, f) != (size_t)word->code_length) return 0;
+    word->string_count = get_long(f);
+    if (word->string_count < 0 || word->string_count > WORD_CODE_SIZE) return 0;
+    for (long int i = 0; i < word->string_count; i++) word->strings[i] = get_str(f);
+    word->memo = get_long(f);
+    word->generator = get_long(f);
+    word->generator_args = get_long(f);
+    return 1;
+}
+
+// État qu'une commande peut modifier : piles, mémoire, mots propres à la session, compilation en cours
+static void session_save(FILE *f, Session *s) {
+    put_long(f, s->stack.top);
+    for (long int i = 0; i <= s->stack.top; i++) mpz_out_raw(f, s->stack.data[i]);
+    put_long(f, s->string_stack_top);
+    for (int i = 0; i <= s->string_stack_top; i++) put_str(f, s->string_stack[i]);
+    put_long(f, s->memory_count);
+    for (long int i = 0; i < s->memory_count; i++) {
+        Memory *m = &s->memory[i];
+        put_str(f, m->name);
+        put_long(f, m->type);
+        put_long(f, m->size);
+        if (m->type == MEMORY_VARIABLE || m->type == MEMORY_ARRAY) {
+            put_long(f, m->values != NULL);
+            for (long int j = 0; m->values && j < m->size; j++) mpz_out_raw(f, m->values[j]);
+        } else if (m->type == MEMORY_STRING) {
+            put_str(f, m->string);
+        } else if (m->type == MEMORY_CELLS) {
+            fwrite(m->cells, sizeof(int64_t), m->size, f);
+        }
+    }
+    put_long(f, s->dict_count);
+    for (long int i = 0; i < s->dict_count; i++) {
+        int owned = s->dict_owned[i] && s->dictionary[i];
+        put_long(f, owned ? 1 : s->dictionary[i] ? 0 : -1);
+        if (owned) put_word(f, s->dictionary[i]);
+    }
+    put_long(f, s->compiling);
+    if (s->compiling) {
+        put_word(f, &s->currentWord);
+        put_long(f, s->current_word_index);
+        put_long(f, s->control_stack_top);
+        fwrite(s->control_stack, sizeof(ControlEntry), s->control_stack_top + 1, f);
+    }
+    put_long(f, s->generator_ids);
+    put_long(f, s->generator_clock);
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        Generator *g = s->generators[i];
+        put_long(f, g != NULL);
+        if (!g) continue;
+        put_long(f, g->id);
+        put_long(f, g->ip);
+        put_long(f, g->last_used);
+        put_word(f, &g->word);
+        put_long(f, g->stack->top);
+        for (long int j = 0; j <= g->stack->top; j++) mpz_out_raw(f, g->stack->data[j]);
+        put_long(f, g->loop_count);
+        for (long int j = 0; j < g->loop_count; j++) {
+            mpz_out_raw(f, g->loops[j].index);
+            mpz_out_raw(f, g->loops[j].limit);
+            put_long(f, g->loops[j].addr);
+        }
+    }
+    put_long(f, s->base_index);
+    put_long(f, s->error_flag);
+    put_long(f, s->dict_version);
+    put_long(f, s->cache_rec);
+    put_long(f, s->memo_low);
+    put_long(f, gmp_heap.cmd_allocs); // Pour MEMSTATS : la commande a alloué dans l'enfant
+    put_long(f, gmp_heap.cmd_bytes);
+    put_long(f, gmp_heap.cmd_peak_bytes);
+    put_long(f, SESSION_END);
+}
+
+// Lit dans la session courante s, neuve, l'état écrit par session_save ;
+// trailer reçoit la version du dictionnaire de l'enfant et les compteurs MEMSTATS
+static int session_read(FILE *f, Session *s, long trailer[4]) {
+    long top = get_long(f);
+    if (top < -1 || top >= STACK_SIZE) return 0;
+    for (long int i = 0; i <= top; i++) {
+        if (!mpz_inp_raw(s->stack.data[i], f)) return 0;
+    }
+    s->stack.top = top;
+    top = get_long(f);
+    if (top < -1 || top >= STACK_SIZE) return 0;
+    for (long int i = 0; i <= top; i++) s->string_stack[i] = get_str(f);
+    s->string_stack_top = top;
+
+    for (long int i = 0; i < s->memory_count; i++) memory_free(&s->memory[i]);
+    s->memory_count = 0;
+    long count = get_long(f);
+    if (count < 0 || count > VAR_SIZE) return 0;
+    for (long int i = 0; i < count; i++) {
+        Memory *m = &s->memory[i];
+        m->name = get_str(f);
+        m->type = get_long(f);
+        m->size = get_long(f);
+        s->memory_count = i + 1;
+        if (m->size < 0) return 0;
+        if (m->type == MEMORY_VARIABLE || m->type == MEMORY_ARRAY) {
+            if (get_long(f) == 1) {
+                m->values = malloc(m->size * sizeof(mpz_t));
+                if (!m->values) return 0;
+                for (long int j = 0; j < m->size; j++) mpz_init(m->values[j]);
+                for (long int j = 0; j < m->size; j++) {
+                    if (!mpz_inp_raw(m->values[j], f)) return 0;
+                }
+            }
+        } else if (m->type == MEMORY_STRING) {
+            m->string = get_str(f);
+        } else if (m->type == MEMORY_CELLS) {
+            m->cells = malloc(m->size * sizeof(int64_t));
+            if (!m->cells || fread(m->cells, sizeof(int64_t), m->size, f) != (size_t)m->size) return 0;
+        }
+    }
+
+    for (long int i = 0; i < s->dict_count; i++) forget_word(i);
+    s->dict_count = 0;
+    count = get_long(f);
+    if (count < 0 || count > DICT_SIZE) return 0;
+    for (long int i = 0; i < count; i++) {
+        long kind = get_long(f);
+        s->dict_count = i + 1;
+        if (kind == 1) {
+            CompiledWord *word = word_for_write(i);
+            if (!word || !get_word(f, word)) return 0;
+        } else if (kind == 0) {
+            s->dictionary[i] = base_session.dictionary[i]; // Seuls les mots de base sont partagés
+        }
+    }
+
+    if (s->compiling) {
+        free(s->currentWord.name);
+        for (int i = 0; i < s->currentWord.string_count; i++) {
+            if (s->currentWord.strings[i]) free(s->currentWord.strings[i]);
+        }
+    }
+    s->compiling = get_long(f);
+    if (s->compiling) {
+        if (!get_word(f, &s->currentWord)) return 0;
+        s->current_word_index = get_long(f);
+        s->control_stack_top = get_long(f);
+        if (s->control_stack_top < -1 || s->control_stack_top >= CONTROL_STACK_SIZE) return 0;
+        if (fread(s->control_stack, sizeof(ControlEntry), s->control_stack_top + 1, f) != (size_t)(s->control_stack_top + 1)) return 0;
+    }
+    s->generator_ids = get_long(f);
+    s->generator_clock = get_long(f);
+    for (int i = 0; i < MAX_GENERATORS; i++) {
+        if (s->generators[i]) generator_free(s->generators[i]);
+        s->generators[i] = NULL;
+        if (get_long(f) != 1) continue;
+        long id = get_long(f), ip = get_long(f), last_used = get_long(f);
+        CompiledWord word = {0};
+        Generator *loaded = get_word(f, &word) ? generator_new(&word) : NULL;
+        if (word.name) free(word.name);
+        for (long int j = 0; j < word.string_count; j++) free(word.strings[j]);
+        if (!loaded) return 0;
+        loaded->id = id;
+        loaded->ip = ip;
+        loaded->last_used = last_used;
+        s->generators[i] = loaded;
+        top = get_long(f);
+        if (top < -1 || top >= STACK_SIZE) return 0;
+        for (long int j = 0; j <= top; j++) {
+            if (!mpz_inp_raw(loaded->stack->data[j], f)) return 0;
+        }
+        loaded->stack->top = top;
+        count = get_long(f);
+        if (count < 0 || count > LOOP_STACK_SIZE) return 0;
+        loaded->loops = count ? malloc(count * sizeof(LoopControl)) : NULL;
+        if (count && !loaded->loops) return 0;
+        for (long int j = 0; j < count; j++) {
+            mpz_init(loaded->loops[j].index);
+            mpz_init(loaded->loops[j].limit);
+            loaded->loop_count = j + 1;
+            if (!mpz_inp_raw(loaded->loops[j].index, f) || !mpz_inp_raw(loaded->loops[j].limit, f)) return 0;
+            loaded->loops[j].addr = get_long(f);
+        }
+    }
+    s->base_index = get_long(f);
+    s->error_flag = get_long(f);
+    trailer[0] = get_long(f);
+    s->cache_rec = get_long(f);
+    s->memo_low = get_long(f);
+    for (int i = 1; i < 4; i++) trailer[i] = get_long(f);
+    return get_long(f) == SESSION_END && !ferror(f);
+}
+
+static void swap_bytes(void *a, void *b, size_t size) {
+    unsigned char *x = a, *y = b;
+    for (size_t i = 0; i < size; i++) {
+        unsigned char c = x[i];
+        x[i] = y[i];
+        y[i] = c;
+    }
+}
+
+#define SWAP_FIELD(a, b, field) swap_bytes(&(a)->field, &(b)->field, sizeof((a)->field))
+
+// Remplace l'état de s par celui écrit par session_save, lu d'abord dans une session temporaire :
+// un flux tronqué ou invalide laisse s intacte
+static int session_load(FILE *f, Session *s) {
+    Session *loaded = session_create(s->nick);
+    if (!loaded) return 0;
+    Session *saved = session;
+    long trailer[4];
+    session = loaded;
+    int ok = session_read(f, loaded, trailer);
+    session = saved;
+    if (ok) {
+        SWAP_FIELD(s, loaded, stack);
+        SWAP_FIELD(s, loaded, string_stack);
+        SWAP_FIELD(s, loaded, string_stack_top);
+        SWAP_FIELD(s, loaded, memory);
+        SWAP_FIELD(s, loaded, memory_count);
+        SWAP_FIELD(s, loaded, dictionary);
+        SWAP_FIELD(s, loaded, dict_owned);
+        SWAP_FIELD(s, loaded, dict_count);
+        SWAP_FIELD(s, loaded, compiling);
+        SWAP_FIELD(s, loaded, currentWord);
+        SWAP_FIELD(s, loaded, current_word_index);
+        SWAP_FIELD(s, loaded, control_stack);
+        SWAP_FIELD(s, loaded, control_stack_top);
+        SWAP_FIELD(s, loaded, generators);
+        SWAP_FIELD(s, loaded, generator_ids);
+        SWAP_FIELD(s, loaded, generator_clock);
+        SWAP_FIELD(s, loaded, base_index);
+        SWAP_FIELD(s, loaded, error_flag);
+        SWAP_FIELD(s, loaded, cache_rec);
+        SWAP_FIELD(s, loaded, memo_low);
+        if ((unsigned long)trailer[0] != s->dict_version) { // Tampon tiré dans l'enfant : pas unique côté parent
+            s->dict_version = loaded->dict_version;         // Neuf, tiré par session_create
+        }
+        gmp_heap.cmd_allocs = trailer[1];
+        gmp_heap.cmd_bytes = trailer[2];
+        gmp_heap.cmd_peak_bytes = trailer[3];
+    }
+    for (int i = 0; !ok && i <= loaded->string_stack_top; i++) free(loaded->string_stack[i]);
+    session_destroy(loaded); // Ancien état si la lecture a réussi, état partiel sinon
+    return ok;
+}
+
+// Enregistrement de l'enfant vers le parent : type, longueur sur 4 octets, données
+void sandbox_send(char type, const void *data, size_t len) {
+    unsigned char header[5] = {type, len & 0xff, (len >> 8) & 0xff, (len >> 16) & 0xff, (len >> 24) & 0xff};
+    const unsigned char *parts[2] = {header, data};
+    size_t sizes[2] = {sizeof(header), len};
+    for (int p = 0; p < 2; p++) {
+        size_t done = 0;
+        while (done < sizes[p]) {
+            ssize_t n = write(sandbox_fd, parts[p] + done, sizes[p] - done);
+            if (n < 0) _exit(1); // Parent disparu
+            done += n;
+        }
+    }
+}
+
+// Enfant : les mots qui lisent l'état du processus (jobs, files, caches, statistiques) s'exécutent
+// dans le parent, qui seul le connaît ; renvoie 1 si instr a été délégué
+int sandbox_delegate(Instruction instr, Stack *stack) {
+    char request[64];
+    switch (instr.opcode) {
+        case OP_MEMSTATS: case OP_QUEUESTATS: case OP_CACHESTATS: case OP_STATS: case OP_PROFILE_DUMP: case OP_JOBS:
+            snprintf(request, sizeof(request), "%d", (int)instr.opcode);
+            break;
+        case OP_KILL: case OP_RESULT: {
+            mpz_t *a = &session->mpz_pool[0];
+            pop(stack, *a);
+            if (session->error_flag) return 1;
+            if (mpz_sizeinbase(*a, 10) > 40) mpz_set_si(*a, -1); // Identifiant invalide de toute façon
+            gmp_snprintf(request, sizeof(request), "%d %Zd", (int)instr.opcode, *a);
+            break;
+        }
+        default:
+            return 0;
+    }
+    sandbox_send('R', request, strlen(request));
+    char failed;
+    if (read(sandbox_fd, &failed, 1) != 1) _exit(1); // Parent disparu
+    if (failed) session->error_flag = 1; // Message déjà envoyé par le parent
+    return 1;
+}
+
+// Enfant du processus auxiliaire, mono-thread comme lui : lit la demande (job, budget, quota,
+// commande, état de la session) sur fd, exécute la commande et renvoie sortie et état final
+static void sandbox_child(int fd) {
+    sandbox_fd = fd;
+    pid_t pid = getpid();
+    sandbox_send('P', &pid, sizeof(pid)); // Pour que le parent puisse le tuer
+    FILE *f = fdopen(dup(fd), "r");
+    if (!f) _exit(1);
+    static Job job; // Pour les contrôles de budget ; JOBS, KILL, RESULT sont délégués au parent
+    static Quota quota;
+    long is_job = get_long(f);
+    char *command = NULL;
+    if (fread(&vm_budget, sizeof(vm_budget), 1, f) != 1 || fread(&quota, sizeof(quota), 1, f) != 1 ||
+        !(command = get_str(f))) {
+        _exit(1);
+    }
+    active_quota = &quota;
+    Session *s = session_create(quota.nick);
+    if (!s) _exit(1);
+    session = s;
+    if (!session_load(f, s)) _exit(1);
+    fclose(f);
+    if (is_job) s->job = &job;
+    gmp_heap_begin_command();
+    struct rlimit limit;
+    if (vm_budget.max_milliseconds) {
+        limit.rlim_cur = (vm_budget.max_milliseconds + SANDBOX_GRACE_MILLISECONDS) / 1000 + 1;
+        limit.rlim_max = limit.rlim_cur + 1;
+        setrlimit(RLIMIT_CPU, &limit);
+    }
+    if (sandbox.max_memory) {
+        unsigned long pages = 0;
+        FILE *statm = fopen("/proc/self/statm", "r");
+        if (statm) {
+            if (fscanf(statm, "%lu", &pages) != 1) pages = 0;
+            fclose(statm);
+        }
+        limit.rlim_cur = limit.rlim_max = pages * sysconf(_SC_PAGESIZE) + sandbox.max_memory;
+        setrlimit(RLIMIT_AS, &limit);
+    }
+    interpret(command, &s->stack);
+    char *state = NULL;
+    size_t size = 0;
+    f = open_memstream(&state, &size);
+    if (!f) _exit(1);
+    session_save(f, s);
+    fclose(f);
+    sandbox_send('S', state, size);
+    _exit(0);
+}
+
+// Processus auxiliaire, lancé par main() avant tout thread : fork() y est sûr (aucun verrou tenu
+// par un autre thread). Chaque message de control apporte un socket, sur lequel un enfant exécute
+// une commande ; à la mort de l'enfant, son statut y est écrit ('X') et le socket fermé.
+static void sandbox_helper(int control) {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &signals, NULL);
+    int child_fd = signalfd(-1, &signals, 0);
+    struct { pid_t pid; int fd; } *children = NULL;
+    int count = 0, cap = 0;
+    for (;;) {
+        struct pollfd pfd[2] = {{control, POLLIN, 0}, {child_fd, POLLIN, 0}};
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pfd[1].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            if (read(child_fd, &info, sizeof(info)) < 0) {} // Les statuts sont relevés ci-dessous
+            pid_t pid;
+            int status;
+            while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+                for (int i = 0; i < count; i++) {
+                    if (children[i].pid != pid) continue;
+                    unsigned char record[5 + sizeof(status)] = {'X', sizeof(status), 0, 0, 0};
+                    memcpy(record + 5, &status, sizeof(status));
+                    send(children[i].fd, record, sizeof(record), MSG_NOSIGNAL);
+                    close(children[i].fd);
+                    children[i] = children[--count];
+                    break;
+                }
+            }
+        }
+        if (pfd[0].revents & (POLLIN | POLLHUP)) {
+            char byte;
+            char control_buf[CMSG_SPACE(sizeof(int))];
+            struct iovec iov = {&byte, 1};
+            struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control_buf, .msg_controllen = sizeof(control_buf)};
+            ssize_t n = recvmsg(control, &msg, 0);
+            if (n == 0) break; // Le bot s'est arrêté
+            struct cmsghdr *cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+            if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS) continue;
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+            if (count == cap) {
+                int grown_cap = cap ? cap * 2 : 16;
+                void *grown = realloc(children, grown_cap * sizeof(*children));
+                if (!grown) {
+                    close(fd); // Le parent lit une fin de flux sans état : commande annulée
+                    continue;
+                }
+                children = grown;
+                cap = grown_cap;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(control);
+                close(child_fd);
+                for (int i = 0; i < count; i++) close(children[i].fd); // Sinon leurs parents n'en verraient pas la fin
+                sigprocmask(SIG_UNBLOCK, &signals, NULL);
+                sandbox_child(fd);
+            }
+            if (pid < 0) {
+                close(fd);
+                continue;
+            }
+            children[count].pid = pid;
+            children[count].fd = fd;
+            count++;
+        }
+    }
+    _exit(0);
+}
+
+// Démarre le processus auxiliaire ; appelé par main() une fois l'image de base prête, avant les threads
+void init_sandbox_helper() {
+    if (!sandbox.enabled) return;
+    int control[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, control) < 0) {
+        printf("Sandbox: socketpair failed, sandbox disabled\n");
+        sandbox.enabled = 0;
+        return;
+    }
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(control[0]);
+        sandbox_helper(control[1]);
+    }
+    close(control[1]);
+    if (pid < 0) {
+        close(control[0]);
+        printf("Sandbox: fork failed, sandbox disabled\n");
+        sandbox.enabled = 0;
+        return;
+    }
+    sandbox.helper_fd = control[0];
+}
+
+// Traite les enregistrements complets de buf ; renvoie le nombre d'octets consommés
+static size_t sandbox_records(Session *s, char *buf, size_t len, SandboxRun *run) {
+    size_t pos = 0;
+    while (len - pos >= 5) {
+        unsigned char *header = (unsigned char *)buf + pos;
+        size_t size = header[1] | header[2] << 8 | header[3] << 16 | (size_t)header[4] << 24;
+        if (len - pos - 5 < size) break;
+        char *data = buf + pos + 5;
+        char saved = data[size];
+        data[size] = '\0';
+        if (header[0] == 'P' && size == sizeof(pid_t)) {
+            memcpy(&run->pid, data, sizeof(pid_t));
+            run->started_us = now_us();
+        } else if (header[0] == 'X' && size == sizeof(int)) {
+            memcpy(&run->status, data, sizeof(int));
+            run->exited = 1;
+        } else if (header[0] == 'O') {
+            send_to_channel(data);
+        } else if (header[0] == 'J') {
+            free(run->spawn);
+            run->spawn = strdup(data);
+        } else if (header[0] == 'R') {
+            // Mot délégué par l'enfant, exécuté ici sur la session ; l'enfant attend l'indicateur d'erreur
+            char *end;
+            Instruction instr = {(OpCode)strtol(data, &end, 10), 0};
+            int error = s->error_flag;
+            if (*end == ' ') {
+                mpz_t arg;
+                mpz_init_set_str(arg, end + 1, 10);
+                push(&s->stack, arg);
+                mpz_clear(arg);
+            }
+            long int ip = 0;
+            executeInstruction(instr, &s->stack, &ip, NULL, -1);
+            char failed = s->error_flag;
+            s->error_flag = error; // L'état final de l'enfant fera foi
+            send(run->fd, &failed, 1, MSG_NOSIGNAL);
+        } else if (header[0] == 'S') {
+            FILE *f = fmemopen(data, size, "r");
+            run->loaded = f && session_load(f, s);
+            if (f) fclose(f);
+        }
+        data[size] = saved;
+        pos += 5 + size;
+    }
+    return pos;
+}
+
+// Demande de l'exécution : job, budget, quota (avec le pseudo), commande puis état de la session
+static int sandbox_request(int fd, Session *s, char *command) {
+    char *request = NULL;
+    size_t size = 0;
+    FILE *f = open_memstream(&request, &size);
+    if (!f) return 0;
+    put_long(f, s->job != NULL);
+    fwrite(&vm_budget, sizeof(vm_budget), 1, f);
+    Quota quota = *active_quota;
+    snprintf(quota.nick, sizeof(quota.nick), "%s", s->nick);
+    fwrite(&quota, sizeof(quota), 1, f);
+    put_str(f, command);
+    session_save(f, s);
+    fclose(f);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = send(fd, request + done, size - done, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += n;
+    }
+    free(request);
+    return done == size;
+}
+
+// Parent : confie la commande au processus auxiliaire, relaie la sortie de l'enfant,
+// applique son état final, le tue au-delà du budget
+void sandbox_run(Session *s, char *command) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        set_error("Sandbox: socketpair failed");
+        return;
+    }
+    long long start = now_us();
+    char byte = 0;
+    char control_buf[CMSG_SPACE(sizeof(int))] = {0};
+    struct iovec iov = {&byte, 1};
+    struct msghdr msg = {.msg_iov = &iov, .msg_iovlen = 1, .msg_control = control_buf, .msg_controllen = sizeof(control_buf)};
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fds[1], sizeof(int));
+    int sent = sendmsg(sandbox.helper_fd, &msg, MSG_NOSIGNAL) == 1; // Message atomique : pas de verrou
+    close(fds[1]);
+    if (!sent) {
+        close(fds[0]);
+        set_error("Sandbox: helper process not running");
+        return;
+    }
+    atomic_fetch_add_explicit(&sandbox.forks, 1, memory_order_relaxed);
+
+    long long deadline = vm_budget.max_milliseconds ?
+        vm_budget.start_us + (long long)(vm_budget.max_milliseconds + SANDBOX_GRACE_MILLISECONDS) * 1000 : 0;
+    size_t cap = 4096, len = 0;
+    char *buf = malloc(cap + 1);
+    const char *reason = NULL, *cancelled = "Job cancelled";
+    SandboxRun run = {.fd = fds[0]};
+    if (!buf) reason = "out of memory";
+    else if (!sandbox_request(fds[0], s, command)) reason = "request not delivered";
+    while (!reason) {
+        struct pollfd pfd = {fds[0], POLLIN, 0};
+        if (poll(&pfd, 1, 50) > 0) {
+            if (cap - len < 4096) {
+                char *grown = realloc(buf, cap * 2 + 1);
+                if (!grown) {
+                    reason = "out of memory";
+                    break;
+                }
+                buf = grown;
+                cap *= 2;
+            }
+            ssize_t n = read(fds[0], buf + len, cap - len);
+            if (n <= 0) break; // Enfant terminé et statut reçu
+            len += n;
+            pid_t known = run.pid;
+            size_t used = sandbox_records(s, buf, len, &run);
+            memmove(buf, buf + used, len - used);
+            len -= used;
+            if (!known && run.pid) {
+                long long start_us = run.started_us - start;
+                atomic_fetch_add_explicit(&sandbox.fork_us_total, start_us, memory_order_relaxed);
+                if (start_us > atomic_load_explicit(&sandbox.fork_us_max, memory_order_relaxed)) {
+                    atomic_store_explicit(&sandbox.fork_us_max, start_us, memory_order_relaxed);
+                }
+            }
+        }
+        if (!reason && deadline && now_us() > deadline) reason = "wall-clock limit exceeded";
+        if (!reason && s->job && atomic_load_explicit(&s->job->cancel, memory_order_relaxed)) reason = cancelled;
+    }
+    free(buf);
+    close(fds[0]); // Un enfant pas encore lancé trouve son socket fermé et s'arrête
+    if (reason && run.pid > 0 && !run.exited) kill(run.pid, SIGKILL); // Le processus auxiliaire le ramasse
+
+    if (!run.loaded) {
+        // L'état de la session reste celui d'avant la commande
+        char msg[128];
+        if (!reason && run.exited && WIFSIGNALED(run.status)) {
+            int sig = WTERMSIG(run.status);
+            reason = sig == SIGXCPU || sig == SIGKILL ? "CPU limit exceeded" :
+                     sig == SIGABRT || sig == SIGSEGV || sig == SIGBUS ? "memory limit exceeded or crash" : "killed";
+        }
+        atomic_fetch_add_explicit(&sandbox.killed, 1, memory_order_relaxed);
+        snprintf(msg, sizeof(msg), "Sandbox: command aborted (%s)", reason ? reason : "no state returned");
+        set_error(reason == cancelled ? cancelled : msg); // Même message qu'en mode direct
+    } else if (run.spawn) {
+        job_spawn(run.spawn);
+    }
+    free(run.spawn);
+}
+
+// FORTH_STATS_FILE : fichier écrit à la réception de SIGUSR1
+void init_latency() {
+    char *env = getenv("FORTH_STATS_FILE");
+    if (env) snprintf(latency_file, sizeof(latency_file), "%s", env);
+    latency.since_ns = now_ns();
+}
+
+// Seau : valeur exacte sous 16 ns, puis 16 sous-seaux par puissance de deux
+static int latency_bucket(long long ns) {
+    if (ns < (1 << LATENCY_SUB_BITS)) return ns < 0 ? 0 : (int)ns;
+    int exp = 63 - __builtin_clzll((unsigned long long)ns);
+    return ((exp - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+           (int)((ns >> (exp - LATENCY_SUB_BITS)) & ((1 << LATENCY_SUB_BITS) - 1));
+}
+
+// Plus grande valeur qui tombe dans le seau
+static long long latency_bucket_high(int bucket) {
+    if (bucket < (1 << LATENCY_SUB_BITS)) return bucket;
+    int shift = (bucket >> LATENCY_SUB_BITS) - 1;
+    long long low = (long long)((1 << LATENCY_SUB_BITS) + (bucket & ((1 << LATENCY_SUB_BITS) - 1))) << shift;
+    return low + (1LL << shift) - 1;
+}
+
+static void latency_add(LatencyHistogram *h, long long ns) {
+    h->counts[latency_bucket(ns)]++;
+    h->count++;
+    h->sum += ns;
+    if (ns > h->max) h->max = ns;
+}
+
+static long long latency_percentile(const LatencyHistogram *h, double percent) {
+    if (!h->count) return 0;
+    double exact = percent / 100.0 * h->count;
+    unsigned long rank = (unsigned long)exact;
+    if (rank < exact || rank == 0) rank++;
+    unsigned long seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += h->counts[b];
+        if (seen >= rank) {
+            long long high = latency_bucket_high(b);
+            return high < h->max ? high : h->max;
+        }
+    }
+    return h->max;
+}
+
+static char *format_duration(long long ns, char *buf) {
+    if (ns < 1000) snprintf(buf, 24, "%lldns", ns);
+    else if (ns < 1000000) snprintf(buf, 24, "%.1fus", ns / 1e3);
+    else if (ns < 1000000000) snprintf(buf, 24, "%.2fms", ns / 1e6);
+    else snprintf(buf, 24, "%.2fs", ns / 1e9);
+    return buf;
+}
+
+// Entrée d'un pseudo, créée au besoin (verrou tenu) ; NULL si la table est pleine
+static NickLatency *latency_nick(const char *nick, int create) {
+    uint64_t hash = result_cache_hash(nick);
+    for (int i = 0; i < LATENCY_NICKS; i++) {
+        NickLatency *n = &latency.nicks[(hash + i) % LATENCY_NICKS];
+        if (!n->nick[0]) {
+            if (!create || latency.nick_count >= LATENCY_NICKS * 3 / 4) return NULL;
+            snprintf(n->nick, sizeof(n->nick), "%s", nick);
+            latency.nick_count++;
+            return n;
+        }
+        if (strcmp(n->nick, nick) == 0) return n;
+    }
+    return NULL;
+}
+
+// Fin de commande : phases mesurées par ce thread, temps total et attente dans la file
+void latency_record(const char *nick, int error, long long total_ns, long long wait_ns) {
+    pthread_mutex_lock(&latency.lock);
+    latency.commands++;
+    latency.errors += error;
+    for (int i = 0; i < PHASE_COUNT; i++) latency_add(&latency.series[i], phase_ns[i]);
+    latency_add(&latency.series[LATENCY_TOTAL], total_ns);
+    latency_add(&latency.series[LATENCY_WAIT], wait_ns);
+    NickLatency *n = latency_nick(nick, 1);
+    if (n) {
+        n->commands++;
+        n->errors += error;
+        n->total_ns += total_ns;
+        if (total_ns > n->max_ns) n->max_ns = total_ns;
+        for (int i = 0; i < PHASE_COUNT; i++) n->phase_ns[i] += phase_ns[i];
+    }
+    pthread_mutex_unlock(&latency.lock);
+}
+
+// "nom p50 X p99 Y max Z" pour une série
+static void latency_series_text(int series, char *out, size_t size) {
+    const LatencyHistogram *h = &latency.series[series];
+    char p50[24], p99[24], max[24];
+    snprintf(out, size, "%s %s/%s/%s", latency_names[series], format_duration(latency_percentile(h, 50), p50),
+             format_duration(latency_percentile(h, 99), p99), format_duration(h->max, max));
+}
+
+// STATS : p50/p99/max des phases et des totaux, puis les compteurs de l'appelant
+void latency_report(const char *nick) {
+    char lines[3][512];
+    char entry[96];
+    pthread_mutex_lock(&latency.lock);
+    snprintf(lines[0], sizeof(lines[0]), "Latency over %lu commands (%lu errors, %.0f s), p50/p99/max:",
+             latency.commands, latency.errors, (now_ns() - latency.since_ns) / 1e9);
+    for (int i = LATENCY_TOTAL; i < LATENCY_SERIES; i++) {
+        latency_series_text(i, entry, sizeof(entry));
+        snprintf(lines[0] + strlen(lines[0]), sizeof(lines[0]) - strlen(lines[0]), " %s%s", entry, i + 1 < LATENCY_SERIES ? "," : "");
+    }
+    snprintf(lines[1], sizeof(lines[1]), "Phases p50/p99/max:");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        latency_series_text(i, entry, sizeof(entry));
+        snprintf(lines[1] + strlen(lines[1]), sizeof(lines[1]) - strlen(lines[1]), " %s%s", entry, i + 1 < PHASE_COUNT ? "," : "");
+    }
+    NickLatency *n = latency_nick(nick, 0);
+    if (n && n->commands) {
+        char avg[24], max[24];
+        snprintf(lines[2], sizeof(lines[2]), "%.63s: %lu commands, %lu errors, total avg %s max %s, avg",
+                 n->nick, n->commands, n->errors, format_duration(n->total_ns / n->commands, avg), format_duration(n->max_ns, max));
+        for (int i = 0; i < PHASE_COUNT; i++) {
+            snprintf(lines[2] + strlen(lines[2]), sizeof(lines[2]) - strlen(lines[2]), " %s %s", latency_names[i],
+                     format_duration(n->phase_ns[i] / n->commands, avg));
+        }
+    } else {
+        snprintf(lines[2], sizeof(lines[2]), "%.63s: no command measured yet", nick);
+    }
+    pthread_mutex_unlock(&latency.lock);
+    for (int i = 0; i < 3; i++) send_to_channel(lines[i]);
+}
+
+// SIGUSR1 (thread réseau) : percentiles détaillés et tous les pseudos dans FORTH_STATS_FILE
+void latency_dump() {
+    FILE *f = fopen(latency_file, "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write %s: %s\n", latency_file, strerror(errno));
+        return;
+    }
+    static const double percents[] = {50, 90, 99, 99.9};
+    char value[24];
+    pthread_mutex_lock(&latency.lock);
+    fprintf(f, "# %lu commands, %lu errors, %.1f s\n", latency.commands, latency.errors, (now_ns() - latency.since_ns) / 1e9);
+    fprintf(f, "%-8s %10s %10s %10s %10s %10s %10s %10s\n", "series", "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+    for (int i = 0; i < LATENCY_SERIES; i++) {
+        const LatencyHistogram *h = &latency.series[i];
+        fprintf(f, "%-8s %10lu %10s", latency_names[i], h->count, format_duration(h->count ? h->sum / (long long)h->count : 0, value));
+        for (int p = 0; p < 4; p++) fprintf(f, " %10s", format_duration(latency_percentile(h, percents[p]), value));
+        fprintf(f, " %10s\n", format_duration(h->max, value));
+    }
+    fprintf(f, "\n%-24s %8s %8s %10s %10s", "nick", "commands", "errors", "avg", "max");
+    for (int i = 0; i < PHASE_COUNT; i++) fprintf(f, " %10s", latency_names[i]);
+    fputc('\n', f);
+    for (int i = 0; i < LATENCY_NICKS; i++) {
+        NickLatency *n = &latency.nicks[i];
+        if (!n->nick[0] || !n->commands) continue;
+        fprintf(f, "%-24s %8lu %8lu %10s", n->nick, n->commands, n->errors, format_duration(n->total_ns / n->commands, value));
+        fprintf(f, " %10s", format_duration(n->max_ns, value));
+        for (int p = 0; p < PHASE_COUNT; p++) fprintf(f, " %10s", format_duration(n->phase_ns[p] / n->commands, value));
+        fputc('\n', f);
+    }
+    pthread_mutex_unlock(&latency.lock);
+    fclose(f);
+}
+
+#ifdef FORTH_PROFILE
+const char *opcode_names[OP_COUNT] = {
+    [OP_PUSH] = "(literal)", [OP_ADD] = "+", [OP_SUB] = "-", [OP_MUL] = "*", [OP_DIV] = "/", [OP_MOD] = "MOD",
+    [OP_DUP] = "DUP", [OP_SWAP] = "SWAP", [OP_OVER] = "OVER", [OP_ROT] = "ROT", [OP_DROP] = "DROP", [OP_NIP] = "NIP",
+    [OP_EQ] = "=", [OP_LT] = "<", [OP_GT] = ">", [OP_AND] = "AND", [OP_OR] = "OR", [OP_NOT] = "NOT",
+    [OP_I] = "I", [OP_DO] = "DO", [OP_LOOP] = "LOOP", [OP_BRANCH_FALSE] = "IF", [OP_BRANCH] = "(branch)",
+    [OP_CALL] = "(call)", [OP_END] = "(end)", [OP_EXIT] = "EXIT", [OP_RECURSE] = "RECURSE",
+    [OP_BEGIN] = "BEGIN", [OP_WHILE] = "WHILE", [OP_REPEAT] = "REPEAT",
+    [OP_CASE] = "CASE", [OP_OF] = "OF", [OP_ENDOF] = "ENDOF", [OP_ENDCASE] = "ENDCASE",
+    [OP_DOT_QUOTE] = ".\"", [OP_CR] = "CR", [OP_DOT_S] = ".S", [OP_FLUSH] = "FLUSH", [OP_DOT] = ".", [OP_EMIT] = "EMIT",
+    [OP_BIT_AND] = "&", [OP_BIT_OR] = "|", [OP_BIT_XOR] = "^", [OP_BIT_NOT] = "~", [OP_LSHIFT] = "LSHIFT", [OP_RSHIFT] = "RSHIFT",
+    [OP_FETCH] = "@", [OP_STORE] = "!", [OP_PLUSSTORE] = "+!", [OP_PICK] = "PICK", [OP_ROLL] = "ROLL",
+    [OP_DEPTH] = "DEPTH", [OP_TOP] = "TOP", [OP_VARIABLE] = "VARIABLE", [OP_CREATE] = "CREATE", [OP_ALLOT] = "ALLOT",
+    [OP_SUM] = "SUM", [OP_DOT_PRODUCT] = "DOT", [OP_PREFIX_SUM] = "PREFIX-SUM", [OP_MINMAX] = "MINMAX",
+    [OP_MAP] = "MAP", [OP_REDUCE] = "REDUCE", [OP_YIELD] = "YIELD", [OP_NEXT] = "NEXT", [OP_TAKE] = "TAKE",
+};
+
+// Opcodes dont le coût est celui de l'arithmétique GMP : chronométrés à part
+static int opcode_uses_gmp(OpCode op) {
+    switch (op) {
+        case OP_ADD: case OP_SUB: case OP_MUL: case OP_DIV: case OP_MOD:
+        case OP_BIT_AND: case OP_BIT_OR: case OP_BIT_XOR: case OP_BIT_NOT: case OP_LSHIFT: case OP_RSHIFT:
+        case OP_SUM: case OP_DOT_PRODUCT: case OP_PREFIX_SUM:
+        case OP_ARRAY_AND: case OP_ARRAY_OR: case OP_ARRAY_XOR:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static const char *profile_opcode_name(int op, char *buf) {
+    if (opcode_names[op]) return opcode_names[op];
+    snprintf(buf, 16, "OP_%d", op);
+    return buf;
+}
+
+static const char *profile_word_name(int index) {
+    if (index == PROFILE_TOP) return "(interactive)";
+    if (index < session->dict_count && session->dictionary[index]) return session->dictionary[index]->name;
+    return "(forgotten)";
+}
+
+// Entrée dans un mot : renvoie l'instant de départ, met de côté le temps des appelés de l'appelant
+long long profile_enter(Profile *profile, int slot, long long *saved_children) {
+    WordProfile *w = &profile->words[slot];
+    w->calls++;
+    w->active++;
+    *saved_children = profile->child_ns;
+    profile->child_ns = 0;
+    return now_ns();
+}
+
+void profile_leave(Profile *profile, int slot, long long start, long long saved_children) {
+    long long elapsed = now_ns() - start;
+    WordProfile *w = &profile->words[slot];
+    w->exclusive_ns += elapsed - profile->child_ns;
+    if (w->active > 0 && --w->active == 0) w->inclusive_ns += elapsed;
+    profile->child_ns = saved_children + elapsed;
+}
+
+// Avant chaque instruction : compteurs par opcode et par paire ; renvoie l'instant de départ d'un opcode GMP
+long long profile_instruction(OpCode op, int *previous_op) {
+    Profile *profile = session->profile;
+    if (!profile || !profile->enabled) return 0;
+    profile->instructions++;
+    profile->ops[op]++;
+    if (*previous_op >= 0) profile->pairs[*previous_op][op]++;
+    *previous_op = op;
+    return opcode_uses_gmp(op) ? now_ns() : 0;
+}
+
+void profile_gmp(int word_index, long long start) {
+    if (session->profile) session->profile->words[word_index >= 0 ? word_index : PROFILE_TOP].gmp_ns += now_ns() - start;
+}
+
+// Insère index dans top[] (trié par valeur décroissante, au plus max entrées) ; renvoie la nouvelle taille
+static int profile_rank(int *top, long long *values, int count, int max, int index, long long value) {
+    if (value <= 0 || (count == max && value <= values[count - 1])) return count;
+    int i = count < max ? count++ : max - 1;
+    while (i > 0 && values[i - 1] < value) {
+        top[i] = top[i - 1];
+        values[i] = values[i - 1];
+        i--;
+    }
+    top[i] = index;
+    values[i] = value;
+    return count;
+}
+
+static void profile_report() {
+    Profile *profile = session->profile;
+    char msg[1024], entry[160], name[16], other[16];
+    int top[10];
+    long long values[10];
+    int count = 0;
+    long long elapsed = profile->elapsed_ns + (profile->enabled ? now_ns() - profile->since_ns : 0);
+    snprintf(msg, sizeof(msg), "Profile (%s): %lu instructions in %.3f s; opcodes:", profile->enabled ? "on" : "off",
+             profile->instructions, elapsed / 1e9);
+    for (int op = 0; op < OP_COUNT; op++) count = profile_rank(top, values, count, 10, op, profile->ops[op]);
+    for (int i = 0; i < count; i++) {
+        snprintf(entry, sizeof(entry), " %s %lld (%.1f%%)", profile_opcode_name(top[i], name), values[i],
+                 100.0 * values[i] / profile->instructions);
+        strncat(msg, entry, sizeof(msg) - strlen(msg) - 1);
+    }
+    send_to_channel(msg);
+
+    count = 0;
+    for (int a = 0; a < OP_COUNT; a++) {
+        for (int b = 0; b < OP_COUNT; b++) count = profile_rank(top, values, count, 10, a * OP_COUNT + b, profile->pairs[a][b]);
+    }
+    snprintf(msg, sizeof(msg), "Pairs:%s", count ? "" : " none");
+    for (int i = 0; i < count; i++) {
+        snprintf(entry, sizeof(entry), " %s %s %lld", profile_opcode_name(top[i] / OP_COUNT, name),
+                 profile_opcode_name(top[i] % OP_COUNT, other), values[i]);
+        strncat(msg, entry, sizeof(msg) - strlen(msg) - 1);
+    }
+    send_to_channel(msg);
+
+    count = 0;
+    for (int i = 0; i <= PROFILE_TOP; i++) count = profile_rank(top, values, count, 10, i, profile->words[i].exclusive_ns);
+    snprintf(msg, sizeof(msg), "Words by exclusive time (calls incl/excl/gmp):%s", count ? "" : " none");
+    for (int i = 0; i < count; i++) {
+        WordProfile *w = &profile->words[top[i]];
+        char inclusive[24], exclusive[24], gmp[24];
+        snprintf(entry, sizeof(entry), " %.40s %lu %s/%s/%s%s", profile_word_name(top[i]), w->calls,
+                 format_duration(w->inclusive_ns, inclusive), format_duration(w->exclusive_ns, exclusive),
+                 format_duration(w->gmp_ns, gmp), i + 1 < count ? "," : "");
+        strncat(msg, entry, sizeof(msg) - strlen(msg) - 1);
+    }
+    send_to_channel(msg);
+}
+
+// PROFILE ON remet les compteurs à zéro, OFF les garde pour REPORT
+void profile_command(long int mode) {
+    Profile *profile = session->profile;
+    if (mode == PROFILE_ON) {
+        if (!profile) profile = session->profile = malloc(sizeof(Profile));
+        if (!profile) {
+            set_error("PROFILE: Memory allocation failed");
+            return;
+        }
+        memset(profile, 0, sizeof(Profile));
+        profile->enabled = 1;
+        profile->since_ns = now_ns();
+        send_to_channel("Profiling on");
+    } else if (!profile) {
+        set_error("PROFILE: no profile yet, use PROFILE ON");
+    } else if (mode == PROFILE_OFF) {
+        if (profile->enabled) profile->elapsed_ns += now_ns() - profile->since_ns;
+        profile->enabled = 0;
+        send_to_channel("Profiling off");
+    } else {
+        profile_report();
+    }
+}
+#endif
+
+// Index + 1 du nom dans sampler.names, 0 si la table est pleine (appelé depuis le gestionnaire de signal)
+static uint32_t sampler_name(const char *name) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; name[i] && i < SAMPLE_NAME_SIZE - 1; i++) hash = (hash ^ (unsigned char)name[i]) * 1099511628211ULL;
+    hash |= 1;
+    for (int i = 0; i < SAMPLE_NAMES; i++) {
+        int slot = (hash + i) % SAMPLE_NAMES;
+        SampleName *entry = &sampler.names[slot];
+        uint64_t current = atomic_load_explicit(&entry->hash, memory_order_acquire);
+        if (current == 0) {
+            if (atomic_compare_exchange_strong(&entry->hash, &current, hash)) {
+                int len = 0;
+                while (name[len] && len < SAMPLE_NAME_SIZE - 1) {
+                    entry->name[len] = name[len];
+                    len++;
+                }
+                entry->name[len] = '\0';
+                atomic_store_explicit(&entry->ready, 1, memory_order_release);
+                return slot + 1;
+            }
+        }
+        if (current == hash) return slot + 1; // Peut-être pas encore copié : il le sera au PROFILE-DUMP
+    }
+    return 0;
+}
+
+static void sampler_count(const uint32_t *frames, int depth) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; i < depth; i++) hash = (hash ^ frames[i]) * 1099511628211ULL;
+    hash |= 1;
+    for (int i = 0; i < SAMPLE_STACKS; i++) {
+        SampleStack *entry = &sampler.stacks[(hash + i) % SAMPLE_STACKS];
+        uint64_t current = atomic_load_explicit(&entry->hash, memory_order_acquire);
+        if (current == 0 && atomic_compare_exchange_strong(&entry->hash, &current, hash)) {
+            memcpy(entry->frames, frames, depth * sizeof(uint32_t));
+            entry->depth = depth;
+            atomic_store_explicit(&entry->ready, 1, memory_order_release);
+            current = hash;
+        }
+        if (current == hash) {
+            atomic_fetch_add_explicit(&entry->count, 1, memory_order_relaxed);
+            atomic_fetch_add_explicit(&sampler.samples, 1, memory_order_relaxed);
+            return;
+        }
+    }
+    atomic_fetch_add_explicit(&sampler.dropped, 1, memory_order_relaxed);
+}
+
+// SIGPROF : pile Forth du thread interrompu, précédée du pseudo de la session
+static void sampler_tick(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    uint32_t frames[VM_FRAMES + 2];
+    int n = 0;
+    if (session != &base_session) frames[n++] = sampler_name(session->nick) << 16 | SAMPLE_NO_IP;
+    int depth = vm_frames.depth;
+    int first = depth >= VM_FRAMES ? depth - VM_FRAMES + 1 : 0; // La case suivante peut être en cours d'écriture
+    if (first > 0) frames[n++] = sampler_name("(deeper)") << 16 | SAMPLE_NO_IP;
+    for (int i = first; i < depth; i++) {
+        VmFrame *frame = &vm_frames.frames[i & (VM_FRAMES - 1)];
+        const char *name = frame->word->name ? frame->word->name : "(interactive)";
+        frames[n++] = sampler_name(name) << 16 | (uint32_t)(*frame->ip < SAMPLE_NO_IP ? *frame->ip : SAMPLE_NO_IP - 1);
+    }
+    if (depth == 0) frames[n++] = sampler_name("(native)") << 16 | SAMPLE_NO_IP;
+    sampler_count(frames, n);
+    errno = saved_errno;
+}
+
+// FORTH_SAMPLE_HZ : fréquence de SIGPROF en temps CPU (0, défaut : arrêté), FORTH_SAMPLE_FILE : sortie de PROFILE-DUMP
+void init_sampler() {
+    char *env = getenv("FORTH_SAMPLE_FILE");
+    if (env) snprintf(sampler.file, sizeof(sampler.file), "%s", env);
+    env = getenv("FORTH_SAMPLE_HZ");
+    if (env) sampler.hz = atoi(env);
+    if (sampler.hz <= 0) return;
+    if (sampler.hz > 100000) sampler.hz = 100000;
+    struct sigaction action = {0};
+    action.sa_handler = sampler_tick;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+    long interval = 1000000L / sampler.hz;
+    struct itimerval timer = {{interval / 1000000, interval % 1000000}, {interval / 1000000, interval % 1000000}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+// PROFILE-DUMP : une ligne "racine;appelant+ip;...;mot+ip nombre" par pile, lisible par flamegraph.pl
+void sampler_dump() {
+    if (sampler.hz <= 0) {
+        set_error("PROFILE-DUMP: sampler is off, set FORTH_SAMPLE_HZ (e.g. 1000)");
+        return;
+    }
+    FILE *f = fopen(sampler.file, "w");
+    if (!f) {
+        char msg[512];
+        snprintf(msg, sizeof(msg), "PROFILE-DUMP: cannot write %.200s: %s", sampler.file, strerror(errno));
+        set_error(msg);
+        return;
+    }
+    long int lines = 0;
+    for (int i = 0; i < SAMPLE_STACKS; i++) {
+        SampleStack *entry = &sampler.stacks[i];
+        if (!atomic_load_explicit(&entry->ready, memory_order_acquire)) continue;
+        for (int j = 0; j < entry->depth; j++) {
+            uint32_t name = entry->frames[j] >> 16, ip = entry->frames[j] & 0xffff;
+            SampleName *n = name ? &sampler.names[name - 1] : NULL;
+            fputs(j ? ";" : "", f);
+            fputs(n && atomic_load_explicit(&n->ready, memory_order_acquire) ? n->name : "(unknown)", f);
+            if (ip != SAMPLE_NO_IP) fprintf(f, "+%u", ip);
+        }
+        fprintf(f, " %lu\n", atomic_load_explicit(&entry->count, memory_order_relaxed));
+        lines++;
+    }
+    fclose(f);
+    char msg[512];
+    snprintf(msg, sizeof(msg), "%ld stacks, %lu samples (FORTH_SAMPLE_HZ=%d, %lu dropped) written to %.200s", lines,
+             atomic_load_explicit(&sampler.samples, memory_order_relaxed), sampler.hz,
+             atomic_load_explicit(&sampler.dropped, memory_order_relaxed), sampler.file);
+    send_to_channel(msg);
+}
+
+// Exécute une commande dans sa session, hors verrou
+void run_command(Session *s, PendingCommand *command) {
+    char *cache_key = NULL;
+    long long start_ns = now_ns();
+    memset(phase_ns, 0, sizeof(phase_ns));
+    phase_current = PHASE_PARSE;
+    phase_since_ns = start_ns;
+    session = s;
+    s->error_flag = 0; // Pour les commandes rejouées depuis le cache
+    reply_target = command->reply_to[0] ? command->reply_to : CHANNEL;
+    reply_network = command->network;
+    output_batching = 1;
+    active_quota = find_quota(command->nick);
+    gmp_heap_begin_command();
+    vm_begin_command();
+    if (s->job && atomic_load_explicit(&s->job->cancel, memory_order_relaxed)) {
+        set_error("Job cancelled"); // KILL avant le démarrage
+    } else if (!s->job && result_cache_replay(s, command->command, &cache_key)) {
+        // Réponse rejouée depuis le cache
+    } else if (sandbox.enabled) {
+        phase_switch(PHASE_EXECUTE); // Les phases du processus isolé ne remontent pas
+        sandbox_run(s, command->command);
+    } else {
+        interpret(command->command, &s->stack);
+    }
+    if (cache_key) result_cache_store(s, cache_key);
+    release_temporaries(s);
+    s->last_cmd_allocs = gmp_heap.cmd_allocs;
+    s->last_cmd_delta = gmp_heap.cmd_bytes;
+    s->last_cmd_peak = gmp_heap.cmd_peak_bytes;
+    s->heavy = (unsigned long)((now_us() - vm_budget.start_us) / 1000) >= scheduler.heavy_ms;
+    s->bytes = session_bytes(s);
+    int error = s->error_flag;
+    session = &base_session;
+    output_batching = 0;
+    phase_switch(PHASE_SEND);
+    output_flush();
+    long long end_ns = phase_stop();
+    latency_record(command->nick, error, end_ns - start_ns, start_ns - command->enqueued_us * 1000);
+    reply_target = CHANNEL;
+    reply_network = 0;
+}
+
+// FORTH_WORKERS (défaut : nombre de cœurs), FORTH_MAX_HEAVY, FORTH_HEAVY_MILLISECONDS
+void init_scheduler() {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    scheduler.workers = cpus > 0 ? (int)cpus : 1;
+    char *env = getenv("FORTH_WORKERS");
+    if (env) scheduler.workers = atoi(env);
+    if (scheduler.workers < 1) scheduler.workers = 1;
+    if (scheduler.workers > MAX_WORKERS) scheduler.workers = MAX_WORKERS;
+    scheduler.max_heavy = scheduler.workers > 1 ? scheduler.workers / 2 : 1;
+    env = getenv("FORTH_MAX_HEAVY");
+    if (env && atoi(env) > 0) scheduler.max_heavy = atoi(env);
+    env = getenv("FORTH_HEAVY_MILLISECONDS");
+    if (env) scheduler.heavy_ms = strtoul(env, NULL, 10);
+}
+
+// Thread réseau : retourne 0 si trop de commandes attendent déjà
+int scheduler_submit(PendingCommand *command) {
+    pthread_mutex_lock(&scheduler.lock);
+    if (scheduler.queued >= MAX_QUEUED_COMMANDS) {
+        pthread_mutex_unlock(&scheduler.lock);
+        return 0;
+    }
+    command->enqueued_us = now_us();
+    command->next = NULL;
+    if (scheduler.incoming_tail) scheduler.incoming_tail->next = command;
+    else scheduler.incoming_head = command;
+    scheduler.incoming_tail = command;
+    scheduler.queued++;
+    pthread_cond_signal(&scheduler.wakeup);
+    pthread_mutex_unlock(&scheduler.lock);
+    return 1;
+}
+
+static void scheduler_make_ready(Session *s) {
+    s->ready = 1;
+    s->ready_next = NULL;
+    if (scheduler.ready_tail) scheduler.ready_tail->ready_next = s;
+    else scheduler.ready_head = s;
+    scheduler.ready_tail = s;
+}
+
+// Range les commandes reçues dans la file de leur session (verrou tenu)
+static void scheduler_collect() {
+    while (scheduler.incoming_head) {
+        PendingCommand *command = scheduler.incoming_head;
+        scheduler.incoming_head = command->next;
+        if (!scheduler.incoming_head) scheduler.incoming_tail = NULL;
+        command->next = NULL;
+        Session *s = session_for_nick(command->nick);
+        if (!s) {
+            send_to_channel("Out of memory: cannot create session");
+            scheduler.queued--;
+            free(command);
+            continue;
+        }
+        if (s->queue_tail) s->queue_tail->next = command;
+        else s->queue_head = command;
+        s->queue_tail = command;
+        if (!s->running && !s->ready) scheduler_make_ready(s);
+    }
+}
+
+// Première session prête, en sautant les lourdes si leur quota de threads est atteint (verrou tenu)
+static Session *scheduler_pick() {
+    Session *prev = NULL;
+    for (Session *s = scheduler.ready_head; s; prev = s, s = s->ready_next) {
+        if (s->heavy && scheduler.heavy_running >= scheduler.max_heavy) continue;
+        if (prev) prev->ready_next = s->ready_next;
+        else scheduler.ready_head = s->ready_next;
+        if (scheduler.ready_tail == s) scheduler.ready_tail = prev;
+        s->ready = 0;
+        return s;
+    }
+    return NULL;
+}
+
+// Lance une commande en arrière-plan sur une copie de la session courante
+void job_spawn(const char *command) {
+    while (*command == ' ' || *command == '\t') command++;
+    if (!*command) {
+        set_error("SPAWN requires a command");
+        return;
+    }
+    if (session->job) {
+        set_error("SPAWN: jobs cannot spawn jobs");
+        return;
+    }
+    if (sandbox_fd >= 0) {
+        sandbox_send('J', command, strlen(command)); // Lancé par le parent avec l'état final
+        return;
+    }
+    Job *job = calloc(1, sizeof(Job));
+    PendingCommand *pending = calloc(1, sizeof(PendingCommand));
+    Session *s = job && pending ? session_clone(session) : NULL;
+    if (!s) {
+        free(job);
+        free(pending);
+        set_error("SPAWN: Memory allocation failed");
+        return;
+    }
+    snprintf(job->nick, sizeof(job->nick), "%s", session->nick);
+    snprintf(job->command, sizeof(job->command), "%s", command);
+    snprintf(job->reply_to, sizeof(job->reply_to), "%s", reply_target);
+    job->network = reply_network;
+    job->session = s;
+    job->state = JOB_QUEUED;
+    job->submitted_us = now_us();
+    s->job = job;
+    s->heavy = 1; // Compte dans la limite des sessions lourdes dès le départ
+    snprintf(pending->nick, sizeof(pending->nick), "%s", session->nick);
+    snprintf(pending->command, sizeof(pending->command), "%s", command);
+    snprintf(pending->reply_to, sizeof(pending->reply_to), "%s", job->reply_to);
+    pending->network = job->network;
+    pending->enqueued_us = job->submitted_us;
+
+    pthread_mutex_lock(&scheduler.lock);
+    int total = 0, mine = 0;
+    for (Job *j = active_jobs; j; j = j->next) {
+        total++;
+        if (strcmp(j->nick, job->nick) == 0) mine++;
+    }
+    if (total >= MAX_ACTIVE_JOBS || mine >= MAX_JOBS_PER_NICK) {
+        pthread_mutex_unlock(&scheduler.lock);
+        session_destroy(s);
+        free(job);
+        free(pending);
+        char msg[128];
+        snprintf(msg, sizeof(msg), "SPAWN: too many jobs (%d per nick, %d in total)", MAX_JOBS_PER_NICK, MAX_ACTIVE_JOBS);
+        set_error(msg);
+        return;
+    }
+    long int id = job->id = next_job_id++;
+    job->next = active_jobs;
+    active_jobs = job;
+    pthread_mutex_unlock(&scheduler.lock);
+
+    // Annoncé avant de rendre le job prêt, pour précéder son résultat
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Job %ld started", id);
+    send_to_channel(msg);
+
+    pthread_mutex_lock(&scheduler.lock);
+    s->queue_head = s->queue_tail = pending;
+    scheduler.queued++;
+    scheduler_make_ready(s);
+    pthread_cond_signal(&scheduler.wakeup);
+    pthread_mutex_unlock(&scheduler.lock);
+}
+
+// Sortie d'un job : lignes jointes par " | ", tronquée à JOB_OUTPUT_MAX
+void job_capture(Job *job, const char *msg) {
+    if (!job->output) {
+        job->output = malloc(JOB_OUTPUT_MAX + 1);
+        if (!job->output) return;
+        job->output[0] = '\0';
+    }
+    size_t room = JOB_OUTPUT_MAX - job->output_len;
+    int written = snprintf(job->output + job->output_len, room + 1, "%s%s", job->output_len ? " | " : "", msg);
+    job->output_len += (size_t)written < room ? (size_t)written : room;
+}
+
+const char *job_state_name(JobState state) {
+    switch (state) {
+        case JOB_QUEUED: return "queued";
+        case JOB_RUNNING: return "running";
+        case JOB_DONE: return "done";
+        case JOB_FAILED: return "failed";
+        default: return "cancelled";
+    }
+}
+
+// Message « Job N (nick) done in X s: sortie », à libérer par l'appelant
+char *job_result_message(Job *job, JobState state) {
+    size_t size = JOB_OUTPUT_MAX + 256;
+    char *msg = malloc(size);
+    if (!msg) return NULL;
+    snprintf(msg, size, "Job %ld (%s) %s in %.2f s: %s", job->id, job->nick, job_state_name(state),
+             (job->finished_us - job->started_us) / 1e6, job->output ? job->output : "(no output)");
+    return msg;
+}
+
+// Fin d'un job, hors verrou : détruit sa session et publie le résultat
+JobState job_finish(Job *job) {
+    Session *s = job->session;
+    JobState state = atomic_load_explicit(&job->cancel, memory_order_relaxed) ? JOB_CANCELLED :
+                     s->error_flag ? JOB_FAILED : JOB_DONE;
+    job->finished_us = now_us();
+    job->session = NULL;
+    session_destroy(s);
+    char *msg = job_result_message(job, state);
+    if (msg) {
+        reply_target = job->reply_to; // Là où le job a été lancé
+        reply_network = job->network;
+        send_to_channel(msg);
+        reply_target = CHANNEL;
+        reply_network = 0;
+        free(msg);
+    }
+    return state;
+}
+
+// Range un job terminé dans l'anneau des résultats (verrou tenu)
+void job_archive(Job *job, JobState state) {
+    Job **link = &active_jobs;
+    while (*link && *link != job) link = &(*link)->next;
+    if (*link) *link = job->next;
+    job->state = state;
+    job->next = NULL;
+    Job *old = job_results[job_results_next];
+    if (old) {
+        free(old->output);
+        free(old);
+    }
+    job_results[job_results_next] = job;
+    job_results_next = (job_results_next + 1) % JOB_RESULTS;
+}
+
+// Thread de travail : prend une commande de la session suivante, l'exécute, la remet en fin de tour
+void *interpreter_worker(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&scheduler.lock);
+    while (1) {
+        scheduler_collect();
+        Session *s = scheduler_pick();
+        if (!s) {
+            pthread_cond_wait(&scheduler.wakeup, &scheduler.lock);
+            continue;
+        }
+        PendingCommand *command = s->queue_head;
+        s->queue_head = command->next;
+        if (!s->queue_head) s->queue_tail = NULL;
+        int heavy = s->heavy;
+        if (s->job) {
+            s->job->state = JOB_RUNNING;
+            s->job->started_us = now_us();
+        }
+        s->running = 1;
+        scheduler.running++;
+        scheduler.heavy_running += heavy;
+        scheduler.queued--;
+        long long wait_us = now_us() - command->enqueued_us;
+        scheduler.dispatched++;
+        scheduler.wait_total_us += wait_us;
+        scheduler.wait_last_us = wait_us;
+        if (wait_us > scheduler.wait_max_us) scheduler.wait_max_us = wait_us;
+        pthread_mutex_unlock(&scheduler.lock);
+
+        //printf("Executing: %s\n", command->command);
+        run_command(s, command);
+        if (command->counted) network_command_done(command->network);
+        free(command);
+        Job *job = s->job;
+        JobState job_state = job ? job_finish(job) : JOB_DONE; // Détruit la session du job
+
+        pthread_mutex_lock(&scheduler.lock);
+        scheduler.running--;
+        scheduler.heavy_running -= heavy;
+        if (job) {
+            job_archive(job, job_state);
+        } else {
+            s->running = 0;
+            if (s->queue_head) scheduler_make_ready(s);
+            session_evict();
+        }
+        pthread_cond_broadcast(&scheduler.wakeup); // Un créneau lourd ou une session a pu se libérer
+    }
+    return NULL;
+}
+
+int irc_open() {
+    struct addrinfo *server = network_resolve(&networks[0]); // Premier réseau de la configuration
+    if (!server) return -1;
+    int sock = socket(server->ai_family, SOCK_STREAM, 0);
+    if (sock < 0) {
+        printf("Socket creation failed\n");
+        freeaddrinfo(server);
+        return -1;
+    }
+
+    if (connect(sock, server->ai_addr, server->ai_addrlen) < 0) {
+        printf("Connection to %s failed\n", networks[0].name);
+        freeaddrinfo(server);
+        close(sock);
+        return -1;
+    }
+    freeaddrinfo(server);
+
+    char nick_cmd[512], user_cmd[512], join_cmd[512];
+    snprintf(nick_cmd, sizeof(nick_cmd), "NICK %s\r\n", networks[0].nick);
+    snprintf(user_cmd, sizeof(user_cmd), "USER %s 0 * :Forth IRC Bot\r\n", networks[0].nick);
+    snprintf(join_cmd, sizeof(join_cmd), "JOIN %s\r\n", networks[0].channel_count ? networks[0].channels[0] : CHANNEL);
+    send(sock, nick_cmd, strlen(nick_cmd), 0);
+    send(sock, user_cmd, strlen(user_cmd), 0);
+    send(sock, join_cmd, strlen(join_cmd), 0);
+    return sock;
+}
+
+void irc_connect(Stack *stack) {
+    int sock = irc_open();
+    if (sock < 0) return;
+    mpz_set_si(session->mpz_pool[0], sock);
+    push(stack, session->mpz_pool[0]);
+}
+
+ 
+int main() {
+    Stack *stack = &base_session.stack;
+    init_gmp_heap();
+    init_quotas();
+    init_vm_budget();
+    init_sessions();
+    init_sandbox();
+    init_result_cache();
+    init_outbound();
+    init_networks();
+    init_scheduler();
+    init_latency();
+    init_sampler();
+    initStack(stack);
+    init_mpz_pool();
+    char dp_cmd[] = "VARIABLE DP DROP";
+    interpret(dp_cmd, stack);
+    char base_cmd[] = "VARIABLE BASE DROP";
+    interpret(base_cmd, stack);
+    session->base_index = findMemoryIndex("BASE");
+    if (session->base_index >= 0) {
+        mpz_set_si(session->memory[session->base_index].values[0], 10);
+    }
+    int dp_idx = findMemoryIndex("DP");
+    if (dp_idx >= 0) {
+        mpz_set_si(session->memory[dp_idx].values[0], 0);
+    } else {
+        printf("DP non trouvé\n");
+    }
+    // Bibliothèque chargée dans l'image de base, partagée par toutes les sessions
+    char *prelude = getenv("FORTH_PRELUDE");
+    if (prelude) {
+        char load_cmd[MAX_STRING_SIZE + 16];
+        snprintf(load_cmd, sizeof(load_cmd), "LOAD \"%s\"", prelude);
+        interpret(load_cmd, stack);
+    }
+    stack->top = -1;
+    printf("Forth-like interpreter with GMP\n");
+    init_sandbox_helper(); // Avant tout thread et tout descripteur réseau
+    mpsc_init(&output_queue);
+    // SIGUSR1 bloqué avant les workers (ils en héritent) : seul le thread réseau le lit, par signalfd
+    sigset_t stats_signals;
+    sigemptyset(&stats_signals);
+    sigaddset(&stats_signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &stats_signals, NULL);
+    int stats_fd = signalfd(-1, &stats_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    pthread_t workers[MAX_WORKERS];
+    for (int i = 0; i < scheduler.workers; i++) {
+        if (pthread_create(&workers[i], NULL, interpreter_worker, NULL) != 0) {
+            printf("Failed to start worker thread %d\n", i);
+            return 1;
+        }
+    }
+    // Un seul thread pour tous les réseaux : epoll sur leurs descripteurs et sur le tube de réveil d'output_queue
+    int epfd = epoll_create1(0);
+    struct epoll_event wake = {.events = EPOLLIN, .data.u64 = WAKE_KEY};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, output_queue.wake[0], &wake);
+    struct epoll_event stats = {.events = EPOLLIN, .data.u64 = STATS_KEY};
+    if (stats_fd >= 0) epoll_ctl(epfd, EPOLL_CTL_ADD, stats_fd, &stats);
+    for (int i = 0; i < network_count; i++) networks[i].transport->open(epfd, &networks[i]);
+    while (!networks_finished()) {
+        struct epoll_event events[64];
+        int all_finished = 1;
+        for (int i = 0; i < network_count; i++) all_finished &= networks[i].finished;
+        int ready = epoll_wait(epfd, events, 64, all_finished ? 50 : network_timeout_ms()); // Fin du batch : attend les workers
+        for (int i = 0; i < ready; i++) {
+            uint64_t key = events[i].data.u64;
+            if (key == WAKE_KEY) {
+                char drain[64];
+                while (read(output_queue.wake[0], drain, sizeof(drain)) > 0);
+            } else if (key == STATS_KEY) {
+                struct signalfd_siginfo info;
+                while (read(stats_fd, &info, sizeof(info)) == sizeof(info));
+                latency_dump();
+            } else {
+                Network *net = &networks[key >> 32];
+                net->transport->event(epfd, net, (int)(key & 0xffffffff), events[i].events);
             }
         }
+        network_flush_output(epfd); // PONG et réponses sans attendre le tour suivant
     }
+    network_flush_output(epfd);
 
-    clearStack(&stack);
-    close(sock);
+    clearStack(stack);
+    close(epfd);
     clear_mpz_pool();
     return 0;
 }
\ No newline at end of file
@@ -2,6 +2,11 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/time.h>
 #include <gmp.h>
 
 #define STACK_SIZE 1000
@@ -12,6 +17,12 @@
 #define VAR_SIZE 100
 #define MAX_STRING_SIZE 256
 #define MPZ_POOL_SIZE 3
+#define VM_FRAMES 64                 // Puissance de deux ; au-delà, seuls les plus internes sont lus
+#define SAMPLE_STACKS 4096
+#define SAMPLE_NO_IP 0xffff
+#define SAMPLE_DEEPER (DICT_SIZE + 1)    // Pseudo-mots des piles échantillonnées
+#define SAMPLE_OUTSIDE (DICT_SIZE + 2)
+#define DEFAULT_SAMPLE_FILE "forth.folded"
 
 typedef enum {
     OP_PUSH, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_DUP, OP_SWAP, OP_OVER,
@@ -21,7 +32,8 @@ typedef enum {
     OP_EXIT, OP_BEGIN, OP_WHILE, OP_REPEAT,
     OP_BIT_AND, OP_BIT_OR, OP_BIT_XOR, OP_BIT_NOT, OP_LSHIFT, OP_RSHIFT,
     OP_WORDS, OP_FORGET, OP_VARIABLE, OP_FETCH, OP_STORE,
-    OP_PICK, OP_ROLL, OP_PLUSSTORE, OP_DEPTH, OP_TOP,OP_NIP, OP_MOD ,OP_SEE,OP_ALLOT,OP_CREATE // Inclut MOD
+    OP_PICK, OP_ROLL, OP_PLUSSTORE, OP_DEPTH, OP_TOP,OP_NIP, OP_MOD ,OP_SEE,OP_ALLOT,OP_CREATE, // Inclut MOD
+    OP_PROFILE_DUMP
 } OpCode;
 
 typedef struct {
@@ -95,6 +107,26 @@ long int current_word_index = -1;
 int error_flag = 0;
 mpz_t mpz_pool[MPZ_POOL_SIZE];
 
+// Échantillonneur SIGPROF : pile des mots en cours d'exécution, lue par le gestionnaire de signal
+typedef struct {
+    CompiledWord *word;
+    long int *ip;
+} VmFrame;
+
+typedef struct {
+    uint64_t hash;                   // 0 : libre
+    unsigned long count;
+    int depth;
+    uint32_t frames[VM_FRAMES + 1];  // (index du mot + 1) << 16 | ip, de la racine vers le mot interrompu
+} SampleStack;
+
+VmFrame vm_frames[VM_FRAMES];        // Anneau indexé par vm_depth
+volatile sig_atomic_t vm_depth = 0;
+int sample_hz = 0;
+char sample_file[256] = DEFAULT_SAMPLE_FILE;
+SampleStack sample_stacks[SAMPLE_STACKS];
+unsigned long sample_count = 0, sample_dropped = 0;
+
 void initStack(Stack *stack);
 void clearStack(Stack *stack);
 void push(Stack *stack, mpz_t value);
@@ -110,6 +142,8 @@ void executeCompiledWord(CompiledWord *word, Stack *stack);
 void addCompiledWord(char *name, Instruction *code, long int code_length, char **strings, long int string_count);
 void compileToken(char *token, char **input_rest);
 void interpret(char *input, Stack *stack);
+void init_sampler();
+void sample_dump();
 
 void initStack(Stack *stack) {
     stack->top = -1;
@@ -265,6 +299,7 @@ void print_word_definition(int index, Stack *stack) {
             case OP_DEPTH: snprintf(instr_str, sizeof(instr_str), "DEPTH "); break;
             case OP_TOP: snprintf(instr_str, sizeof(instr_str), "TOP "); break;
             case OP_SEE: snprintf(instr_str, sizeof(instr_str), "SEE "); break;
+            case OP_PROFILE_DUMP: snprintf(instr_str, sizeof(instr_str), "PROFILE-DUMP "); break;
             default: snprintf(instr_str, sizeof(instr_str), "(OP_%d) ", instr.opcode); break;
         }
         strncat(def_msg, instr_str, sizeof(def_msg) - strlen(def_msg) - 1);
@@ -760,6 +795,9 @@ case OP_STORE: // ! : [value index array -- ] ou [value array -- ]
                 set_error("TOP: Stack underflow");
             }
             break;
+        case OP_PROFILE_DUMP:
+            sample_dump();
+            break;
 case OP_SEE:
             pop(stack, *a);
             if (stack->top >= -1 && mpz_fits_slong_p(*a) && mpz_get_si(*a) >= 0 && mpz_get_si(*a) < dict_count) {
@@ -773,10 +811,109 @@ case OP_SEE:
 
 void executeCompiledWord(CompiledWord *word, Stack *stack) {
     long int ip = 0;
+    VmFrame *frame = &vm_frames[vm_depth & (VM_FRAMES - 1)];
+    frame->word = word;
+    frame->ip = &ip;
+    atomic_signal_fence(memory_order_release); // Cadre complet avant d'être visible par SIGPROF
+    vm_depth++;
     while (ip < word->code_length && !error_flag) {
         executeInstruction(word->code[ip], stack, &ip, word);
         ip++;
     }
+    vm_depth--;
+}
+
+// SIGPROF : index du mot et ip de chaque cadre ; les noms ne sont résolus qu'au PROFILE-DUMP
+void sample_tick(int sig) {
+    (void)sig;
+    int saved_errno = errno;
+    uint32_t frames[VM_FRAMES + 1];
+    int n = 0, depth = vm_depth;
+    int first = depth >= VM_FRAMES ? depth - VM_FRAMES + 1 : 0; // La case suivante peut être en cours d'écriture
+    if (first > 0) frames[n++] = SAMPLE_DEEPER << 16 | SAMPLE_NO_IP;
+    for (int i = first; i < depth; i++) {
+        VmFrame *frame = &vm_frames[i & (VM_FRAMES - 1)];
+        uint32_t id = frame->word >= dictionary && frame->word < dictionary + DICT_SIZE ? frame->word - dictionary + 1 : 0;
+        frames[n++] = id << 16 | (uint32_t)(*frame->ip < SAMPLE_NO_IP ? *frame->ip : SAMPLE_NO_IP - 1);
+    }
+    if (depth == 0) frames[n++] = SAMPLE_OUTSIDE << 16 | SAMPLE_NO_IP;
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; i < n; i++) hash = (hash ^ frames[i]) * 1099511628211ULL;
+    hash |= 1;
+    for (int i = 0; i < SAMPLE_STACKS; i++) {
+        SampleStack *entry = &sample_stacks[(hash + i) % SAMPLE_STACKS];
+        if (entry->hash == 0) {
+            memcpy(entry->frames, frames, n * sizeof(uint32_t));
+            entry->depth = n;
+            entry->hash = hash;
+        }
+        if (entry->hash == hash) {
+            entry->count++;
+            sample_count++;
+            errno = saved_errno;
+            return;
+        }
+    }
+    sample_dropped++;
+    errno = saved_errno;
+}
+
+// FORTH_SAMPLE_HZ : fréquence de SIGPROF en temps CPU (0, défaut : arrêté), FORTH_SAMPLE_FILE : sortie de PROFILE-DUMP
+void init_sampler() {
+    char *env = getenv("FORTH_SAMPLE_FILE");
+    if (env) snprintf(sample_file, sizeof(sample_file), "%s", env);
+    env = getenv("FORTH_SAMPLE_HZ");
+    if (env) sample_hz = atoi(env);
+    if (sample_hz <= 0) return;
+    if (sample_hz > 100000) sample_hz = 100000;
+    struct sigaction action = {0};
+    action.sa_handler = sample_tick;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+    long interval = 1000000L / sample_hz;
+    struct itimerval timer = {{interval / 1000000, interval % 1000000}, {interval / 1000000, interval % 1000000}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+// PROFILE-DUMP : une ligne "appelant+ip;...;mot+ip nombre" par pile, lisible par flamegraph.pl
+void sample_dump() {
+    if (sample_hz <= 0) {
+        set_error("PROFILE-DUMP: sampler is off, set FORTH_SAMPLE_HZ (e.g. 1000)");
+        return;
+    }
+    FILE *f = fopen(sample_file, "w");
+    if (!f) {
+        char msg[512];
+        snprintf(msg, sizeof(msg), "PROFILE-DUMP: cannot write %.200s: %s", sample_file, strerror(errno));
+        set_error(msg);
+        return;
+    }
+    sigset_t block, saved;
+    sigemptyset(&block);
+    sigaddset(&block, SIGPROF);
+    sigprocmask(SIG_BLOCK, &block, &saved); // Table figée pendant la lecture
+    long int lines = 0;
+    for (int i = 0; i < SAMPLE_STACKS; i++) {
+        SampleStack *entry = &sample_stacks[i];
+        if (!entry->hash) continue;
+        for (int j = 0; j < entry->depth; j++) {
+            uint32_t id = entry->frames[j] >> 16, ip = entry->frames[j] & 0xffff;
+            if (j) fputc(';', f);
+            if (id == 0) fputs("(interactive)", f);
+            else if (id == SAMPLE_DEEPER) fputs("(deeper)", f);
+            else if (id == SAMPLE_OUTSIDE) fputs("(interpreter)", f);
+            else if (id <= dict_count && dictionary[id - 1].name) fputs(dictionary[id - 1].name, f);
+            else fprintf(f, "#%u", id - 1); // Mot oublié depuis
+            if (ip != SAMPLE_NO_IP) fprintf(f, "+%u", ip);
+        }
+        fprintf(f, " %lu\n", entry->count);
+        lines++;
+    }
+    unsigned long samples = sample_count, dropped = sample_dropped;
+    sigprocmask(SIG_SETMASK, &saved, NULL);
+    fclose(f);
+    printf("%ld stacks, %lu samples (FORTH_SAMPLE_HZ=%d, %lu dropped) written to %s\n", lines, samples, sample_hz, dropped, sample_file);
 }
 
 void addCompiledWord(char *name, Instruction *code, long int code_length, char **strings, long int string_count) {
@@ -1016,6 +1153,9 @@ void compileToken(char *token, char **input_rest) {
     } else if (strcmp(token, "WORDS") == 0) {
         instr.opcode = OP_WORDS;
         currentWord.code[currentWord.code_length++] = instr;
+    } else if (strcmp(token, "PROFILE-DUMP") == 0) {
+        instr.opcode = OP_PROFILE_DUMP;
+        currentWord.code[currentWord.code_length++] = instr;
     } else if (strcmp(token, "FORGET") == 0) {
         char *next_token = strtok_r(NULL, " \t\n", input_rest);
         if (!next_token) {
@@ -1313,6 +1453,10 @@ void interpret(char *input, Stack *stack) {
                 temp.code_length = 1;
                 temp.code[0] = (Instruction){OP_WORDS, 0};
                 executeCompiledWord(&temp, stack);
+            } else if (strcmp(token, "PROFILE-DUMP") == 0) {
+                temp.code_length = 1;
+                temp.code[0] = (Instruction){OP_PROFILE_DUMP, 0};
+                executeCompiledWord(&temp, stack);
             } else if (strcmp(token, "FORGET") == 0) {
                 char *next_token = strtok_r(NULL, " \t\n", &saveptr);
                 if (!next_token) {
@@ -1419,6 +1563,7 @@ int main() {
     Stack stack;
     initStack(&stack);
     init_mpz_pool();
+    init_sampler();
     char input[256];
     int suppress_stack_print = 0;
     printf("Forth-like interpreter with GMP\n");
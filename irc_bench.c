@@ -0,0 +1,691 @@
+// Banc d'essai du bot sans labynet.fr : un serveur IRC minimal et un générateur de charge.
+//
+//   irc_bench server [-p PORT] [-b BOT] [-f PAS_MS,LIMITE_MS]
+//   irc_bench load [-h HÔTE] [-p PORT] [-b BOT] [-u UTILISATEURS] [-n COMMANDES] [-m MÉLANGE]
+//   irc_bench ping [-p PORT] [-b BOT] [-s SECONDES]
+//
+// Le serveur connaît NICK, USER, JOIN, PRIVMSG, PING et QUIT. Seul BOT est soumis à l'anti-flood, comme
+// sur un ircd : chaque ligne ajoute PAS_MS à son compteur de pénalité, au-delà de LIMITE_MS d'avance il
+// est déconnecté (« Excess Flood »). Le générateur connecte UTILISATEURS faux pseudos qui rejouent en
+// boucle les lignes du MÉLANGE en message privé au bot, une commande en attente chacun, et mesure le
+// délai jusqu'à la réponse : histogramme, percentiles et débit. En mode ping, le banc est le serveur du
+// seul bot : il lui fait lancer une boucle sans fin, arrêtée par son budget (FORTH_MAX_MILLISECONDS d'au
+// moins SECONDES, FORTH_MAX_INSTRUCTIONS=0), lui envoie un PING toutes les 500 ms pendant le calcul et
+// échoue si un PONG met 100 ms ou plus.
+//
+// Compilation : gcc -O2 -o irc_bench irc_bench.c
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#define MAX_CLIENTS 1024
+#define MAX_CHANNELS 32
+#define LINE_MAX_BYTES 8192
+#define MAX_MIX 256
+#define HIST_BUCKETS 512                 // 8 sous-intervalles par puissance de deux de microsecondes
+#define REPLY_TIMEOUT_SECONDS 30
+#define PING_PERIOD_MS 500
+#define PONG_LIMIT_US 100000             // Au-delà, le calcul bloque le thread réseau
+
+typedef struct {
+    int fd;
+    char nick[32];
+    int has_user, welcomed;
+    unsigned long joined;                // Bit i : membre de channels[i]
+    char in[LINE_MAX_BYTES];
+    size_t in_len;
+    char *out;
+    size_t out_len, out_cap;
+    long long penalty_us;                // Anti-flood : date jusqu'à laquelle les lignes sont « payées »
+    long lines_in, lines_out;
+} Client;
+
+Client *clients[MAX_CLIENTS];
+char channels[MAX_CHANNELS][64];
+int channel_count;
+volatile sig_atomic_t stop;
+
+long long now_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+int set_nonblocking(int fd) {
+    return fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Ajoute une ligne (CRLF ajouté) à la sortie d'un client ; écrite par client_flush
+void client_send(Client *c, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void client_send(Client *c, const char *fmt, ...) {
+    char line[LINE_MAX_BYTES + 2];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line) - 2, fmt, args);
+    va_end(args);
+    if (len < 0) return;
+    if (len > (int)sizeof(line) - 3) len = sizeof(line) - 3;
+    memcpy(line + len, "\r\n", 2);
+    len += 2;
+    if (c->out_len + len > c->out_cap) {
+        size_t cap = c->out_cap ? c->out_cap * 2 : 4096;
+        while (cap < c->out_len + len) cap *= 2;
+        char *out = realloc(c->out, cap);
+        if (!out) return;
+        c->out = out;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, line, len);
+    c->out_len += len;
+    c->lines_out++;
+}
+
+// 0 : erreur d'écriture, le client est à fermer
+int client_flush(Client *c) {
+    size_t done = 0;
+    while (done < c->out_len) {
+        ssize_t sent = send(c->fd, c->out + done, c->out_len - done, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (sent <= 0) return 0;
+        done += sent;
+    }
+    memmove(c->out, c->out + done, c->out_len - done);
+    c->out_len -= done;
+    return 1;
+}
+
+// ---- Serveur ----
+
+typedef struct {
+    const char *bot;
+    long long step_us, limit_us;         // step_us = 0 : pas d'anti-flood
+    long excess_floods;
+} ServerConfig;
+
+ServerConfig server_config = {"forth", 0, 0, 0};
+
+Client *find_nick(const char *nick) {
+    for (int i = 0; i < MAX_CLIENTS; i++) {
+        if (clients[i] && strcasecmp(clients[i]->nick, nick) == 0) return clients[i];
+    }
+    return NULL;
+}
+
+int find_channel(const char *name, int create) {
+    for (int i = 0; i < channel_count; i++) {
+        if (strcasecmp(channels[i], name) == 0) return i;
+    }
+    if (!create || channel_count >= MAX_CHANNELS) return -1;
+    snprintf(channels[channel_count], sizeof(channels[0]), "%s", name);
+    return channel_count++;
+}
+
+void server_close(int epfd, int slot, const char *reason) {
+    Client *c = clients[slot];
+    if (reason) {
+        client_send(c, "ERROR :Closing Link: %s (%s)", c->nick[0] ? c->nick : "*", reason);
+        client_flush(c);
+    }
+    if (c->nick[0]) {
+        fprintf(stderr, "%s left: %ld lines in, %ld lines out%s%s\n", c->nick, c->lines_in, c->lines_out,
+                reason ? ", " : "", reason ? reason : "");
+    }
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    free(c->out);
+    free(c);
+    clients[slot] = NULL;
+}
+
+// Une ligne d'un client, sans CRLF ; 0 si le client doit être fermé
+int server_line(Client *c, char *line) {
+    if (line[0] == ':') { // Préfixe envoyé par le client : ignoré
+        line = strchr(line, ' ');
+        if (!line) return 1;
+        while (*line == ' ') line++;
+    }
+    char *trailing = strstr(line, " :");
+    if (trailing) {
+        *trailing = '\0';
+        trailing += 2;
+    }
+    char *saveptr;
+    char *command = strtok_r(line, " ", &saveptr);
+    char *arg = strtok_r(NULL, " ", &saveptr);
+    if (!command) return 1;
+    if (!arg && trailing) {
+        arg = trailing;
+        trailing = NULL;
+    }
+    if (strcasecmp(command, "NICK") == 0 && arg) {
+        Client *other = find_nick(arg);
+        if (other && other != c) {
+            client_send(c, ":bench 433 * %s :Nickname is already in use", arg);
+            return 1;
+        }
+        snprintf(c->nick, sizeof(c->nick), "%s", arg);
+    } else if (strcasecmp(command, "USER") == 0) {
+        c->has_user = 1;
+    } else if (strcasecmp(command, "PING") == 0) {
+        client_send(c, ":bench PONG bench :%s", trailing ? trailing : arg ? arg : "");
+    } else if (strcasecmp(command, "QUIT") == 0) {
+        return 0;
+    } else if (strcasecmp(command, "JOIN") == 0 && arg && c->welcomed) {
+        char *next;
+        for (char *name = strtok_r(arg, ",", &next); name; name = strtok_r(NULL, ",", &next)) {
+            int channel = find_channel(name, 1);
+            if (channel < 0) continue;
+            c->joined |= 1UL << channel;
+            for (int i = 0; i < MAX_CLIENTS; i++) {
+                if (clients[i] && (clients[i]->joined >> channel & 1)) {
+                    client_send(clients[i], ":%s!u@bench JOIN %s", c->nick, name);
+                }
+            }
+        }
+    } else if (strcasecmp(command, "PRIVMSG") == 0 && arg && c->welcomed) {
+        const char *text = trailing ? trailing : "";
+        if (arg[0] == '#') {
+            int channel = find_channel(arg, 0);
+            for (int i = 0; channel >= 0 && i < MAX_CLIENTS; i++) {
+                if (clients[i] && clients[i] != c && (clients[i]->joined >> channel & 1)) {
+                    client_send(clients[i], ":%s!u@bench PRIVMSG %s :%s", c->nick, arg, text);
+                }
+            }
+        } else {
+            Client *target = find_nick(arg);
+            if (target) client_send(target, ":%s!u@bench PRIVMSG %s :%s", c->nick, arg, text);
+            else client_send(c, ":bench 401 %s %s :No such nick", c->nick, arg);
+        }
+    }
+    if (!c->welcomed && c->nick[0] && c->has_user) {
+        c->welcomed = 1;
+        client_send(c, ":bench 001 %s :Welcome to the bench network", c->nick);
+    }
+    return 1;
+}
+
+// Lignes reçues d'un client ; 0 si le client doit être fermé, *reason expliquant pourquoi
+int server_read(Client *c, const char **reason) {
+    while (1) {
+        ssize_t bytes = recv(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len, 0);
+        if (bytes < 0 && errno == EINTR) continue;
+        if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+        if (bytes <= 0) return 0;
+        c->in_len += bytes;
+        char *start = c->in, *newline;
+        while ((newline = memchr(start, '\n', c->in + c->in_len - start))) {
+            *newline = '\0';
+            if (newline > start && newline[-1] == '\r') newline[-1] = '\0';
+            c->lines_in++;
+            if (server_config.step_us && strcasecmp(c->nick, server_config.bot) == 0) {
+                long long now = now_us();
+                if (c->penalty_us < now) c->penalty_us = now;
+                c->penalty_us += server_config.step_us;
+                if (c->penalty_us - now > server_config.limit_us) {
+                    server_config.excess_floods++;
+                    *reason = "Excess Flood";
+                    return 0;
+                }
+            }
+            if (!server_line(c, start)) return 0;
+            start = newline + 1;
+        }
+        c->in_len -= start - c->in;
+        memmove(c->in, start, c->in_len);
+        if (c->in_len == sizeof(c->in)) c->in_len = 0; // Ligne trop longue : jetée
+    }
+}
+
+// Socket d'écoute non bloquant sur PORT ; -1 en cas d'échec
+int listen_on(int port) {
+    int listener = socket(AF_INET6, SOCK_STREAM, 0);
+    int on = 1, off = 0;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(listener, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof(off)); // IPv4 et IPv6
+    struct sockaddr_in6 addr = {.sin6_family = AF_INET6, .sin6_port = htons(port), .sin6_addr = IN6ADDR_ANY_INIT};
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listener, SOMAXCONN) < 0) {
+        fprintf(stderr, "Cannot listen on port %d: %s\n", port, strerror(errno));
+        if (listener >= 0) close(listener);
+        return -1;
+    }
+    set_nonblocking(listener);
+    return listener;
+}
+
+int run_server(int port) {
+    int listener = listen_on(port);
+    if (listener < 0) return 1;
+    int on = 1;
+    int epfd = epoll_create1(0);
+    struct epoll_event ev = {.events = EPOLLIN, .data.u32 = MAX_CLIENTS};
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &ev);
+    fprintf(stderr, "Listening on port %d (flood limit for %s: %s)\n", port, server_config.bot,
+            server_config.step_us ? "on" : "off");
+    while (!stop) {
+        struct epoll_event events[64];
+        int ready = epoll_wait(epfd, events, 64, 1000);
+        for (int i = 0; i < ready; i++) {
+            unsigned int slot = events[i].data.u32;
+            if (slot == MAX_CLIENTS) {
+                int fd;
+                while ((fd = accept(listener, NULL, NULL)) >= 0) {
+                    int free_slot = 0;
+                    while (free_slot < MAX_CLIENTS && clients[free_slot]) free_slot++;
+                    Client *c = free_slot < MAX_CLIENTS ? calloc(1, sizeof(Client)) : NULL;
+                    if (!c) {
+                        close(fd);
+                        continue;
+                    }
+                    set_nonblocking(fd);
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                    c->fd = fd;
+                    clients[free_slot] = c;
+                    struct epoll_event client_ev = {.events = EPOLLIN, .data.u32 = free_slot};
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &client_ev);
+                }
+                continue;
+            }
+            Client *c = clients[slot];
+            if (!c) continue;
+            const char *reason = NULL;
+            if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !server_read(c, &reason)) {
+                server_close(epfd, slot, reason);
+            }
+        }
+        for (int slot = 0; slot < MAX_CLIENTS; slot++) { // Sorties produites par ce tour, tous clients confondus
+            Client *c = clients[slot];
+            if (!c) continue;
+            if (!client_flush(c)) {
+                server_close(epfd, slot, NULL);
+                continue;
+            }
+            struct epoll_event client_ev = {.events = EPOLLIN | (c->out_len ? EPOLLOUT : 0), .data.u32 = slot};
+            epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &client_ev);
+        }
+    }
+    fprintf(stderr, "Excess floods: %ld\n", server_config.excess_floods);
+    return 0;
+}
+
+// ---- Générateur de charge ----
+
+typedef struct {
+    Client conn;
+    int mix_pos;
+    long long sent_us;                   // 0 : pas de commande en attente
+    long seq;
+} User;
+
+typedef struct {
+    long long counts[HIST_BUCKETS];
+    long long total, max_us, sum_us;
+} Histogram;
+
+// Intervalles log-linéaires : précision de 12,5 % sur toute la plage
+int hist_bucket(long long us) {
+    if (us < 8) return (int)us;
+    int exp = 63 - __builtin_clzll((unsigned long long)us);
+    int bucket = (exp - 2) * 8 + (int)((us >> (exp - 3)) & 7);
+    return bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1;
+}
+
+long long hist_lower(int bucket) {
+    if (bucket < 8) return bucket;
+    int exp = bucket / 8 + 2;
+    return (8LL + bucket % 8) << (exp - 3);
+}
+
+void hist_add(Histogram *h, long long us) {
+    h->counts[hist_bucket(us)]++;
+    h->total++;
+    h->sum_us += us;
+    if (us > h->max_us) h->max_us = us;
+}
+
+long long hist_percentile(const Histogram *h, double p) {
+    long long rank = (long long)(p * h->total), seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen > rank) return hist_lower(i + 1) - 1 < h->max_us ? hist_lower(i + 1) - 1 : h->max_us;
+    }
+    return h->max_us;
+}
+
+void hist_report(const Histogram *h) {
+    if (!h->total) return;
+    printf("latency: avg %.0f us, p50 %lld us, p90 %lld us, p99 %lld us, p99.9 %lld us, max %lld us\n",
+           (double)h->sum_us / h->total, hist_percentile(h, 0.5), hist_percentile(h, 0.9),
+           hist_percentile(h, 0.99), hist_percentile(h, 0.999), h->max_us);
+    long long peak = 0, rows[64] = {0};
+    for (int i = 0; i < HIST_BUCKETS; i++) rows[63 - __builtin_clzll((unsigned long long)hist_lower(i) | 1)] += h->counts[i];
+    for (int r = 0; r < 64; r++) if (rows[r] > peak) peak = rows[r];
+    for (int r = 0; r < 64; r++) {
+        if (!rows[r]) continue;
+        int bar = (int)(rows[r] * 50 / peak);
+        printf("%10lld us %8lld |%.*s\n", 1LL << r, rows[r], bar, "##################################################");
+    }
+}
+
+const char *default_mix[] = {
+    "2 3 + .",
+    ": SQ DUP * ;",
+    "12345678901234567890 SQ .",
+    ": FACT 1 SWAP 1 + 1 DO I * LOOP ;",
+    "30 FACT .",
+    "500 FACT DROP",
+    ": TRI 0 SWAP 0 DO I + LOOP ;",
+    "1000 TRI .",
+    "1 64 LSHIFT 1 - .",
+};
+
+char *mix[MAX_MIX];
+int mix_count;
+
+int load_mix(const char *path) {
+    if (!path) {
+        for (size_t i = 0; i < sizeof(default_mix) / sizeof(default_mix[0]); i++) mix[mix_count++] = strdup(default_mix[i]);
+        return 1;
+    }
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot open mix file %s\n", path);
+        return 0;
+    }
+    char line[512];
+    while (mix_count < MAX_MIX && fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] && line[0] != '#') mix[mix_count++] = strdup(line);
+    }
+    fclose(file);
+    return mix_count > 0;
+}
+
+int connect_to(const char *host, int port) {
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM}, *result;
+    char service[8];
+    snprintf(service, sizeof(service), "%d", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0) return -1;
+    int fd = socket(result->ai_family, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) < 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+// Commande suivante du mélange (chacun part du début : les définitions précèdent leur usage), suivie d'un marqueur ." @N" qui signale la fin de la réponse
+void user_send(User *u, const char *bot) {
+    u->seq++;
+    client_send(&u->conn, "PRIVMSG %s :%s .\" @%ld\"", bot, mix[u->mix_pos], u->seq);
+    u->mix_pos = (u->mix_pos + 1) % mix_count;
+    u->sent_us = now_us();
+}
+
+typedef struct {
+    long done, errors, busy;
+} LoadStats;
+
+// Une ligne reçue par un faux utilisateur ; 1 si la commande en attente est terminée
+int user_line(User *u, char *line, const char *bot, LoadStats *stats) {
+    if (strstr(line, " 001 ")) {
+        u->conn.welcomed = 1;
+        return 0;
+    }
+    if (strstr(line, " 401 ")) {
+        fprintf(stderr, "Bot %s is not connected to the server\n", bot);
+        exit(1);
+    }
+    char *text = strstr(line, " PRIVMSG ");
+    if (!text || !u->sent_us || !(text = strstr(text, " :"))) return 0;
+    text += 2;
+    char marker[32];
+    snprintf(marker, sizeof(marker), "@%ld", u->seq);
+    size_t len = strlen(text), marker_len = strlen(marker);
+    while (len > 0 && text[len - 1] == ' ') len--;
+    if (len >= marker_len && memcmp(text + len - marker_len, marker, marker_len) == 0) return 1;
+    if (strncmp(text, "Execution aborted", 17) == 0) {
+        stats->errors++;
+        return 1;
+    }
+    if (strncmp(text, "Busy:", 5) == 0) {
+        stats->busy++;
+        return 1;
+    }
+    return 0;
+}
+
+int run_load(const char *host, int port, const char *bot, int user_count, long commands, const char *mix_path) {
+    if (!load_mix(mix_path)) return 1;
+    User *users = calloc(user_count, sizeof(User));
+    int epfd = epoll_create1(0);
+    for (int i = 0; i < user_count; i++) {
+        User *u = &users[i];
+        u->conn.fd = connect_to(host, port);
+        if (u->conn.fd < 0) {
+            fprintf(stderr, "Cannot connect to %s:%d\n", host, port);
+            return 1;
+        }
+        int on = 1;
+        setsockopt(u->conn.fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        set_nonblocking(u->conn.fd);
+        snprintf(u->conn.nick, sizeof(u->conn.nick), "user%d", i);
+        client_send(&u->conn, "NICK %s", u->conn.nick);
+        client_send(&u->conn, "USER %s 0 * :load generator", u->conn.nick);
+        struct epoll_event ev = {.events = EPOLLIN, .data.u32 = i};
+        epoll_ctl(epfd, EPOLL_CTL_ADD, u->conn.fd, &ev);
+        client_flush(&u->conn);
+    }
+    Histogram hist = {0};
+    LoadStats stats = {0};
+    long sent = 0;
+    long long start_us = 0, last_reply_us = now_us();
+    while (!stop && stats.done < commands) {
+        struct epoll_event events[64];
+        int ready = epoll_wait(epfd, events, 64, 1000);
+        long long now = now_us();
+        for (int i = 0; i < ready; i++) {
+            User *u = &users[events[i].data.u32];
+            ssize_t bytes = recv(u->conn.fd, u->conn.in + u->conn.in_len, sizeof(u->conn.in) - u->conn.in_len, 0);
+            if (bytes < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            if (bytes <= 0) {
+                fprintf(stderr, "%s: connection closed by server\n", u->conn.nick);
+                return 1;
+            }
+            u->conn.in_len += bytes;
+            char *begin = u->conn.in, *newline;
+            while ((newline = memchr(begin, '\n', u->conn.in + u->conn.in_len - begin))) {
+                *newline = '\0';
+                if (newline > begin && newline[-1] == '\r') newline[-1] = '\0';
+                if (strncmp(begin, "PING ", 5) == 0) client_send(&u->conn, "PONG %s", begin + 5);
+                if (user_line(u, begin, bot, &stats)) {
+                    hist_add(&hist, now - u->sent_us);
+                    u->sent_us = 0;
+                    stats.done++;
+                    last_reply_us = now;
+                }
+                begin = newline + 1;
+            }
+            u->conn.in_len -= begin - u->conn.in;
+            memmove(u->conn.in, begin, u->conn.in_len);
+            if (u->conn.in_len == sizeof(u->conn.in)) u->conn.in_len = 0;
+        }
+        int welcomed = 0;
+        for (int i = 0; i < user_count; i++) welcomed += users[i].conn.welcomed;
+        if (welcomed == user_count) {
+            if (!start_us) start_us = last_reply_us = now_us();
+            for (int i = 0; i < user_count && sent < commands; i++) {
+                if (!users[i].sent_us) {
+                    user_send(&users[i], bot);
+                    sent++;
+                }
+            }
+        }
+        for (int i = 0; i < user_count; i++) client_flush(&users[i].conn);
+        if (start_us && now_us() - last_reply_us > REPLY_TIMEOUT_SECONDS * 1000000LL) {
+            fprintf(stderr, "No reply for %d s, giving up (bot killed for flooding?)\n", REPLY_TIMEOUT_SECONDS);
+            break;
+        }
+    }
+    double seconds = start_us ? (now_us() - start_us) / 1e6 : 0;
+    printf("%ld commands from %d users in %.2f s: %.1f commands/s, %ld errors, %ld busy\n", stats.done, user_count,
+           seconds, seconds > 0 ? stats.done / seconds : 0.0, stats.errors, stats.busy);
+    hist_report(&hist);
+    return stats.done < commands;
+}
+
+// ---- PING pendant un calcul ----
+
+// Ligne suivante du bot, sans CRLF, copiée dans line ; 0 si rien n'arrive avant deadline_us ou si la connexion tombe
+int bot_line(Client *c, char *line, size_t size, long long deadline_us) {
+    while (1) {
+        char *newline = memchr(c->in, '\n', c->in_len);
+        if (newline) {
+            size_t len = newline - c->in;
+            size_t keep = len > 0 && c->in[len - 1] == '\r' ? len - 1 : len;
+            if (keep >= size) keep = size - 1;
+            memcpy(line, c->in, keep);
+            line[keep] = '\0';
+            c->in_len -= len + 1;
+            memmove(c->in, newline + 1, c->in_len);
+            return 1;
+        }
+        if (c->in_len == sizeof(c->in)) c->in_len = 0; // Ligne trop longue : jetée
+        long long wait_us = deadline_us - now_us();
+        struct pollfd pfd = {.fd = c->fd, .events = POLLIN};
+        if (wait_us <= 0 || poll(&pfd, 1, (int)((wait_us + 999) / 1000)) <= 0) return 0;
+        ssize_t bytes = recv(c->fd, c->in + c->in_len, sizeof(c->in) - c->in_len, 0);
+        if (bytes < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (bytes <= 0) return 0;
+        c->in_len += bytes;
+    }
+}
+
+int run_ping(int port, const char *bot, int seconds) {
+    int listener = listen_on(port);
+    if (listener < 0) return 1;
+    struct pollfd pfd = {.fd = listener, .events = POLLIN};
+    Client c = {.fd = -1};
+    if (poll(&pfd, 1, REPLY_TIMEOUT_SECONDS * 1000) > 0) c.fd = accept(listener, NULL, NULL);
+    close(listener);
+    if (c.fd < 0) {
+        fprintf(stderr, "Bot %s did not connect to port %d\n", bot, port);
+        return 1;
+    }
+    int on = 1;
+    setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    char line[LINE_MAX_BYTES];
+    long long deadline = now_us() + REPLY_TIMEOUT_SECONDS * 1000000LL;
+    while (!c.welcomed && bot_line(&c, line, sizeof(line), deadline)) { // NICK et USER, puis 001
+        server_line(&c, line);
+        client_flush(&c);
+    }
+    if (!c.welcomed) {
+        fprintf(stderr, "Bot %s did not register\n", bot);
+        return 1;
+    }
+    client_send(&c, ":bench!u@bench PRIVMSG %s :: SPIN BEGIN 1 WHILE REPEAT ; SPIN", bot);
+    client_flush(&c);
+    long long start_us = now_us(), finished_us = 0;
+    Histogram hist = {0};
+    int late = 0;
+    for (int probe = 1; !stop && !finished_us && (long long)(probe + 1) * PING_PERIOD_MS * 1000 < seconds * 1000000LL; probe++) {
+        // Le temps qui reste avant le prochain PING : seules les réponses au calcul sont attendues
+        while (!finished_us && bot_line(&c, line, sizeof(line), start_us + (long long)probe * PING_PERIOD_MS * 1000)) {
+            if (strncmp(line, "PRIVMSG bench ", 14) == 0) finished_us = now_us();
+        }
+        if (finished_us) break;
+        char token[32];
+        snprintf(token, sizeof(token), "probe%d", probe);
+        client_send(&c, "PING :%s", token);
+        long long sent_us = now_us();
+        client_flush(&c);
+        int answered = 0;
+        while (!answered && bot_line(&c, line, sizeof(line), sent_us + 10 * PONG_LIMIT_US)) {
+            if (strncmp(line, "PONG ", 5) == 0 && strstr(line, token)) answered = 1;
+            else if (strncmp(line, "PRIVMSG bench ", 14) == 0) finished_us = now_us();
+        }
+        long long us = now_us() - sent_us;
+        if (finished_us) break; // Calcul fini pendant la mesure : elle ne prouve plus rien
+        hist_add(&hist, us);
+        if (!answered || us >= PONG_LIMIT_US) {
+            fprintf(stderr, "PING %s: %s after %lld us\n", token, answered ? "PONG" : "no PONG", us);
+            late++;
+        }
+    }
+    int early = finished_us != 0;
+    while (!finished_us && bot_line(&c, line, sizeof(line), start_us + (seconds + REPLY_TIMEOUT_SECONDS) * 1000000LL)) {
+        if (strncmp(line, "PRIVMSG bench ", 14) == 0) finished_us = now_us();
+    }
+    close(c.fd);
+    double computed = finished_us ? (finished_us - start_us) / 1e6 : 0;
+    printf("%lld PINGs during a %.1f s computation: max %lld us, p50 %lld us, %d at or over %d ms\n", hist.total,
+           computed, hist.max_us, hist_percentile(&hist, 0.5), late, PONG_LIMIT_US / 1000);
+    if (early || !finished_us) {
+        fprintf(stderr, "The computation %s (budget FORTH_MAX_MILLISECONDS of at least %d s, FORTH_MAX_INSTRUCTIONS=0?)\n",
+                early ? "ended before the last PING" : "never ended", seconds);
+        return 1;
+    }
+    return late > 0 || hist.total == 0;
+}
+
+void usage() {
+    fprintf(stderr, "usage: irc_bench server [-p PORT] [-b BOT] [-f STEP_MS,LIMIT_MS]\n"
+                    "       irc_bench load [-h HOST] [-p PORT] [-b BOT] [-u USERS] [-n COMMANDS] [-m MIX_FILE]\n"
+                    "       irc_bench ping [-p PORT] [-b BOT] [-s SECONDS]\n");
+    exit(2);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) usage();
+    const char *host = "localhost", *mix_path = NULL;
+    int port = 6667, users = 4, seconds = 10;
+    long commands = 1000;
+    for (int i = 2; i < argc; i++) {
+        if (i + 1 >= argc) usage();
+        const char *opt = argv[i], *value = argv[++i];
+        if (strcmp(opt, "-p") == 0) port = atoi(value);
+        else if (strcmp(opt, "-h") == 0) host = value;
+        else if (strcmp(opt, "-b") == 0) server_config.bot = value;
+        else if (strcmp(opt, "-u") == 0) users = atoi(value);
+        else if (strcmp(opt, "-n") == 0) commands = atol(value);
+        else if (strcmp(opt, "-m") == 0) mix_path = value;
+        else if (strcmp(opt, "-s") == 0) seconds = atoi(value);
+        else if (strcmp(opt, "-f") == 0) {
+            long step_ms = 0, limit_ms = 0;
+            if (sscanf(value, "%ld,%ld", &step_ms, &limit_ms) != 2) usage();
+            server_config.step_us = step_ms * 1000;
+            server_config.limit_us = limit_ms * 1000;
+        } else {
+            usage();
+        }
+    }
+    if (users < 1 || users > MAX_CLIENTS || port <= 0 || seconds < 1) usage();
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+    if (strcmp(argv[1], "server") == 0) return run_server(port);
+    if (strcmp(argv[1], "load") == 0) return run_load(host, port, server_config.bot, users, commands, mix_path);
+    if (strcmp(argv[1], "ping") == 0) return run_ping(port, server_config.bot, seconds);
+    usage();
+    return 2;
+}
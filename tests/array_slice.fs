@@ -0,0 +1,47 @@
+CREATE A DROP
+A 8 ALLOT
+: INIT 8 0 DO I 1 + I A ! LOOP ;
+INIT
+A SUM .
+A 2 3 SLICE SUM .
+A 2 3 SLICE MINMAX . .
+A 0 8 SLICE PREFIX-SUM
+A SUM .
+A 1 4 SLICE REVERSE
+0 A @ . 1 A @ . 2 A @ . 3 A @ . 4 A @ . 5 A @ .
+INIT
+A 0 A 2 5 SLICE COPY
+0 A @ . 1 A @ . 2 A @ . 3 A @ . 4 A @ . 5 A @ . 6 A @ . 7 A @ .
+INIT
+A 3 A 0 4 SLICE COPY
+0 A @ . 1 A @ . 2 A @ . 3 A @ .
+INIT
+A 0 A 4 4 SLICE DOT .
+9 A 6 2 SLICE FILL
+A SUM .
+: SQ DUP * ;
+A 0 3 SLICE MAP SQ
+A 0 3 SLICE REDUCE + .
+A 7 2 SLICE SUM
+A -1 2 SLICE SUM
+A 0 -1 SLICE SUM
+A 0 0 SLICE MINMAX
+A 8 0 SLICE SUM .
+SLICE DUP
+SLICE MAP
+: T A 1 2 SLICE REDUCE * ;
+T .
+SEE T
+CREATE C DROP
+C 5 CELLS-ALLOT
+: CI 5 0 DO I 10 * I C ! LOOP ;
+CI
+C 1 3 SLICE SUM .
+C 1 3 SLICE MINMAX . .
+C 0 C 1 4 SLICE COPY
+C SUM .
+C 2 2 SLICE REVERSE
+C 0 5 SLICE PREFIX-SUM
+C SUM .
+A 0 C 0 5 SLICE DOT .
+.S
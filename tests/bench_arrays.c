@@ -0,0 +1,93 @@
+// Banc des mots de tableau : chaque mot natif contre la boucle DO équivalente, sur ALLOT (GMP) et CELLS-ALLOT (int64).
+// gcc -O2 -o bench_arrays tests/bench_arrays.c -lgmp -lpthread && ./bench_arrays [N]
+// Les deux versions partent des mêmes tableaux et doivent laisser la même pile et le même contenu de A.
+#include "unit.h"
+
+typedef struct {
+    const char *name;
+    const char *native;
+    const char *loop;    // Corps d'une définition, %1$ld : N, %2$ld : N / 2
+} BenchCase;
+
+static const BenchCase cases[] = {
+    {"FILL", "7 A FILL", "%1$ld 0 DO 7 I A ! LOOP"},
+    {"SUM", "A SUM", "0 %1$ld 0 DO I A @ + LOOP"},
+    {"SLICE SUM", "A %2$ld %2$ld SLICE SUM", "0 %1$ld %2$ld DO I A @ + LOOP"},
+    {"DOT", "A B DOT", "0 %1$ld 0 DO I A @ I B @ * + LOOP"},
+    {"PREFIX-SUM", "A PREFIX-SUM", "%1$ld 1 DO I 1 - A @ I A @ + I A ! LOOP"},
+    {"MINMAX", "A MINMAX",
+     "0 A @ DUP LO ! HI ! %1$ld 1 DO I A @ DUP LO @ < IF DUP LO ! THEN DUP HI @ > IF DUP HI ! THEN DROP LOOP LO @ HI @"},
+    {"REVERSE", "A REVERSE", "%2$ld 0 DO I A @ %1$ld 1 - I - A @ I A ! %1$ld 1 - I - A ! LOOP"},
+    {"COPY", "B A COPY", "%1$ld 0 DO I B @ I A ! LOOP"},
+    {"MAP", "A MAP SQ", "%1$ld 0 DO I A @ SQ I A ! LOOP"},
+    {"REDUCE", "A REDUCE +", "0 A @ %1$ld 1 DO I A @ + LOOP"},
+};
+
+static void run(Session *s, const char *text) {
+    char *copy = strdup(text);
+    gmp_heap_begin_command();
+    vm_begin_command();
+    interpret(copy, &s->stack);
+    free(copy);
+    if (s->error_flag) {
+        fprintf(stderr, "error in: %s\n", text);
+        unit_failures++;
+        s->error_flag = 0;
+    }
+}
+
+static long long timed(Session *s, const char *text) {
+    long long start = now_us();
+    run(s, text);
+    return now_us() - start;
+}
+
+// Pile puis somme pondérée de A (sensible à l'ordre), vidées dans out
+static void snapshot(Session *s, char *out, size_t size) {
+    run(s, "A W DOT");
+    size_t used = 0;
+    out[0] = '\0';
+    while (s->stack.top >= 0 && used + 1 < size) {
+        used += gmp_snprintf(out + used, size - used, "%Zd ", s->stack.data[s->stack.top--]);
+    }
+}
+
+int main(int argc, char **argv) {
+    long n = argc > 1 ? atol(argv[1]) : 100000;
+    char text[512], before[4096], after[4096];
+    unit_init();
+    Session *s = session_create("bench");
+    session = s;
+    run(s, "VARIABLE LO DROP VARIABLE HI DROP CREATE A DROP CREATE B DROP CREATE W DROP");
+    run(s, ": SQ DUP * ;");
+    for (int cells = 0; cells < 2; cells++) {
+        const char *allot = cells ? "CELLS-ALLOT" : "ALLOT";
+        snprintf(text, sizeof(text), "A %ld %s B %ld %s W %ld %s", n, allot, n, allot, n, allot);
+        run(s, text);
+        snprintf(text, sizeof(text), ": INIT %ld 0 DO I 7919 * 10007 MOD 5000 - I A ! I 31 * 101 MOD I B ! I 1 + I W ! LOOP ;", n);
+        run(s, text);
+        printf("%-12s %-11s %10s %10s %8s\n", "word", "array", "native us", "loop us", "speedup");
+        for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+            char definition[512];
+            snprintf(definition, sizeof(definition), cases[i].loop, n, n / 2);
+            snprintf(text, sizeof(text), ": BENCH %s ;", definition);
+            run(s, text);
+            snprintf(text, sizeof(text), cases[i].native, n, n / 2);
+            run(s, "INIT");
+            long long native_us = timed(s, text);
+            snapshot(s, before, sizeof(before));
+            run(s, "INIT");
+            long long loop_us = timed(s, "BENCH");
+            snapshot(s, after, sizeof(after));
+            if (strcmp(before, after) != 0) {
+                fprintf(stderr, "%s: native gives %s, loop gives %s\n", cases[i].name, before, after);
+                unit_failures++;
+            }
+            printf("%-12s %-11s %10lld %10lld %7.1fx\n", cases[i].name, allot, native_us, loop_us,
+                   native_us > 0 ? (double)loop_us / native_us : 0.0);
+        }
+    }
+    session = &base_session;
+    session_destroy(s);
+    return unit_failures != 0;
+}
@@ -0,0 +1,151 @@
+// Rejeu d'une journée de commandes IRC : allocations GMP par commande, arène de commande et RSS, heure par heure.
+// gcc -O2 -o bench_replay tests/bench_replay.c -lgmp -lpthread && ./bench_replay [COMMANDES | FICHIER]
+// Sans fichier, un mélange déterministe de 200 pseudos (50000 commandes par défaut) ; un fichier donne une commande
+// par ligne, « pseudo commande ». Les commandes passent par l'ordonnanceur et un thread de travail, comme dans le bot.
+#include "unit.h"
+#include <malloc.h>
+
+#define REPLAY_NICKS 200
+#define REPLAY_HOURS 24
+
+typedef struct {
+    char nick[64];
+    char command[512];
+} ReplayLine;
+
+static unsigned long replay_seed = 12345;
+
+static unsigned long replay_rand(unsigned long n) {
+    replay_seed = replay_seed * 6364136223846793005UL + 1442695040888963407UL;
+    return (replay_seed >> 33) % n;
+}
+
+// Le mélange d'un canal : petits calculs surtout, définitions, boucles, variables, erreurs, quelques grands nombres
+static void replay_generate(ReplayLine *line, int *defined) {
+    int who = (int)replay_rand(REPLAY_NICKS);
+    snprintf(line->nick, sizeof(line->nick), "user%d", who);
+    if (!defined[who]) {
+        defined[who] = 1;
+        snprintf(line->command, sizeof(line->command),
+                 ": SQN 0 DO DUP * LOOP ; : SUMTO 0 SWAP 0 DO I + LOOP ; : POWN 1 SWAP 0 DO OVER * LOOP NIP ; "
+                 "VARIABLE V DROP CREATE A DROP A 64 ALLOT");
+        return;
+    }
+    unsigned long a = replay_rand(100000), b = replay_rand(1000) + 1, kind = replay_rand(100);
+    if (kind < 40) snprintf(line->command, sizeof(line->command), "%lu %lu + %lu * .", a, b, a % 97);
+    else if (kind < 50) snprintf(line->command, sizeof(line->command), ": SQ%lu DUP * %lu + ; %lu SQ%lu .", b % 8, a, b, b % 8);
+    else if (kind < 60) snprintf(line->command, sizeof(line->command), "%lu SUMTO .", b * 10);
+    else if (kind < 70) snprintf(line->command, sizeof(line->command), "%lu V ! V @ %lu MOD .", a, b);
+    else if (kind < 78) snprintf(line->command, sizeof(line->command), "%lu A FILL A SUM .", a);
+    else if (kind < 85) snprintf(line->command, sizeof(line->command), "%lu %lu POWN .", a, b % 5);
+    else if (kind < 88) snprintf(line->command, sizeof(line->command), "%lu 0 /", a);
+    else if (kind < 95) snprintf(line->command, sizeof(line->command), "%lu %lu SQN 1000000007 MOD .", b % 7 + 2, 10 + b % 8);
+    else if (kind < 99) snprintf(line->command, sizeof(line->command), "%lu %lu SQN DUP 3 SQN SWAP / 1000003 MOD .", b % 5 + 3, 12 + b % 4);
+    else snprintf(line->command, sizeof(line->command), "%lu 13 SQN .", b % 3 + 2); // Réponse de plusieurs Ko
+}
+
+static int replay_read(FILE *f, ReplayLine *line) {
+    char text[600];
+    while (fgets(text, sizeof(text), f)) {
+        text[strcspn(text, "\r\n")] = '\0';
+        char *space = strchr(text, ' ');
+        if (!space || space == text) continue;
+        snprintf(line->nick, sizeof(line->nick), "%.*s", (int)(space - text), text);
+        snprintf(line->command, sizeof(line->command), "%s", space + 1);
+        return 1;
+    }
+    return 0;
+}
+
+static void drain() {
+    char *batch;
+    while ((batch = mpsc_pop(&output_queue))) free(batch);
+}
+
+static void submit(const ReplayLine *line) {
+    PendingCommand *c = calloc(1, sizeof(PendingCommand));
+    snprintf(c->nick, sizeof(c->nick), "%s", line->nick);
+    snprintf(c->reply_to, sizeof(c->reply_to), "%s", line->nick);
+    snprintf(c->command, sizeof(c->command), "%s", line->command);
+    c->enqueued_us = now_us();
+    while (!scheduler_submit(c)) {
+        drain();
+        usleep(100);
+    }
+}
+
+static void wait_idle() {
+    while (1) {
+        drain();
+        pthread_mutex_lock(&scheduler.lock);
+        int idle = scheduler.queued == 0 && scheduler.running == 0;
+        pthread_mutex_unlock(&scheduler.lock);
+        if (idle) break;
+        usleep(100);
+    }
+    drain();
+}
+
+static long rss_kb() {
+    long pages = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%*s %ld", &pages) != 1) pages = 0;
+        fclose(statm);
+    }
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+int main(int argc, char **argv) {
+    long total = 50000;
+    FILE *file = NULL;
+    if (argc > 1 && atol(argv[1]) > 0) total = atol(argv[1]);
+    else if (argc > 1 && !(file = fopen(argv[1], "r"))) {
+        perror(argv[1]);
+        return 1;
+    }
+    ReplayLine *lines = malloc(sizeof(ReplayLine) * (file ? 1 : total));
+    long count = 0, capacity = 1;
+    if (file) {
+        ReplayLine line;
+        while (replay_read(file, &line)) {
+            if (count == capacity) lines = realloc(lines, sizeof(ReplayLine) * (capacity *= 2));
+            lines[count++] = line;
+        }
+        fclose(file);
+    } else {
+        int defined[REPLAY_NICKS] = {0};
+        for (count = 0; count < total; count++) replay_generate(&lines[count], defined);
+    }
+
+    unit_init();
+    init_result_cache();
+    init_scheduler();
+    init_latency();
+    scheduler.workers = 1;
+    pthread_t thread;
+    pthread_create(&thread, NULL, interpreter_worker, NULL);
+    pthread_detach(thread);
+
+    printf("%4s %8s %11s %14s %9s %7s %8s %8s %8s %8s\n", "hour", "commands", "heap allocs", "scratch allocs",
+           "GMP live", "arena", "scratch", "malloc", "RSS", "sessions");
+    printf("%4s %8s %11s %14s %9s %7s %8s %8s %8s\n", "", "", "/command", "/command", "KB", "KB", "KB", "KB", "KB");
+    long done = 0;
+    long long start = now_us();
+    for (int hour = 0; hour < REPLAY_HOURS; hour++) {
+        long end = count * (hour + 1) / REPLAY_HOURS;
+        unsigned long allocs = gmp_totals.allocs + gmp_totals.reallocs, scratch = gmp_totals.scratch_allocs;
+        for (; done < end; done++) submit(&lines[done]);
+        wait_idle();
+        long commands = end - count * hour / REPLAY_HOURS;
+        unsigned long scratch_allocs = gmp_totals.scratch_allocs - scratch;
+        unsigned long heap_allocs = gmp_totals.allocs + gmp_totals.reallocs - allocs - scratch_allocs;
+        printf("%4d %8ld %11.2f %14.2f %9zu %7zu %8zu %8zu %8ld %8ld\n", hour, commands,
+               commands ? (double)heap_allocs / commands : 0.0, commands ? (double)scratch_allocs / commands : 0.0,
+               (size_t)gmp_totals.live_bytes / 1024, (size_t)gmp_totals.arena_bytes / 1024,
+               (size_t)gmp_totals.scratch_bytes / 1024, mallinfo2().uordblks / 1024, rss_kb(), session_count);
+    }
+    printf("%ld commands in %.2f s, GMP peak %zu KB\n", count, (now_us() - start) / 1e6, (size_t)gmp_totals.peak_bytes / 1024);
+    free(lines);
+    return 0;
+}
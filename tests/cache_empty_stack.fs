@@ -0,0 +1,6 @@
+.
+5
+.
+.
+7 .
+7 .
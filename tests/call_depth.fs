@@ -0,0 +1,9 @@
+: R RECURSE ;
+R
+1 2 + .
+: DOWN DUP 0 > IF 1 - RECURSE THEN ;
+900 DOWN .
+5000 DOWN .
+.S
+: TWICE DOWN DOWN ;
+3 TWICE .
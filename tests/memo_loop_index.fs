@@ -0,0 +1,8 @@
+: IDX I ;
+MEMO
+: SHOW 3 0 DO IDX . LOOP ;
+SHOW
+: SQ DUP * ; MEMO
+: SQUARES 4 0 DO I SQ . LOOP ;
+SQUARES
+SQUARES
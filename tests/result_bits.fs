@@ -0,0 +1,5 @@
+1 90 LSHIFT DUP + .
+1 90 LSHIFT 1 90 LSHIFT - .
+1 98 LSHIFT DUP + .
+1 99 LSHIFT DUP + .
+1 60 LSHIFT DUP * .
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Tests de non-régression : chaque tests/NOM.fs passe par le transport stdio et sa sortie
+# est comparée à tests/NOM.expected ; tests/NOM.env (VAR=valeur par ligne) fixe l'environnement.
+# Les tests C (unit_*.c) incluent forth_bot.c et s'exécutent ensuite, puis bench_arrays.c sur de petits tableaux
+# vérifie que mots natifs et boucles DO donnent le même résultat ; enfin irc_bench fait passer
+# 50 pseudos par un serveur IRC local et exige une réponse sans erreur à chaque commande, puis
+# envoie des PING au bot pendant un calcul de 10 s et exige chaque PONG en moins de 100 ms.
+cd "$(dirname "$0")" || exit 1
+BIN=${TMPDIR:-/tmp}/forth_bot_test.$$
+trap 'kill $SERVER $BOT $PINGER 2>/dev/null; rm -f "$BIN" "$BIN".*' EXIT
+gcc -O2 -o "$BIN" ../forth_bot.c -lgmp -lpthread || exit 1
+failed=0
+for script in *.fs; do
+    name=${script%.fs}
+    vars=""
+    [ -f "$name.env" ] && vars=$(cat "$name.env")
+    env -i PATH="$PATH" FORTH_TRANSPORT=stdio FORTH_FLOOD_INTERVAL_MS=0 $vars timeout 60 "$BIN" < "$script" > "$BIN.out" 2>/dev/null
+    if diff -u "$name.expected" "$BIN.out"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name"
+        failed=1
+    fi
+done
+for unit in unit_*.c; do
+    [ -f "$unit" ] || continue
+    name=${unit%.c}
+    if gcc -O2 -o "$BIN.unit" "$unit" -lgmp -lpthread && "$BIN.unit"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name"
+        failed=1
+    fi
+done
+if gcc -O2 -o "$BIN.unit" bench_arrays.c -lgmp -lpthread && "$BIN.unit" 1000 > /dev/null; then
+    echo "ok   bench_arrays (native words and DO loops agree)"
+else
+    echo "FAIL bench_arrays"
+    failed=1
+fi
+PORT=$((20000 + $$ % 20000))
+if gcc -O2 -o "$BIN.bench" ../irc_bench.c; then
+    printf 'server test localhost %d\nchannel #test\n' "$PORT" > "$BIN.conf"
+    "$BIN.bench" server -p "$PORT" > /dev/null 2>&1 &
+    SERVER=$!
+    sleep 0.3
+    env -i PATH="$PATH" FORTH_CONFIG="$BIN.conf" FORTH_FLOOD_INTERVAL_MS=0 "$BIN" > /dev/null 2>&1 &
+    BOT=$!
+    sleep 1
+    if "$BIN.bench" load -p "$PORT" -u 50 -n 2000 > "$BIN.out" 2>&1 && grep -q ' 0 errors, 0 busy' "$BIN.out"; then
+        echo "ok   irc_load $(head -1 "$BIN.out")"
+    else
+        cat "$BIN.out"
+        echo "FAIL irc_load"
+        failed=1
+    fi
+    kill $BOT 2>/dev/null
+    PORT=$((PORT + 1))
+    printf 'server test localhost %d\n' "$PORT" > "$BIN.conf"
+    "$BIN.bench" ping -p "$PORT" -s 10 > "$BIN.ping" 2>&1 &
+    PINGER=$!
+    sleep 0.3
+    env -i PATH="$PATH" FORTH_CONFIG="$BIN.conf" FORTH_FLOOD_INTERVAL_MS=0 FORTH_MAX_MILLISECONDS=10000 \
+        FORTH_MAX_INSTRUCTIONS=0 "$BIN" > /dev/null 2>&1 &
+    BOT=$!
+    if wait $PINGER; then
+        echo "ok   irc_ping $(tail -1 "$BIN.ping")"
+    else
+        cat "$BIN.ping"
+        echo "FAIL irc_ping"
+        failed=1
+    fi
+else
+    failed=1
+fi
+exit $failed
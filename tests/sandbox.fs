@@ -0,0 +1,12 @@
+VARIABLE X
+DROP 5 X !
+1 2 : SQ DUP * ;
+3 SQ . X @ .
+GENERATOR COUNTER 0 BEGIN 1 WHILE DUP YIELD 1 + REPEAT ;
+COUNTER DUP NEXT DROP . DUP NEXT DROP .
+: BIG 3 BEGIN 1 WHILE DUP * REPEAT ;
+BIG
+.S
+9 RESULT 1 .
+9 KILL 1 .
+JOBS 4 SQ .
@@ -0,0 +1,28 @@
+// Tests C : forth_bot.c est inclus tel quel, son main renommé, pour appeler ses fonctions internes
+#define main forth_bot_main
+#include "../forth_bot.c"
+#undef main
+
+static int unit_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        unit_failures++; \
+    } \
+} while (0)
+
+// Le minimum de main() : tas GMP, quotas, budget, sessions et image de base avec BASE
+static void unit_init() {
+    init_gmp_heap();
+    init_quotas();
+    init_vm_budget();
+    init_sessions();
+    initStack(&base_session.stack);
+    init_mpz_pool();
+    char base_cmd[] = "VARIABLE BASE DROP";
+    interpret(base_cmd, &base_session.stack);
+    base_session.base_index = findMemoryIndex("BASE");
+    mpz_set_si(base_session.memory[base_session.base_index].values[0], 10);
+    mpsc_init(&output_queue);
+}
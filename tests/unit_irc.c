@@ -0,0 +1,143 @@
+#include "unit.h"
+
+// Transport factice : garde les lignes que recv_ring_lines lui passe
+static char *lines[16];
+static int line_count = 0;
+
+static void record_line(Network *net, int slot, char *line) {
+    (void)net;
+    (void)slot;
+    if (line_count < 16) lines[line_count++] = strdup(line);
+}
+
+static const Transport fake_transport = {.name = "fake", .line = record_line};
+static Network net = {.transport = &fake_transport};
+static int pipe_fd[2];
+
+static void forget_lines() {
+    for (int i = 0; i < line_count; i++) free(lines[i]);
+    line_count = 0;
+}
+
+// Écrit text dans le tube puis lit et découpe jusqu'à ce que tout soit passé par l'anneau
+static void feed(const char *text, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+        size_t chunk = len - done < 4096 ? len - done : 4096;
+        CHECK(write(pipe_fd[1], text + done, chunk) == (long)chunk);
+        done += chunk;
+        while (chunk > 0) {
+            long bytes = recv_ring_fill(&net.ring, pipe_fd[0]);
+            CHECK(bytes > 0);
+            if (bytes <= 0) return;
+            chunk -= bytes;
+            recv_ring_lines(&net.ring, &net, 0);
+        }
+    }
+}
+
+static void feed_text(const char *text) {
+    feed(text, strlen(text));
+}
+
+static int span_is(Span span, const char *text) {
+    return span.len == strlen(text) && memcmp(span.p, text, span.len) == 0;
+}
+
+static void test_parse() {
+    IrcMessage msg;
+    const char *line = "QUIT";
+    CHECK(irc_parse(line, strlen(line), &msg));
+    CHECK(span_is(msg.command, "QUIT") && msg.param_count == 0 && msg.nick.len == 0);
+
+    line = ":server.example 376   ";
+    CHECK(irc_parse(line, strlen(line), &msg));
+    CHECK(span_is(msg.nick, "server.example") && span_is(msg.command, "376") && msg.param_count == 0);
+
+    line = ":alice!al@host PRIVMSG #forth :";
+    CHECK(irc_parse(line, strlen(line), &msg));
+    CHECK(span_is(msg.nick, "alice") && span_is(msg.user, "al") && span_is(msg.host, "host"));
+    CHECK(msg.param_count == 2 && span_is(msg.params[0], "#forth") && msg.params[1].len == 0);
+
+    line = "@time=1;id=x :bob PRIVMSG #forth :1 2 + .";
+    CHECK(irc_parse(line, strlen(line), &msg));
+    CHECK(span_is(msg.tags, "time=1;id=x") && span_is(msg.nick, "bob"));
+    CHECK(msg.param_count == 2 && span_is(msg.params[1], "1 2 + ."));
+
+    // Au-delà de IRC_MAX_PARAMS, le dernier paramètre garde le reste de la ligne
+    char many[256] = "CMD";
+    for (int i = 0; i < IRC_MAX_PARAMS + 2; i++) strcat(many, " p");
+    CHECK(irc_parse(many, strlen(many), &msg));
+    CHECK(msg.param_count == IRC_MAX_PARAMS && span_is(msg.params[IRC_MAX_PARAMS - 1], "p p p"));
+
+    line = ":alice";
+    CHECK(!irc_parse(line, strlen(line), &msg));
+    line = "@tags-only";
+    CHECK(!irc_parse(line, strlen(line), &msg));
+    CHECK(!irc_parse("", 0, &msg));
+}
+
+static void test_ring() {
+    CHECK(pipe(pipe_fd) == 0);
+
+    // Ligne complète, lignes vides ignorées, CR retiré avant le LF seulement
+    feed_text("PING :a\r\n\r\n\nPING :b\rc\r\n");
+    CHECK(line_count == 2 && strcmp(lines[0], "PING :a") == 0 && strcmp(lines[1], "PING :b\rc") == 0);
+    forget_lines();
+
+    // Un CR sans LF ne termine pas la ligne : elle attend la lecture suivante
+    feed_text("PRIVMSG #forth :hi\r");
+    CHECK(line_count == 0);
+    feed_text("\n");
+    CHECK(line_count == 1 && strcmp(lines[0], "PRIVMSG #forth :hi") == 0);
+    forget_lines();
+
+    // Ligne à cheval sur la fin du tableau : recopiée d'un seul tenant
+    net.ring.head = net.ring.tail = net.ring.scan = 3 * IRC_RECV_SIZE - 5;
+    feed_text("PRIVMSG #forth :wrapped\r\n");
+    CHECK((net.ring.head & (IRC_RECV_SIZE - 1)) < 32);
+    CHECK(line_count == 1 && strcmp(lines[0], "PRIVMSG #forth :wrapped") == 0);
+    forget_lines();
+
+    // IRC_LINE_MAX octets passent, un de plus et la ligne est jetée jusqu'au LF ; la suivante passe
+    char *longest = malloc(IRC_LINE_MAX + 2);
+    memset(longest, 'x', IRC_LINE_MAX);
+    longest[IRC_LINE_MAX] = '\n';
+    feed(longest, IRC_LINE_MAX + 1);
+    CHECK(line_count == 1 && strlen(lines[0]) == IRC_LINE_MAX);
+    forget_lines();
+    feed(longest, IRC_LINE_MAX);
+    feed_text("yyyy");
+    CHECK(net.ring.overlong && line_count == 0);
+    feed_text("zz\nPING :after\r\n");
+    CHECK(!net.ring.overlong && line_count == 1 && strcmp(lines[0], "PING :after") == 0);
+    forget_lines();
+    free(longest);
+
+    // Trois fois la taille de l'anneau sans LF : jamais plein, toujours jeté
+    char block[4096];
+    memset(block, 'y', sizeof(block));
+    for (int i = 0; i < 3 * IRC_RECV_SIZE / (int)sizeof(block); i++) feed(block, sizeof(block));
+    feed_text("\nPING :still\r\n");
+    CHECK(line_count == 1 && strcmp(lines[0], "PING :still") == 0);
+    forget_lines();
+
+    // Transport à sa limite de commandes : les lignes restent dans l'anneau
+    net.max_commands = 1;
+    net.commands = 1;
+    feed_text("PING :held\r\n");
+    CHECK(line_count == 0);
+    net.commands = 0;
+    recv_ring_lines(&net.ring, &net, 0);
+    CHECK(line_count == 1 && strcmp(lines[0], "PING :held") == 0);
+    forget_lines();
+
+    close(pipe_fd[0]);
+    close(pipe_fd[1]);
+}
+
+int main() {
+    test_parse();
+    test_ring();
+    return unit_failures != 0;
+}
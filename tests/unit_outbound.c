@@ -0,0 +1,97 @@
+#include "unit.h"
+
+// Seau anti-flood sur une paire de sockets : ce que le serveur recevrait
+static int peer;
+
+// Lignes arrivées depuis le dernier appel, dans buffer
+static int received(char *buffer, size_t size) {
+    size_t used = 0;
+    long bytes;
+    while (used + 1 < size && (bytes = recv(peer, buffer + used, size - 1 - used, MSG_DONTWAIT)) > 0) used += bytes;
+    buffer[used] = '\0';
+    int lines = 0;
+    for (char *p = buffer; (p = strstr(p, "\r\n")); p += 2) lines++;
+    return lines;
+}
+
+static void push_line(Network *net, int lane, const char *text) {
+    outbound_push(net, lane, text, strlen(text));
+}
+
+static void config(const char *text) {
+    char path[] = "/tmp/forth_unit_outbound_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0 && write(fd, text, strlen(text)) == (long)strlen(text));
+    close(fd);
+    setenv("FORTH_CONFIG", path, 1);
+    init_networks();
+    unlink(path);
+}
+
+int main() {
+    char buffer[8192];
+    unit_init();
+
+    // « flood 0 0 » : accepté, sans limite ; une rafale nulle avec un intervalle est refusée
+    config("server test localhost 6667\nchannel #t\nflood 0 0\n");
+    CHECK(flood.burst == 0 && flood.interval_ms == 0);
+    config("flood 0 500\n");
+    CHECK(flood.burst == 0 && flood.interval_ms == 0);
+
+    Network *net = &networks[0];
+    int pair[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0);
+    net->sock = pair[0];
+    peer = pair[1];
+    for (int i = 0; i < 200; i++) push_line(net, OUTPUT_BULK, "PRIVMSG #t :line\r\n");
+    outbound_send(net); // Plusieurs writev dans le même appel
+    CHECK(received(buffer, sizeof(buffer)) == 101); // FORTH_OUTPUT_BACKLOG par défaut, le reste résumé
+    CHECK(strstr(buffer, "PRIVMSG #t :line\r\nPRIVMSG #t :... 100 lines suppressed\r\n"));
+
+    // Rafale de 3, puis un jeton toutes les 200 ms
+    flood.burst = 3;
+    flood.interval_ms = 200;
+    net->out.tokens = flood.burst;
+    net->out.refill_us = now_us();
+    for (int i = 0; i < 6; i++) push_line(net, OUTPUT_BULK, "PRIVMSG #t :bulk\r\n");
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 3);
+    int wait = outbound_timeout_ms(net);
+    CHECK(wait > 150 && wait <= 201);
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 0);
+    usleep(250000);
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 1);
+
+    // La voie prioritaire double les deux lignes de volume encore en attente
+    push_line(net, OUTPUT_PRIORITY, "PONG :server\r\n");
+    usleep(200000);
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 1 && strcmp(buffer, "PONG :server\r\n") == 0);
+    usleep(450000);
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 2 && strncmp(buffer, "PRIVMSG #t :bulk\r\n", 18) == 0);
+    CHECK(outbound_timeout_ms(net) == -1);
+
+    // Seau plein après une longue pause : jamais plus que la rafale
+    usleep(1000000);
+    for (int i = 0; i < 5; i++) push_line(net, OUTPUT_BULK, "PRIVMSG #t :again\r\n");
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 3);
+
+    // File pleine : les lignes de trop sont comptées, résumées une fois la file vidée, vers leur dernière cible
+    flood.backlog = 4;
+    for (int i = 0; i < 4; i++) push_line(net, OUTPUT_BULK, "PRIVMSG alice :more\r\n");
+    CHECK(net->out.count[OUTPUT_BULK] == 4 && net->out.suppressed == 2);
+    flood.interval_ms = 0;
+    outbound_send(net);
+    CHECK(received(buffer, sizeof(buffer)) == 5);
+    const char *summary = "PRIVMSG alice :more\r\nPRIVMSG alice :... 2 lines suppressed\r\n";
+    CHECK(strlen(buffer) > strlen(summary) && strcmp(buffer + strlen(buffer) - strlen(summary), summary) == 0);
+    CHECK(net->out.suppressed == 0 && net->out.suppressed_total == 102);
+
+    close(pair[0]);
+    close(pair[1]);
+    return unit_failures != 0;
+}
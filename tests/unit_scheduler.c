@@ -0,0 +1,152 @@
+#include "unit.h"
+
+// Ordonnanceur sous charge : vrais threads de travail, 50 pseudos, réponses relevées dans output_queue
+#define NICKS 50
+#define MAX_REPLIES 2048
+
+typedef struct {
+    char nick[64];
+    long value;
+} Reply;
+
+static Reply replies[MAX_REPLIES];
+static int reply_count;
+static int heavy_seen;              // Plus grand nombre de sessions lourdes lancées ensemble
+
+// Un lot de output_queue : une réponse par ligne, cible = pseudo
+static int drain_once() {
+    pthread_mutex_lock(&scheduler.lock);
+    if (scheduler.heavy_running > heavy_seen) heavy_seen = scheduler.heavy_running;
+    pthread_mutex_unlock(&scheduler.lock);
+    char *batch = mpsc_pop(&output_queue);
+    if (!batch) return 0;
+    Span target, text;
+    for (const char *p = batch + 2; batch_line(&p, &target, &text);) {
+        if (reply_count == MAX_REPLIES) break;
+        Reply *r = &replies[reply_count++];
+        snprintf(r->nick, sizeof(r->nick), "%.*s", (int)target.len, target.p);
+        r->value = strtol(text.p, NULL, 10);
+    }
+    free(batch);
+    return 1;
+}
+
+static void collect(int count) {
+    long long deadline = now_us() + 60 * 1000000LL;
+    while (reply_count < count && now_us() < deadline) {
+        if (!drain_once()) usleep(200);
+    }
+}
+
+static void submit(const char *nick, const char *command) {
+    PendingCommand *c = calloc(1, sizeof(PendingCommand));
+    snprintf(c->nick, sizeof(c->nick), "%s", nick);
+    snprintf(c->reply_to, sizeof(c->reply_to), "%s", nick);
+    snprintf(c->command, sizeof(c->command), "%s", command);
+    while (!scheduler_submit(c)) { // MAX_QUEUED_COMMANDS atteint : les workers doivent pouvoir publier
+        if (!drain_once()) usleep(200);
+    }
+}
+
+static void start_workers(int count) {
+    for (int i = 0; i < count; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, interpreter_worker, NULL);
+        pthread_detach(thread);
+    }
+    scheduler.workers += count;
+}
+
+static int index_of(const char *nick, int nth) {
+    for (int i = 0; i < reply_count; i++) {
+        if (strcmp(replies[i].nick, nick) == 0 && nth-- == 0) return i;
+    }
+    return -1;
+}
+
+// Un pseudo qui remplit la file ne passe qu'une commande par tour : les 49 autres passent avant sa deuxième
+static void round_robin() {
+    char nick[16], command[32];
+    for (int i = 0; i < 30; i++) {
+        snprintf(command, sizeof(command), "%d .", i);
+        submit("hog", command);
+    }
+    for (int n = 1; n < NICKS; n++) {
+        snprintf(nick, sizeof(nick), "light%d", n);
+        submit(nick, "7 .");
+    }
+    start_workers(1);
+    collect(30 + NICKS - 1);
+    CHECK(reply_count == 30 + NICKS - 1);
+    int second = index_of("hog", 1);
+    for (int n = 1; n < NICKS; n++) {
+        snprintf(nick, sizeof(nick), "light%d", n);
+        int light = index_of(nick, 0);
+        CHECK(light >= 0 && light < second);
+    }
+    for (int i = 0; i < 30; i++) CHECK(replies[index_of("hog", i)].value == i); // FIFO par pseudo
+}
+
+// 50 pseudos, 20 commandes chacun, 4 workers : tout est exécuté, dans l'ordre de chaque pseudo
+static void load() {
+    reply_count = 0;
+    start_workers(3);
+    char nick[16], command[32];
+    for (int i = 0; i < 20; i++) {
+        for (int n = 0; n < NICKS; n++) {
+            snprintf(nick, sizeof(nick), "user%d", n);
+            snprintf(command, sizeof(command), "%d %d * .", n, i);
+            submit(nick, command);
+        }
+    }
+    collect(20 * NICKS);
+    CHECK(reply_count == 20 * NICKS);
+    for (int n = 0; n < NICKS; n++) {
+        snprintf(nick, sizeof(nick), "user%d", n);
+        for (int i = 0; i < 20; i++) {
+            int at = index_of(nick, i);
+            CHECK(at >= 0 && replies[at].value == (long)n * i);
+        }
+    }
+}
+
+// Sessions lourdes limitées à max_heavy : les pseudos légers gardent un worker et finissent avant elles
+static void heavy_limit() {
+    reply_count = 0;
+    heavy_seen = 0;
+    pthread_mutex_lock(&scheduler.lock);
+    scheduler.max_heavy = 1;
+    scheduler.heavy_ms = 20;
+    pthread_mutex_unlock(&scheduler.lock);
+    const char *spin = ": SPIN 0 2000000 0 DO 1 + LOOP ; SPIN .";
+    for (int i = 0; i < 4; i++) {
+        submit("heavyA", spin);
+        submit("heavyB", spin);
+    }
+    usleep(50 * 1000); // Les premières commandes lourdes tournent et marquent leurs sessions
+    char nick[16];
+    for (int i = 0; i < 10; i++) {
+        for (int n = 0; n < 5; n++) {
+            snprintf(nick, sizeof(nick), "quick%d", n);
+            submit(nick, "5 .");
+        }
+    }
+    collect(8 + 50);
+    CHECK(reply_count == 8 + 50);
+    CHECK(heavy_seen <= 1);
+    int last_heavy = index_of("heavyA", 3) > index_of("heavyB", 3) ? index_of("heavyA", 3) : index_of("heavyB", 3);
+    for (int n = 0; n < 5; n++) {
+        snprintf(nick, sizeof(nick), "quick%d", n);
+        CHECK(index_of(nick, 9) >= 0 && index_of(nick, 9) < last_heavy);
+    }
+}
+
+int main() {
+    unit_init();
+    init_scheduler();
+    scheduler.workers = 0;
+    round_robin();
+    load();
+    heavy_limit();
+    return unit_failures != 0;
+}
@@ -0,0 +1,65 @@
+#include "unit.h"
+
+// interpret découpe son texte : une copie par appel
+static void run(Session *s, const char *text) {
+    char *copy = strdup(text);
+    interpret(copy, &s->stack);
+    free(copy);
+}
+
+static char *save_state(Session *s, size_t *size) {
+    char *state = NULL;
+    FILE *f = open_memstream(&state, size);
+    session_save(f, s);
+    fclose(f);
+    return state;
+}
+
+static int load_state(Session *s, char *state, size_t size) {
+    FILE *f = fmemopen(state, size, "r");
+    int ok = session_load(f, s);
+    fclose(f);
+    return ok;
+}
+
+int main() {
+    unit_init();
+    Session *s = session_create("alice");
+    session = s;
+    run(s, "VARIABLE X");
+    run(s, "DROP");
+    run(s, "42 X !");
+    run(s, "1 2 3 : SQ DUP * ;");
+    CHECK(!s->error_flag);
+    long int sq = findCompiledWordIndex("SQ");
+    CHECK(sq >= 0);
+
+    size_t size;
+    char *state = save_state(s, &size);
+
+    // État renvoyé par l'enfant : il remplace celui de la session
+    run(s, "DROP DROP 7 X ! : SQ DUP DUP * * ;");
+    CHECK(s->stack.top == 0);
+    CHECK(load_state(s, state, size));
+    CHECK(s->stack.top == 2 && mpz_cmp_ui(s->stack.data[2], 3) == 0);
+    CHECK(mpz_cmp_ui(s->memory[findMemoryIndex("X")].values[0], 42) == 0);
+    CHECK(s->dictionary[sq] && s->dictionary[sq]->code_length == 3);
+
+    // Flux tronqué à chaque longueur possible : la session n'est jamais touchée
+    run(s, "DROP DROP 7 X ! : SQ DUP DUP * * ;");
+    unsigned long version = s->dict_version;
+    int rejected = 1;
+    for (size_t cut = 0; cut < size; cut++) rejected &= !load_state(s, state, cut);
+    CHECK(rejected);
+    CHECK(s->stack.top == 0 && mpz_cmp_ui(s->stack.data[0], 1) == 0);
+    CHECK(mpz_cmp_ui(s->memory[findMemoryIndex("X")].values[0], 7) == 0);
+    CHECK(s->dictionary[sq] && s->dictionary[sq]->code_length == 5);
+    CHECK(s->dict_version == version);
+    CHECK(load_state(s, state, size));
+    CHECK(s->stack.top == 2);
+    free(state);
+
+    session = &base_session;
+    session_destroy(s);
+    return unit_failures != 0;
+}